@@ -0,0 +1,637 @@
+/*
+ *  benchmark       microbenchmarks for VAST core data paths, results are written as JSON
+ *
+ *  usage:  benchmark [output file] [name filter] [-quick]
+ *          results go to stdout if no output file (or "-") is given
+ *          only benchmarks whose names contain the filter are run
+ *          -quick runs smaller sizes & fewer repeats (for a fast sanity check)
+ *
+ *  every benchmark is run once to warm up, then BENCH_REPEATS times,
+ *  the median, min & max time per operation (in nanoseconds) are reported.
+ *  all inputs come from fixed seeds, so runs on the same build are comparable.
+ *
+ *  version:    2026/10/19  init
+ */
+
+#ifdef WIN32
+// disable warning about "unsafe functions"
+#pragma warning(disable: 4996)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "VASTTypes.h"
+#include "VASTBuffer.h"
+#include "VASTUtil.h"
+#include "VoronoiSF.h"
+#include "VASTVerse.h"
+#include "net_emu.h"
+
+using namespace Vast;
+using namespace std;
+
+#define BENCH_REPEATS           (5)         // # of measured runs for each benchmark
+#define BENCH_WORLD_SIZE        (1000)      // size of the world for positions
+#define BENCH_AOI_RADIUS        (100)       // AOI radius of subscribers
+#define BENCH_MATCHER_STEPS     (50)        // # of steps measured for matcher benchmarks
+#define BENCH_JOIN_STEPS        (500)       // max # of steps to wait for a client to join
+
+// result of one benchmark
+struct BenchResult
+{
+    string  name;
+    int     param;          // size parameter (# of sites, bytes, subscribers...)
+    size_t  ops;            // # of operations per run
+    double  median_ns;      // time per operation
+    double  min_ns;
+    double  max_ns;
+};
+
+// a benchmark run performs a number of operations and returns the time used (in microseconds)
+// 'ops' is set to the # of operations performed
+typedef unsigned long long (*BenchFunc) (int param, size_t &ops);
+
+vector<BenchResult> g_results;
+const char *        g_filter  = NULL;
+int                 g_repeats = BENCH_REPEATS;
+
+//
+//  helpers
+//
+
+// deterministic random numbers, restarted for each run
+static RandomGenerator g_random;
+
+Position randomPosition ()
+{
+    return Position ((coord_t)(g_random.next () % BENCH_WORLD_SIZE), (coord_t)(g_random.next () % BENCH_WORLD_SIZE));
+}
+
+unsigned long long now ()
+{
+    return TimeMonitor::instance ()->getTime ();
+}
+
+// run a benchmark (if it passes the filter) and record its result
+void runBenchmark (const char *name, int param, BenchFunc func)
+{
+    if (g_filter != NULL && strstr (name, g_filter) == NULL)
+        return;
+
+    fprintf (stderr, "running %s (%d)...\n", name, param);
+
+    size_t ops = 0;
+
+    // warm up
+    g_random.setSeed (37);
+    func (param, ops);
+
+    vector<double> times;
+    for (int i=0; i < g_repeats; i++)
+    {
+        g_random.setSeed (37);
+        unsigned long long elapsed = func (param, ops);
+        times.push_back (ops > 0 ? (double)elapsed * 1000.0 / ops : 0);
+    }
+
+    sort (times.begin (), times.end ());
+
+    BenchResult result;
+    result.name      = name;
+    result.param     = param;
+    result.ops       = ops;
+    result.median_ns = times[times.size () / 2];
+    result.min_ns    = times.front ();
+    result.max_ns    = times.back ();
+
+    g_results.push_back (result);
+}
+
+//
+//  Message
+//
+
+// store a few typical fields & extract them again
+unsigned long long benchMessageStoreExtract (int param, size_t &ops)
+{
+    Message msg (1);
+    Area    aoi (randomPosition (), BENCH_AOI_RADIUS);
+    Position pos = randomPosition ();
+    Vast::id_t id = 12345;
+    float    value = 1.5f;
+
+    ops = (size_t)param;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+    {
+        msg.clear (1);
+        msg.store (id);
+        msg.store (pos);
+        msg.store (aoi);
+        msg.store (value);
+
+        msg.reset ();
+        msg.extract (id);
+        msg.extract (pos);
+        msg.extract (aoi);
+        msg.extract (value);
+    }
+    return now () - start;
+}
+
+// prepare a message with 'size' bytes of content & a few targets
+void prepareMessage (Message &msg, int size)
+{
+    vector<char> content (size, 'x');
+
+    msg.clear (1);
+    msg.store (&content[0], (vsize_t)size);
+    msg.addTarget (1);
+    msg.addTarget (2);
+    msg.addTarget (3);
+}
+
+unsigned long long benchMessageSerialize (int param, size_t &ops)
+{
+    Message msg (1);
+    prepareMessage (msg, param);
+
+    vector<char> buf (msg.serialize (NULL));
+
+    ops = 100000;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+        msg.serialize (&buf[0]);
+    return now () - start;
+}
+
+unsigned long long benchMessageDeserialize (int param, size_t &ops)
+{
+    Message msg (1);
+    prepareMessage (msg, param);
+
+    vector<char> buf (msg.serialize (NULL));
+    msg.serialize (&buf[0]);
+
+    Message restored (0);
+
+    ops = 100000;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+        restored.deserialize (&buf[0], buf.size ());
+    return now () - start;
+}
+
+//
+//  VASTBuffer
+//
+
+// grow a new buffer to 'param' bytes in 64-byte pieces
+unsigned long long benchBufferGrowth (int param, size_t &ops)
+{
+    char piece[64];
+    memset (piece, 'x', 64);
+
+    ops = (size_t)param / 64;
+
+    unsigned long long start = now ();
+
+    VASTBuffer *buf = new VASTBuffer ();
+    for (size_t i=0; i < ops; i++)
+        buf->add (piece, 64);
+    delete buf;
+
+    return now () - start;
+}
+
+//
+//  VoronoiSF
+//
+
+void buildVoronoi (VoronoiSF &voronoi, int sites)
+{
+    for (int i=1; i <= sites; i++)
+        voronoi.insert ((Vast::id_t)i, randomPosition ());
+}
+
+// insert sites & compute the diagram once, time is per site
+unsigned long long benchVoronoiInsert (int param, size_t &ops)
+{
+    ops = (size_t)param;
+
+    unsigned long long start = now ();
+
+    VoronoiSF voronoi;
+    buildVoronoi (voronoi, param);
+    voronoi.contains (1, voronoi.get (1));
+
+    return now () - start;
+}
+
+// move a site and query, which recomputes the diagram
+unsigned long long benchVoronoiUpdate (int param, size_t &ops)
+{
+    VoronoiSF voronoi;
+    buildVoronoi (voronoi, param);
+    voronoi.contains (1, voronoi.get (1));
+
+    ops = 100;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+    {
+        Vast::id_t id = (Vast::id_t)(g_random.next () % param + 1);
+        Position pos = randomPosition ();
+        voronoi.update (id, pos);
+        voronoi.contains (id, pos);
+    }
+    return now () - start;
+}
+
+unsigned long long benchVoronoiContains (int param, size_t &ops)
+{
+    VoronoiSF voronoi;
+    buildVoronoi (voronoi, param);
+    voronoi.contains (1, voronoi.get (1));
+
+    ops = 10000;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+        voronoi.contains ((Vast::id_t)(g_random.next () % param + 1), randomPosition ());
+    return now () - start;
+}
+
+unsigned long long benchVoronoiEnclosing (int param, size_t &ops)
+{
+    VoronoiSF voronoi;
+    buildVoronoi (voronoi, param);
+    voronoi.contains (1, voronoi.get (1));
+
+    ops = 10000;
+
+    unsigned long long start = now ();
+    for (size_t i=0; i < ops; i++)
+        voronoi.get_en ((Vast::id_t)(g_random.next () % param + 1));
+    return now () - start;
+}
+
+//
+//  net_emu
+//
+
+// send a batch of 'param' 128-byte messages between two emulated hosts & receive them
+unsigned long long benchNetEmuDelivery (int param, size_t &ops)
+{
+    net_emu *sender   = new net_emu (10);
+    net_emu *receiver = new net_emu (10);
+
+    sender->start ();
+    receiver->start ();
+    sender->setID (sender->getAddress ().host_id);
+    receiver->setID (receiver->getAddress ().host_id);
+
+    Vast::id_t target = receiver->getID ();
+    sender->connect (target, receiver->getAddress ().publicIP.host, receiver->getAddress ().publicIP.port);
+
+    char msg[128];
+    memset (msg, 'x', 128);
+
+    ops = (size_t)param * 10;
+
+    unsigned long long start = now ();
+    for (int round = 0; round < 10; round++)
+    {
+        for (int i=0; i < param; i++)
+            sender->send (target, msg, 128);
+
+        // messages arrive one step later, and are received only after that step has passed
+        sender->tickLogicalClock ();
+        sender->tickLogicalClock ();
+
+        while (receiver->receive () != NULL)
+            ;
+    }
+    unsigned long long elapsed = now () - start;
+
+    sender->stop ();
+    receiver->stop ();
+    delete sender;
+    delete receiver;
+
+    return elapsed;
+}
+
+//
+//  VASTMatcher (a gateway matcher with clients over the emulated network)
+//
+
+class MatcherWorld
+{
+public:
+    MatcherWorld ()
+        : _ready (false)
+    {
+    }
+
+    ~MatcherWorld ()
+    {
+        clear ();
+    }
+
+    // create a gateway (relay & matcher) and 'clients' subscribers, returns false if some could not join
+    bool create (int clients)
+    {
+        clear ();
+
+        VASTPara_Sim simpara;
+        memset (&simpara, 0, sizeof (VASTPara_Sim));
+        simpara.step_persec = 10;
+
+        VASTPara_Net netpara (VAST_NET_EMULATED);
+        netpara.port = GATEWAY_DEFAULT_PORT;
+        netpara.overload_limit = 0;             // keep all subscribers at the gateway
+
+        char GWstr[80];
+        sprintf (GWstr, "127.0.0.1:%d", GATEWAY_DEFAULT_PORT);
+
+        for (int i=0; i <= clients; i++)
+        {
+            Area aoi (randomPosition (), BENCH_AOI_RADIUS);
+
+            netpara.is_relay   = (i == 0);
+            netpara.is_matcher = (i == 0);
+            netpara.phys_coord = aoi.center;
+
+            VASTVerse *world = new VASTVerse (i == 0, GWstr, &netpara, &simpara);
+            world->createVASTNode (VAST_DEFAULT_WORLD_ID, aoi, 1);
+
+            _worlds.push_back (world);
+            _nodes.push_back (NULL);
+            _aois.push_back (aoi);
+
+            // wait for the new node to join before creating the next
+            int steps = 0;
+            while (_nodes[i] == NULL && steps++ < BENCH_JOIN_STEPS)
+            {
+                step (false);
+
+                VAST *node = world->getVASTNode ();
+                if (node != NULL && node->getSubscriptionID () != NET_ID_UNASSIGNED)
+                    _nodes[i] = node;
+            }
+
+            if (_nodes[i] == NULL)
+            {
+                fprintf (stderr, "MatcherWorld: node %d cannot join\n", i);
+                return false;
+            }
+        }
+
+        _ready = true;
+        return true;
+    }
+
+    // move all subscribers (and let some publish), then tick all hosts
+    void step (bool active)
+    {
+        if (active)
+        {
+            for (size_t i=1; i < _nodes.size (); i++)
+            {
+                Area &aoi = _aois[i];
+                aoi.center.x += (coord_t)((int)(g_random.next () % 11) - 5);
+                aoi.center.y += (coord_t)((int)(g_random.next () % 11) - 5);
+                _nodes[i]->move (_nodes[i]->getSubscriptionID (), aoi);
+
+                // one in ten subscribers publishes each step
+                if (g_random.next () % 10 == 0)
+                {
+                    Message msg (1);
+                    msg.store ((Vast::id_t)i);
+                    Area area (aoi.center, 0);
+                    _nodes[i]->publish (area, 1, msg);
+                }
+
+                // discard what is received
+                while (_nodes[i]->receive () != NULL)
+                    ;
+            }
+        }
+
+        for (size_t i=0; i < _worlds.size (); i++)
+            _worlds[i]->tick ();
+
+        _worlds[0]->tickLogicalClock ();
+    }
+
+    Profiler *getGatewayProfiler ()
+    {
+        return _worlds[0]->getProfiler ();
+    }
+
+    bool isReady ()
+    {
+        return _ready;
+    }
+
+    void clear ()
+    {
+        for (size_t i=_worlds.size (); i > 0; i--)
+        {
+            if (_nodes[i-1] != NULL)
+                _nodes[i-1]->leave ();
+            _worlds[i-1]->destroyVASTNode (_nodes[i-1]);
+            delete _worlds[i-1];
+        }
+        _worlds.clear ();
+        _nodes.clear ();
+        _aois.clear ();
+        _ready = false;
+    }
+
+private:
+    vector<VASTVerse *> _worlds;        // index 0 is the gateway
+    vector<VAST *>      _nodes;
+    vector<Area>        _aois;
+    bool                _ready;
+};
+
+MatcherWorld    g_matcher_world;
+int             g_matcher_clients = 0;
+
+// run the matcher world for BENCH_MATCHER_STEPS steps with profiling on
+// returns the matcher's PUBLISH handling time & count, and postHandling time & count
+bool runMatcherWorld (int clients, unsigned long long &publish_time, size_t &publish_count, unsigned long long &refresh_time, size_t &refresh_count)
+{
+    // the world is kept between runs of the same size
+    if (g_matcher_world.isReady () == false || g_matcher_clients != clients)
+    {
+        g_matcher_clients = clients;
+        if (g_matcher_world.create (clients) == false)
+            return false;
+
+        // let neighbor lists settle
+        for (int i=0; i < 20; i++)
+            g_matcher_world.step (true);
+    }
+
+    Profiler *profiler = g_matcher_world.getGatewayProfiler ();
+    profiler->reset ();
+    profiler->setEnabled (true);
+
+    for (int i=0; i < BENCH_MATCHER_STEPS; i++)
+        g_matcher_world.step (true);
+
+    profiler->setEnabled (false);
+
+    publish_time = refresh_time = 0;
+    publish_count = refresh_count = 0;
+
+    Vast::id_t group;
+    msgtype_t msgtype;
+    ProfileStat stat, handle, post;
+
+    for (int i=0; i < profiler->getMessageTypeSize (); i++)
+    {
+        if (profiler->getMessageTypeStat (i, group, msgtype, stat) &&
+            group == MSG_GROUP_VAST_MATCHER && VAST_MSGTYPE (msgtype) == PUBLISH)
+        {
+            publish_time  += stat.getTotal ();
+            publish_count += (size_t)stat.getCount ();
+        }
+    }
+
+    for (int i=0; i < profiler->getHandlerSize (); i++)
+    {
+        if (profiler->getHandlerStat (i, group, handle, post) && group == MSG_GROUP_VAST_MATCHER)
+        {
+            refresh_time  = post.getTotal ();
+            refresh_count = (size_t)post.getCount ();
+        }
+    }
+
+    return true;
+}
+
+// time to match one publication against all subscribers
+unsigned long long benchMatcherPublish (int param, size_t &ops)
+{
+    unsigned long long publish_time, refresh_time;
+    size_t refresh_count;
+
+    ops = 0;
+    if (runMatcherWorld (param, publish_time, ops, refresh_time, refresh_count) == false)
+        return 0;
+
+    return publish_time;
+}
+
+// time of one matcher postHandling (neighbor refresh & client notification for all subscribers)
+unsigned long long benchMatcherRefresh (int param, size_t &ops)
+{
+    unsigned long long publish_time, refresh_time;
+    size_t publish_count;
+
+    ops = 0;
+    if (runMatcherWorld (param, publish_time, publish_count, refresh_time, ops) == false)
+        return 0;
+
+    return refresh_time;
+}
+
+//
+//  output
+//
+
+void writeResults (FILE *fp)
+{
+    fprintf (fp, "{\n  \"suite\": \"vast_core\",\n  \"repeats\": %d,\n  \"results\": [\n", g_repeats);
+
+    for (size_t i=0; i < g_results.size (); i++)
+    {
+        BenchResult &r = g_results[i];
+        fprintf (fp, "    {\"name\": \"%s\", \"param\": %d, \"ops\": %lu, \"median_ns\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+                 r.name.c_str (), r.param, (unsigned long)r.ops, r.median_ns, r.min_ns, r.max_ns,
+                 (i + 1 < g_results.size () ? "," : ""));
+    }
+
+    fprintf (fp, "  ]\n}\n");
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL;
+    bool quick = false;
+
+    for (int i=1; i < argc; i++)
+    {
+        if (strcmp (argv[i], "-quick") == 0)
+            quick = true;
+        else if (output == NULL)
+            output = argv[i];
+        else
+            g_filter = argv[i];
+    }
+
+    if (quick)
+        g_repeats = 1;
+
+    // suppress LogManager output to screen where possible
+    LogManager::instance ()->setLogLevel (LOG_LEVEL_WARNING);
+
+    runBenchmark ("message_store_extract", 100000, benchMessageStoreExtract);
+
+    int msg_sizes[] = {64, 1024, 8192};
+    for (int i=0; i < 3; i++)
+        runBenchmark ("message_serialize", msg_sizes[i], benchMessageSerialize);
+    for (int i=0; i < 3; i++)
+        runBenchmark ("message_deserialize", msg_sizes[i], benchMessageDeserialize);
+
+    int buf_sizes[] = {65536, 1048576, 4194304};
+    for (int i=0; i < (quick ? 2 : 3); i++)
+        runBenchmark ("vastbuffer_growth", buf_sizes[i], benchBufferGrowth);
+
+    int sites[] = {10, 100, 1000};
+    for (int i=0; i < (quick ? 2 : 3); i++)
+    {
+        runBenchmark ("voronoi_insert", sites[i], benchVoronoiInsert);
+        runBenchmark ("voronoi_update_contains", sites[i], benchVoronoiUpdate);
+        runBenchmark ("voronoi_contains", sites[i], benchVoronoiContains);
+        runBenchmark ("voronoi_get_en", sites[i], benchVoronoiEnclosing);
+    }
+
+    int batches[] = {10, 100, 1000};
+    for (int i=0; i < 3; i++)
+        runBenchmark ("net_emu_delivery", batches[i], benchNetEmuDelivery);
+
+    int subscribers[] = {20, 100, 400};
+    for (int i=0; i < (quick ? 1 : 3); i++)
+    {
+        runBenchmark ("matcher_publish", subscribers[i], benchMatcherPublish);
+        runBenchmark ("matcher_refresh", subscribers[i], benchMatcherRefresh);
+    }
+    g_matcher_world.clear ();
+
+    FILE *fp = stdout;
+    if (output != NULL && strcmp (output, "-") != 0 && (fp = fopen (output, "wt")) == NULL)
+    {
+        fprintf (stderr, "cannot open output file '%s'\n", output);
+        return 1;
+    }
+
+    writeResults (fp);
+
+    if (fp != stdout)
+        fclose (fp);
+
+    return 0;
+}
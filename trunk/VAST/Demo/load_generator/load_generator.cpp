@@ -0,0 +1,605 @@
+/*
+ *  load_generator  headless load generator that runs many VAST nodes in one process,
+ *                  replays a recorded movement trace and a publish workload,
+ *                  and reports throughput, per-node CPU & latency percentiles as JSON
+ *
+ *  usage:  load_generator [options] [output file]
+ *          results go to stdout if no output file (or "-") is given
+ *          defaults are taken from VASTsim.ini (if found in the working directory)
+ *
+ *      -nodes N        # of nodes including the gateway (NODE_SIZE)
+ *      -steps N        # of measured steps (TIME_STEPS)
+ *      -net emu|ace    emulated network, or real sockets on localhost (NET_MODEL)
+ *      -relays N       # of nodes that join as relays (RELAY_SIZE)
+ *      -matchers N     # of nodes that join as matcher candidates (MATCHER_SIZE)
+ *      -join N         # of nodes created per step (default 10)
+ *      -warmup N       # of steps run after all nodes joined, before measuring (default 20)
+ *      -pub N          publications per 1000 node-steps (default 100)
+ *      -size N         publication payload in bytes (default 64)
+ *      -radius N       publication radius, 0 for point publications (default 0)
+ *      -trace file     memory-mapped movement trace (see MovementTrace.h) to replay,
+ *                      recorded first if it does not exist or is too small
+ *                      (default: VAST_TRACEFILE_FORMAT for the # of nodes & steps)
+ *      -latency file   emulate latency, bandwidth & jitter with one-way latencies (ms) from a file
+ *                      (LATENCY_MODEL turns on the model with VAST_LATENCYFILE, or random latencies
+ *                      if not found; UPLINK_CAPACITY, DOWNLINK_CAPACITY & NET_SEED also apply)
+ *      -realtime       pace steps at STEPS_PERSEC instead of running as fast as possible
+ *
+ *  all nodes are ticked in turn by a single thread, so the time spent in each tick ()
+ *  is the CPU used by that node (the socket threads of net_ace are only counted in the
+ *  process CPU time). publication latency is measured from publish () to receive ()
+ *  by a timestamp carried in the payload, both in microseconds & in steps.
+ *  the trace & the publish workload come from fixed seeds, so runs are repeatable.
+ *
+ *  version:    2026/10/19  init
+ */
+
+#ifdef WIN32
+// disable warning about "unsafe functions"
+#pragma warning(disable: 4996)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>           // clock
+#include <algorithm>
+#include <vector>
+
+#include "ace/ACE.h"                // for sleep functions
+#include "ace/OS_NS_unistd.h"       // ACE_OS::sleep
+
+#include "VASTsim.h"
+#include "VASTVerse.h"
+#include "Movement.h"
+#include "Histogram.h"
+
+using namespace Vast;
+using namespace std;
+
+#define LOAD_LAYER              (1)         // layer subscribed & published to
+#define LOAD_JOIN_PER_STEP      (10)        // default # of nodes created per step
+#define LOAD_JOIN_TIMEOUT       (500)       // max # of steps to wait for the last node to join
+#define LOAD_WARMUP_STEPS       (20)        // default # of steps before measuring
+#define LOAD_PUBLISH_RATE       (100)       // default publications per 1000 node-steps
+#define LOAD_PAYLOAD_SIZE       (64)        // default publication payload size
+#define LOAD_TOP_NODES          (10)        // # of busiest nodes listed
+
+// state of one simulated node
+struct LoadNode
+{
+    VASTVerse *         world;
+    VAST *              vnode;
+    Area                aoi;
+    int                 steps;          // # of steps moved since joining (index into the trace)
+    bool                is_relay;
+    bool                is_matcher;
+
+    unsigned long long  tick_time;      // time spent in tick () while measuring (in microseconds)
+    size_t              published;
+    size_t              received;
+};
+
+// options of this run
+struct LoadPara
+{
+    int         net_model;
+    int         join_per_step;
+    int         warmup;
+    int         publish_rate;
+    int         payload_size;
+    int         publish_radius;
+    bool        realtime;
+    const char *trace;
+    const char *latency;
+    const char *output;
+};
+
+SimPara             g_simpara;
+LoadPara            g_para;
+vector<LoadNode>    g_nodes;
+MovementGenerator   g_move_model;
+
+// recorded while measuring
+Histogram           g_tick_hist;        // time of each tick () of each node
+Histogram           g_latency_hist;     // publication latency (microseconds)
+Histogram           g_latency_steps;    // publication latency (steps)
+int                 g_step = 0;         // current step (from start of the run)
+bool                g_measuring = false;
+
+//
+//  helpers
+//
+
+// deterministic random numbers for publications
+static RandomGenerator g_random;
+
+unsigned long long now ()
+{
+    return TimeMonitor::instance ()->getTime ();
+}
+
+// defaults if VASTsim.ini is not found
+void defaultPara (SimPara &para)
+{
+    memset (&para, 0, sizeof (SimPara));
+    para.NET_MODEL      = VAST_NET_EMULATED;
+    para.WORLD_WIDTH    = 768;
+    para.WORLD_HEIGHT   = 768;
+    para.NODE_SIZE      = 100;
+    para.RELAY_SIZE     = 10;
+    para.MATCHER_SIZE   = 10;
+    para.TIME_STEPS     = 1000;
+    para.STEPS_PERSEC   = 10;
+    para.AOI_RADIUS     = 100;
+    para.VELOCITY       = 3;
+    para.OVERLOAD_LIMIT = 20;
+    para.NET_SEED       = 1;
+}
+
+bool parseArgs (int argc, char *argv[])
+{
+    memset (&g_para, 0, sizeof (LoadPara));
+    g_para.join_per_step  = LOAD_JOIN_PER_STEP;
+    g_para.warmup         = LOAD_WARMUP_STEPS;
+    g_para.publish_rate   = LOAD_PUBLISH_RATE;
+    g_para.payload_size   = LOAD_PAYLOAD_SIZE;
+
+    defaultPara (g_simpara);
+    if (ReadPara (g_simpara) == false)
+        fprintf (stderr, "VASTsim.ini not found, using defaults\n");
+
+    for (int i=1; i < argc; i++)
+    {
+        const char *arg   = argv[i];
+        const char *value = (i + 1 < argc ? argv[i+1] : NULL);
+
+        if (strcmp (arg, "-realtime") == 0)
+        {
+            g_para.realtime = true;
+            continue;
+        }
+
+        if (arg[0] != '-')
+        {
+            g_para.output = arg;
+            continue;
+        }
+
+        if (value == NULL)
+        {
+            fprintf (stderr, "missing value for '%s'\n", arg);
+            return false;
+        }
+        i++;
+
+        if (strcmp (arg, "-nodes") == 0)
+            g_simpara.NODE_SIZE = atoi (value);
+        else if (strcmp (arg, "-steps") == 0)
+            g_simpara.TIME_STEPS = atoi (value);
+        else if (strcmp (arg, "-net") == 0)
+            g_simpara.NET_MODEL = (strcmp (value, "ace") == 0 ? VAST_NET_ACE : VAST_NET_EMULATED);
+        else if (strcmp (arg, "-relays") == 0)
+            g_simpara.RELAY_SIZE = atoi (value);
+        else if (strcmp (arg, "-matchers") == 0)
+            g_simpara.MATCHER_SIZE = atoi (value);
+        else if (strcmp (arg, "-join") == 0)
+            g_para.join_per_step = atoi (value);
+        else if (strcmp (arg, "-warmup") == 0)
+            g_para.warmup = atoi (value);
+        else if (strcmp (arg, "-pub") == 0)
+            g_para.publish_rate = atoi (value);
+        else if (strcmp (arg, "-size") == 0)
+            g_para.payload_size = atoi (value);
+        else if (strcmp (arg, "-radius") == 0)
+            g_para.publish_radius = atoi (value);
+        else if (strcmp (arg, "-trace") == 0)
+            g_para.trace = value;
+        else if (strcmp (arg, "-latency") == 0)
+            g_para.latency = value;
+        else
+        {
+            fprintf (stderr, "unknown option '%s'\n", arg);
+            return false;
+        }
+    }
+
+    if (g_simpara.NODE_SIZE < 1 || g_simpara.TIME_STEPS < 1 || g_para.join_per_step < 1)
+    {
+        fprintf (stderr, "invalid # of nodes, steps or join rate\n");
+        return false;
+    }
+
+    g_para.net_model = (g_simpara.NET_MODEL == VAST_NET_ACE ? VAST_NET_ACE : VAST_NET_EMULATED);
+    if (g_para.payload_size < 0)
+        g_para.payload_size = 0;
+
+    return true;
+}
+
+// map the movement trace, or record it first
+// the trace covers the join & warmup steps as well, as nodes start moving once joined
+bool loadTrace ()
+{
+    int total_steps = g_simpara.TIME_STEPS + g_para.warmup + LOAD_JOIN_TIMEOUT +
+                      g_simpara.NODE_SIZE / g_para.join_per_step;
+
+    char filename[256];
+    if (g_para.trace != NULL)
+        sprintf (filename, "%.255s", g_para.trace);
+    else
+        sprintf (filename, VAST_TRACEFILE_FORMAT, g_simpara.NODE_SIZE, g_simpara.WORLD_WIDTH, g_simpara.WORLD_HEIGHT, total_steps);
+
+    fprintf (stderr, "loading movement trace '%s'\n", filename);
+
+    bool result = g_move_model.initModelFromTrace (g_simpara.MOVE_MODEL == 0 ? VAST_MOVEMENT_CLUSTER : g_simpara.MOVE_MODEL, filename,
+                                                   Position (0,0), Position ((coord_t)g_simpara.WORLD_WIDTH, (coord_t)g_simpara.WORLD_HEIGHT),
+                                                   g_simpara.NODE_SIZE, total_steps, (double)g_simpara.VELOCITY);
+
+    if (result == false || g_move_model.getPos (g_simpara.NODE_SIZE - 1, 0) == NULL)
+    {
+        fprintf (stderr, "cannot load movement trace '%s' for %d nodes\n", filename, g_simpara.NODE_SIZE);
+        return false;
+    }
+
+    return result;
+}
+
+//
+//  nodes
+//
+
+void createNode (size_t index)
+{
+    VASTPara_Sim simpara;
+    memset (&simpara, 0, sizeof (VASTPara_Sim));
+    simpara.step_persec  = g_simpara.STEPS_PERSEC;
+    simpara.loss_rate    = g_simpara.LOSS_RATE;
+    simpara.fail_rate    = g_simpara.FAIL_RATE;
+    simpara.with_latency = (g_simpara.LATENCY_MODEL != 0 || g_para.latency != NULL);
+    simpara.seed         = g_simpara.NET_SEED;
+    simpara.uplink       = (size_t)g_simpara.UPLINK_CAPACITY;
+    simpara.downlink     = (size_t)g_simpara.DOWNLINK_CAPACITY;
+    simpara.latency_file = (g_para.latency != NULL ? g_para.latency : (simpara.with_latency ? VAST_LATENCYFILE : NULL));
+
+    VASTPara_Net netpara ((VAST_NetModel)g_para.net_model);
+    netpara.port           = GATEWAY_DEFAULT_PORT;     // net_ace moves to the next free port if taken
+    netpara.client_limit   = g_simpara.PEER_LIMIT;
+    netpara.relay_limit    = g_simpara.RELAY_LIMIT;
+    netpara.conn_limit     = g_simpara.CONNECT_LIMIT;
+    netpara.overload_limit = g_simpara.OVERLOAD_LIMIT;
+
+    char GWstr[80];
+    sprintf (GWstr, "127.0.0.1:%d", GATEWAY_DEFAULT_PORT);
+
+    LoadNode node;
+    node.vnode      = NULL;
+    node.steps      = 0;
+    node.tick_time  = 0;
+    node.published  = 0;
+    node.received   = 0;
+
+    // same assignment of relays & matchers as VASTsim, node 0 is the gateway
+    node.is_relay   = (index == 0 || (int)index < g_simpara.RELAY_SIZE);
+    node.is_matcher = (index == 0 || (int)index < g_simpara.MATCHER_SIZE);
+
+    node.aoi.center = *g_move_model.getPos ((int)index, 0);
+    node.aoi.radius = (length_t)g_simpara.AOI_RADIUS;
+
+    netpara.is_relay   = node.is_relay;
+    netpara.is_matcher = node.is_matcher;
+    netpara.phys_coord = node.aoi.center;
+
+    node.world = new VASTVerse (index == 0, GWstr, &netpara, &simpara);
+    node.world->createVASTNode (VAST_DEFAULT_WORLD_ID, node.aoi, LOAD_LAYER);
+
+    g_nodes.push_back (node);
+}
+
+// publish at the current position, payload is the send time, step & sender, then padding
+void publish (LoadNode &node, uint32_t index)
+{
+    static vector<char> padding;
+    if (padding.size () != (size_t)g_para.payload_size + 1)
+        padding.assign (g_para.payload_size + 1, 'x');
+
+    timestamp_t sent = now ();
+    uint32_t    step = (uint32_t)g_step;
+
+    Message msg (1);
+    msg.store ((char *)&sent, sizeof (timestamp_t));
+    msg.store (step);
+    msg.store (index);
+    if (g_para.payload_size > 0)
+        msg.store (&padding[0], (vsize_t)g_para.payload_size);
+
+    Area area (node.aoi.center, (length_t)g_para.publish_radius);
+    if (node.vnode->publish (area, LOAD_LAYER, msg))
+        node.published++;
+}
+
+// collect received publications
+void receive (LoadNode &node)
+{
+    Message *msg;
+    while ((msg = node.vnode->receive ()) != NULL)
+    {
+        timestamp_t sent;
+        uint32_t    step;
+
+        if (msg->extract ((char *)&sent, sizeof (timestamp_t)) != sizeof (timestamp_t) ||
+            msg->extract (step) != sizeof (uint32_t))
+            continue;
+
+        node.received++;
+
+        if (g_measuring)
+        {
+            timestamp_t current = now ();
+            g_latency_hist.record (current > sent ? current - sent : 0);
+            g_latency_steps.record ((int)step <= g_step ? (uint64_t)(g_step - (int)step) : 0);
+        }
+    }
+}
+
+// one step: joined nodes move along the trace, publish & receive, then all nodes are ticked
+void step ()
+{
+    for (size_t i=0; i < g_nodes.size (); i++)
+    {
+        LoadNode &node = g_nodes[i];
+
+        // check if the node has joined
+        if (node.vnode == NULL)
+        {
+            VAST *vnode = node.world->getVASTNode ();
+            if (vnode != NULL && vnode->getSubscriptionID () != NET_ID_UNASSIGNED)
+                node.vnode = vnode;
+            else
+                continue;
+        }
+
+        Position *pos = g_move_model.getPos ((int)i, ++node.steps);
+        if (pos != NULL)
+        {
+            node.aoi.center = *pos;
+            node.vnode->move (node.vnode->getSubscriptionID (), node.aoi);
+        }
+
+        if (g_measuring && (int)(g_random.next () % 1000) < g_para.publish_rate)
+            publish (node, (uint32_t)i);
+
+        receive (node);
+    }
+
+    for (size_t i=0; i < g_nodes.size (); i++)
+    {
+        unsigned long long start = now ();
+        g_nodes[i].world->tick ();
+        unsigned long long elapsed = now () - start;
+
+        if (g_measuring)
+        {
+            g_nodes[i].tick_time += elapsed;
+            g_tick_hist.record (elapsed);
+        }
+    }
+
+    // advance the emulated network once all nodes have processed this step
+    if (g_nodes.size () > 0)
+        g_nodes[0].world->tickLogicalClock ();
+
+    g_step++;
+}
+
+// wait until the end of the current step in realtime mode
+void pace (unsigned long long step_start)
+{
+    if (g_para.realtime == false || g_simpara.STEPS_PERSEC <= 0)
+        return;
+
+    unsigned long long step_time = 1000000 / g_simpara.STEPS_PERSEC;
+    unsigned long long elapsed   = now () - step_start;
+
+    if (elapsed < step_time)
+    {
+        ACE_Time_Value duration (0, (long)(step_time - elapsed));
+        ACE_OS::sleep (duration);
+    }
+}
+
+// create all nodes at the join rate & wait for all to join, returns # of nodes joined
+int joinAll ()
+{
+    int joined = 0;
+    int waited = 0;
+
+    while (waited < LOAD_JOIN_TIMEOUT)
+    {
+        unsigned long long start = now ();
+
+        for (int j=0; j < g_para.join_per_step && (int)g_nodes.size () < g_simpara.NODE_SIZE; j++)
+            createNode (g_nodes.size ());
+
+        step ();
+        pace (start);
+
+        joined = 0;
+        for (size_t i=0; i < g_nodes.size (); i++)
+            if (g_nodes[i].vnode != NULL)
+                joined++;
+
+        if (joined == g_simpara.NODE_SIZE)
+            break;
+
+        // timeout counts only after the last node is created
+        if ((int)g_nodes.size () == g_simpara.NODE_SIZE)
+            waited++;
+
+        if (g_step % 100 == 0)
+            fprintf (stderr, "step %d: %d of %d nodes joined\n", g_step, joined, g_simpara.NODE_SIZE);
+    }
+
+    return joined;
+}
+
+void destroyNodes ()
+{
+    for (size_t i=g_nodes.size (); i > 0; i--)
+    {
+        LoadNode &node = g_nodes[i-1];
+        if (node.vnode != NULL)
+            node.vnode->leave ();
+        node.world->destroyVASTNode (node.vnode);
+        delete node.world;
+    }
+    g_nodes.clear ();
+}
+
+//
+//  output
+//
+
+bool compareTickTime (const LoadNode *a, const LoadNode *b)
+{
+    return a->tick_time > b->tick_time;
+}
+
+void writeHistogram (FILE *fp, const Histogram &hist)
+{
+    fprintf (fp, "{\"count\": %llu, \"min\": %llu, \"avg\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}",
+             (unsigned long long)hist.getCount (), (unsigned long long)hist.getMinimum (), hist.getAverage (),
+             (unsigned long long)hist.getPercentile (50), (unsigned long long)hist.getPercentile (90),
+             (unsigned long long)hist.getPercentile (99), (unsigned long long)hist.getPercentile (99.9),
+             (unsigned long long)hist.getMaximum ());
+}
+
+void writeResults (FILE *fp, int joined, int steps, double seconds, double cpu_seconds)
+{
+    size_t published = 0, received = 0, bytes_sent = 0, bytes_recv = 0;
+    Histogram node_cpu;                 // CPU per node per step (microseconds)
+    vector<LoadNode *> busiest;
+
+    for (size_t i=0; i < g_nodes.size (); i++)
+    {
+        LoadNode &node = g_nodes[i];
+        published  += node.published;
+        received   += node.received;
+        bytes_sent += node.world->getSendStat (true).total;
+        bytes_recv += node.world->getReceiveStat (true).total;
+
+        node_cpu.record (steps > 0 ? node.tick_time / steps : 0);
+        busiest.push_back (&node);
+    }
+
+    sort (busiest.begin (), busiest.end (), compareTickTime);
+    if (busiest.size () > LOAD_TOP_NODES)
+        busiest.resize (LOAD_TOP_NODES);
+
+    if (seconds <= 0)
+        seconds = 1e-6;
+
+    fprintf (fp, "{\n  \"net\": \"%s\",\n  \"nodes\": %d,\n  \"joined\": %d,\n  \"steps\": %d,\n  \"realtime\": %s,\n",
+             (g_para.net_model == VAST_NET_ACE ? "ace" : "emu"), g_simpara.NODE_SIZE, joined, steps, (g_para.realtime ? "true" : "false"));
+    fprintf (fp, "  \"publish_rate\": %d,\n  \"payload_size\": %d,\n  \"publish_radius\": %d,\n",
+             g_para.publish_rate, g_para.payload_size, g_para.publish_radius);
+
+    fprintf (fp, "  \"seconds\": %.3f,\n  \"process_cpu_seconds\": %.3f,\n", seconds, cpu_seconds);
+    fprintf (fp, "  \"throughput\": {\"steps_per_sec\": %.1f, \"moves_per_sec\": %.1f, \"publish_per_sec\": %.1f, \"deliver_per_sec\": %.1f, \"send_bytes_per_sec\": %.1f, \"recv_bytes_per_sec\": %.1f},\n",
+             steps / seconds, (double)joined * steps / seconds, published / seconds, received / seconds, bytes_sent / seconds, bytes_recv / seconds);
+    fprintf (fp, "  \"published\": %lu,\n  \"delivered\": %lu,\n", (unsigned long)published, (unsigned long)received);
+
+    fprintf (fp, "  \"latency_us\": ");
+    writeHistogram (fp, g_latency_hist);
+    fprintf (fp, ",\n  \"latency_steps\": ");
+    writeHistogram (fp, g_latency_steps);
+
+    fprintf (fp, ",\n  \"tick_us\": ");
+    writeHistogram (fp, g_tick_hist);
+    fprintf (fp, ",\n  \"node_cpu_us_per_step\": ");
+    writeHistogram (fp, node_cpu);
+
+    fprintf (fp, ",\n  \"busiest_nodes\": [\n");
+    for (size_t i=0; i < busiest.size (); i++)
+    {
+        LoadNode *node = busiest[i];
+        fprintf (fp, "    {\"index\": %d, \"relay\": %s, \"matcher\": %s, \"cpu_us_per_step\": %.1f, \"send_bytes\": %lu, \"recv_bytes\": %lu}%s\n",
+                 (int)(node - &g_nodes[0]), (node->is_relay ? "true" : "false"), (node->is_matcher ? "true" : "false"),
+                 (steps > 0 ? (double)node->tick_time / steps : 0),
+                 (unsigned long)node->world->getSendStat (true).total, (unsigned long)node->world->getReceiveStat (true).total,
+                 (i + 1 < busiest.size () ? "," : ""));
+    }
+    fprintf (fp, "  ]\n}\n");
+}
+
+int main (int argc, char *argv[])
+{
+    if (parseArgs (argc, argv) == false)
+    {
+        fprintf (stderr, "usage: load_generator [-nodes N] [-steps N] [-net emu|ace] [-relays N] [-matchers N] [-join N]\n"
+                         "                      [-warmup N] [-pub N] [-size N] [-radius N] [-trace file] [-realtime] [output]\n");
+        return 1;
+    }
+
+    // suppress LogManager output to screen where possible
+    LogManager::instance ()->setLogLevel (LOG_LEVEL_WARNING);
+
+    if (loadTrace () == false)
+        return 1;
+
+    fprintf (stderr, "creating %d nodes over %s network...\n", g_simpara.NODE_SIZE, (g_para.net_model == VAST_NET_ACE ? "ace" : "emulated"));
+
+    int joined = joinAll ();
+    if (joined < g_simpara.NODE_SIZE)
+        fprintf (stderr, "warning: only %d of %d nodes joined\n", joined, g_simpara.NODE_SIZE);
+
+    for (int i=0; i < g_para.warmup; i++)
+    {
+        unsigned long long start = now ();
+        step ();
+        pace (start);
+    }
+
+    // measure
+    for (size_t i=0; i < g_nodes.size (); i++)
+    {
+        g_nodes[i].world->clearStat ();
+        g_nodes[i].published = g_nodes[i].received = 0;
+    }
+
+    g_measuring = true;
+
+    clock_t cpu_start = clock ();
+    unsigned long long start = now ();
+
+    for (int i=0; i < g_simpara.TIME_STEPS; i++)
+    {
+        unsigned long long step_start = now ();
+        step ();
+        pace (step_start);
+
+        if ((i + 1) % 100 == 0)
+            fprintf (stderr, "step %d of %d\n", i + 1, g_simpara.TIME_STEPS);
+    }
+
+    double seconds     = (now () - start) / 1000000.0;
+    double cpu_seconds = (double)(clock () - cpu_start) / CLOCKS_PER_SEC;
+
+    g_measuring = false;
+
+    FILE *fp = stdout;
+    if (g_para.output != NULL && strcmp (g_para.output, "-") != 0 && (fp = fopen (g_para.output, "wt")) == NULL)
+    {
+        fprintf (stderr, "cannot open output file '%s'\n", g_para.output);
+        fp = stdout;
+    }
+
+    writeResults (fp, joined, g_simpara.TIME_STEPS, seconds, cpu_seconds);
+
+    if (fp != stdout)
+        fclose (fp);
+
+    destroyNodes ();
+
+    return 0;
+}
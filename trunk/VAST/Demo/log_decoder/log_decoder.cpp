@@ -0,0 +1,92 @@
+/*
+ *  log_decoder     prints a binary log file written by LogManager as text
+ *                  (log files are binary only if LOG_BINARY_FILE is enabled in VASTUtil.h)
+ *  
+ *  usage:  log_decoder <log file> [min level]
+ *          levels: 0 debug, 1 info, 2 warning, 3 error
+ *
+ *  version:    2026/10/19  init
+ */
+
+#ifdef WIN32
+// disable warning about "unsafe functions"
+#pragma warning(disable: 4996)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+#include "BinaryLog.h"
+
+using namespace Vast;
+
+int main (int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf ("usage: %s <log file> [min level]\n", argv[0]);
+        return 1;
+    }
+
+    int min_level = (argc > 2 ? atoi (argv[2]) : LOG_LEVEL_DEBUG);
+
+    FILE *fp;
+    if ((fp = fopen (argv[1], "rb")) == NULL)
+    {
+        printf ("cannot open log file '%s'\n", argv[1]);
+        return 1;
+    }
+
+    // check file type
+    char magic[16];
+    size_t magic_size = strlen (LOG_FILE_MAGIC);
+    if (fread (magic, magic_size, 1, fp) != 1 || memcmp (magic, LOG_FILE_MAGIC, magic_size) != 0)
+    {
+        printf ("'%s' is not a binary VAST log file\n", argv[1]);
+        fclose (fp);
+        return 1;
+    }
+
+    std::map<uint32_t, std::string> formats;
+
+    LogRecordHeader header;
+    char args[LOG_RECORD_MAX_SIZE];
+    char text[LOG_TEXT_MAX];
+    char time[64];
+    long count = 0;
+
+    while (BinaryLog::readRecord (fp, header, args))
+    {
+        size_t length = header.size - sizeof (LogRecordHeader);
+
+        if (header.level == LOG_LEVEL_FORMAT)
+        {
+            formats[header.format_id] = std::string (args, length);
+            continue;
+        }
+
+        if (header.level < min_level)
+            continue;
+
+        if (formats.find (header.format_id) == formats.end ())
+        {
+            printf ("record %ld has undefined format %u\n", count, header.format_id);
+            continue;
+        }
+
+        BinaryLog::formatTime (time, 64, header.time);
+        BinaryLog::decode (text, LOG_TEXT_MAX, formats[header.format_id].c_str (), args, length);
+        printf ("[%s] %s\n", time, text);
+
+        count++;
+    }
+
+    if (feof (fp) == 0)
+        printf ("log file corrupt after %ld records\n", count);
+
+    fclose (fp);
+    return 0;
+}
@@ -68,6 +68,10 @@ namespace Vast
         Message msg (JOIN);
         msg.store (_world_id);
 
+        // physical coordinate lets the gateway place a new origin matcher close to me
+        if (_relay->getPhysicalCoordinate () != NULL)
+            msg.store (*_relay->getPhysicalCoordinate ());
+
         _state = JOINING;
 
         return sendGatewayMessage (msg, MSG_GROUP_VAST_MATCHER);
@@ -95,6 +99,10 @@ namespace Vast
         // important to set it to 0, so that auto-subscribe check would not happen 
         // in postHandling ()
         _timeout_subscribe = 0;
+
+        // neighbors can no longer be contacted directly
+        _direct.clear ();
+        _direct_update.clear ();
          
         _state = ABSENT;
     }
@@ -130,6 +138,16 @@ namespace Vast
         _sub.active  = false;
         _sub.relay   = _net->getAddress (_relay->getRelayID ());
 
+        // physical coordinate lets the gateway place new matchers close to subscribers
+        if (_relay->getPhysicalCoordinate () != NULL)
+            _sub.phys_coord = *_relay->getPhysicalCoordinate ();
+
+#ifdef VAST_DIRECT_NEIGHBORS
+        // neighbors may send me updates directly only if I'm reachable
+        if (_net->isPublic ())
+            _sub.direct_addr = _net->getHostAddress ();
+#endif
+
         LogManager::instance ()->writeLogFile ("VASTClient::subscribe () [%llu] sends SUBSCRIBE request to [%llu]\n", _self.id, _matcher_id);
 
         // send out subscription request
@@ -231,6 +249,26 @@ namespace Vast
                 // msg.reliable = false;
 
                 sendMatcherMessage (msg, 3);
+
+#ifdef VAST_DIRECT_NEIGHBORS
+                // also send to neighbors authorized for direct updates, which get it in one hop
+                // NOTE: matcher still receives MOVE as it decides who the neighbors are
+                if (_direct.size () > 0)
+                {
+                    Message direct_msg (NEIGHBOR_MOVE);
+                    direct_msg.priority = 3;
+                    direct_msg.from = _sub.id;
+                    direct_msg.store (prev_aoi);
+#ifdef VAST_RECORD_LATENCY
+                    direct_msg.store (_net->getTimestamp ());
+#endif
+
+                    for (map<id_t, Addr>::iterator it = _direct.begin (); it != _direct.end (); it++)
+                        direct_msg.addTarget (it->second.host_id);
+
+                    sendMessage (direct_msg);
+                }
+#endif
             }
 
             // update into 'self'
@@ -260,6 +298,36 @@ namespace Vast
         msg.store (_net->getTimestamp ());  // store sendtime for latency calculation
 #endif
 
+#ifdef VAST_DIRECT_NEIGHBORS
+        // targets authorized for direct updates are sent to directly, others via matcher
+        if (direct)
+        {
+            Message direct_msg (msg);
+            direct_msg.targets.clear ();
+            direct_msg.msggroup = MSG_GROUP_VAST_CLIENT;
+            direct_msg.msgtype = (msg.msgtype << VAST_MSGTYPE_RESERVED) | MESSAGE;
+
+            vector<id_t> targets;
+            for (size_t i=0; i < msg.targets.size (); i++)
+            {
+                map<id_t, Addr>::iterator it = _direct.find (msg.targets[i]);
+                if (it != _direct.end ())
+                    direct_msg.addTarget (it->second.host_id);
+                else
+                    targets.push_back (msg.targets[i]);
+            }
+
+            if (direct_msg.targets.size () > 0)
+            {
+                sendMessage (direct_msg);
+                msg.targets = targets;
+
+                if (targets.size () == 0)
+                    return message.targets.size ();
+            }
+        }
+#endif
+
         // store targets
         listsize_t n = (listsize_t)msg.targets.size ();
         for (listsize_t i=0; i < n; i++)
@@ -472,6 +540,7 @@ namespace Vast
         if (msgtype == 0)
         {
             _latency.clear ();
+            _latency_hist.clear ();
             return NULL;
         }
 
@@ -485,6 +554,17 @@ namespace Vast
         return &_latency[msgtype];
     }
 
+    // get distribution of message latencies (for percentiles), NULL if not yet recorded
+    Histogram *
+    VASTClient::getLatencyHistogram (msgtype_t msgtype)
+    {
+        map<msgtype_t, Histogram>::iterator it = _latency_hist.find (msgtype);
+        if (it == _latency_hist.end ())
+            return NULL;
+
+        return &it->second;
+    }
+
 
     //
     //  private methods 
@@ -660,6 +740,17 @@ namespace Vast
                             recordLatency (MOVE, time);
 #endif
 
+#ifdef VAST_DIRECT_NEIGHBORS
+                            // a recent direct update is newer than the one via matcher
+                            map<id_t, timestamp_t>::iterator it_direct = _direct_update.find (neighbor_id);
+                            if (it_direct != _direct_update.end () && 
+                                now - it_direct->second < (timestamp_t)(TIMEOUT_DIRECT_UPDATE * _net->getTimestampPerSecond ()))
+                            {
+                                _last_update[neighbor_id] = now;
+                                break;
+                            }
+#endif
+
                             vector<Node *>::iterator it = _neighbors.begin ();
                             for (; it != _neighbors.end (); it++)
                             {
@@ -688,6 +779,67 @@ namespace Vast
             }
             break;
         
+#ifdef VAST_DIRECT_NEIGHBORS
+        // matcher authorizing (or revoking, if address is empty) direct updates with some neighbors
+        case NEIGHBOR_DIRECT:
+            {
+                listsize_t n;
+                in_msg.extract (n, true);
+
+                id_t neighbor_id;
+                Addr addr;
+                for (listsize_t i=0; i < n; i++)
+                {
+                    in_msg.extract (neighbor_id);
+                    in_msg.extract (addr);
+
+                    if (addr.host_id == NET_ID_UNASSIGNED)
+                    {
+                        _direct.erase (neighbor_id);
+                        _direct_update.erase (neighbor_id);
+                    }
+                    else
+                    {
+                        _direct[neighbor_id] = addr;
+                        notifyMapping (addr.host_id, &addr);
+                    }
+                }
+            }
+            break;
+
+        // position update sent directly by a neighbor
+        case NEIGHBOR_MOVE:
+            {
+                // only accept from neighbors the matcher has authorized
+                if (_direct.find (in_msg.from) == _direct.end ())
+                    break;
+
+                Area aoi;
+                in_msg.extract (aoi);
+#ifdef VAST_RECORD_LATENCY
+                timestamp_t time;
+                in_msg.extract (time);
+                recordLatency (MOVE, time);
+#endif
+                timestamp_t now = _net->getTimestamp ();
+
+                for (size_t i=0; i < _neighbors.size (); i++)
+                {
+                    if (_neighbors[i]->id == in_msg.from)
+                    {
+                        _neighbors[i]->aoi = aoi;
+#ifdef VAST_RECORD_LATENCY
+                        _neighbors[i]->time = time;
+#endif
+                        _last_update[in_msg.from] = now;
+                        _direct_update[in_msg.from] = now;
+                        break;
+                    }
+                }
+            }
+            break;
+#endif
+
         // receiving a published or directly-targeted message
         case MESSAGE:
             {
@@ -806,6 +958,10 @@ namespace Vast
                     
             // remove ghost neighbors (those no longer updating)
             removeGhosts ();
+
+            // keep a direct connection to the matcher alive while subscribed
+            if (_sub.active && _matcher_id != NET_ID_UNASSIGNED)
+                _net->keepAlive (_matcher_id);
         }
     }
 
@@ -854,6 +1010,8 @@ namespace Vast
             if ((*it)->id == id)
             {
                 _last_update.erase (id);
+                _direct.erase (id);
+                _direct_update.erase (id);
                 delete (*it);
                 _neighbors.erase (it);                            
                 return true;
@@ -881,11 +1039,11 @@ namespace Vast
     bool 
     VASTClient::sendMatcherMessage (Message &msg, byte_t priority, vector<id_t> *failed)
     {
-        static vector<id_t> failed_list;
-        failed_list.clear ();
-
         if (failed == NULL)
-            failed = &failed_list;
+        {
+            _failed_list.clear ();
+            failed = &_failed_list;
+        }
 
         // by default matcher message are high priority, unless specified otherwise
         if (priority != 0)
@@ -1016,6 +1174,8 @@ namespace Vast
 
         stat.total += (size_t)duration;
         stat.num_records++;
+
+        _latency_hist[msgtype].record (duration);
     }
                                     
 } // end namespace Vast
@@ -39,6 +39,7 @@
 const int TIMEOUT_JOIN          = (5);        // # of seconds before re-attempting to subscribe 
 const int TIMEOUT_SUBSCRIBE     = (5);        // # of seconds before re-attempting to subscribe 
 const int TIMEOUT_REMOVE_GHOST  = (5);        // # of seconds before removing ghost objects at clients
+const int TIMEOUT_DIRECT_UPDATE = (1);        // # of seconds a direct position update from a neighbor overrides updates via matcher
 //const int TIMEOUT_KEEP_ALIVE   = (2);        // # of seconds before re-sending our own position
 
 using namespace std;
@@ -133,6 +134,9 @@ namespace Vast
         // get message latencies, currently supports PUBLISH & MOVE types
         StatType *getMessageLatency (msgtype_t msgtype);
 
+        // get distribution of message latencies (for percentiles), NULL if not yet recorded
+        Histogram *getLatencyHistogram (msgtype_t msgtype);
+
         // notify the network layer of nodeID -> Address mapping        
         bool notifyAddressMapping (id_t node_id, Addr &addr);
 
@@ -193,6 +197,7 @@ namespace Vast
         id_t                _matcher_id;    // hostID for interest matcher
         id_t                _closest_id;    // hostID for the closest neighbor matcher
         VASTRelay          *_relay;         // pointer to VASTRelay (to obtain relayID)        
+        vector<id_t>        _failed_list;   // buffer for failed targets of matcher messages
 
         Subscription        _sub;           // my subscription 
         world_t             _world_id;      // my current worldID
@@ -203,6 +208,9 @@ namespace Vast
         timestamp_t         _timeout_subscribe; // timeout for re-attempt to subscribe        
         map<id_t, timestamp_t> _last_update;    // last update time for a particular neighbor
 
+        map<id_t, Addr>     _direct;            // neighbors authorized by matcher for direct updates, and their host's address
+        map<id_t, timestamp_t> _direct_update;  // last direct position update from a neighbor
+
         Addr                _gateway;       // info about the gateway server
         
         // storage for incoming messages        
@@ -213,6 +221,7 @@ namespace Vast
        
         // stats
         map<msgtype_t, StatType>  _latency; // latencies for different message types 
+        map<msgtype_t, Histogram> _latency_hist;    // distribution of latencies for different message types
 
 
     };
@@ -0,0 +1,324 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "VASTVerse.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>        // find
+
+#include "ace/ACE.h"
+#include "ace/OS_NS_unistd.h"       // ACE_OS::sleep
+#include "ace/Task.h"
+
+#include "VASTUtil.h"               // TimeMonitor
+#include "net_ace_reactor.h"
+
+namespace Vast
+{
+
+    //
+    //  threads ticking the hosted VASTVerse with a timer wheel
+    //
+    //  a tick period is divided into VASTHOST_WHEEL_SLOTS slots, each VASTVerse is placed 
+    //  in one slot & ticked as the wheel turns to it, so wakeups are spread over the period 
+    //  instead of all VASTVerse being ticked at once. each VASTVerse also belongs to one thread 
+    //  for as long as it's hosted, so it's never ticked by two threads at the same time.
+    //
+
+    class VASTHostWorkers : public ACE_Task<ACE_MT_SYNCH>
+    {
+    public:
+        VASTHostWorkers (int tick_persec, int num_threads)
+        {
+            _period      = MICROSECOND_PERSEC / (tick_persec > 0 ? tick_persec : 10);
+            _num_slots   = (_period >= VASTHOST_WHEEL_SLOTS ? VASTHOST_WHEEL_SLOTS : 1);
+            _slot_period = _period / _num_slots;
+            _num_threads = (num_threads > 0 ? num_threads : 1);
+            _active      = false;
+            _started     = 0;
+            _start       = 0;
+
+            _tick_mutex  = new ACE_Thread_Mutex[_num_threads];
+            _wheels.resize (_num_threads, vector<vector<VASTVerse *> > (_num_slots));
+            _thread_size.resize (_num_threads, 0);
+        }
+
+        ~VASTHostWorkers ()
+        {
+            stop ();
+            delete[] _tick_mutex;
+        }
+
+        //
+        //  Standard ACE_Task methods (must implement)
+        //
+
+        // service initialization method
+        int open (void *p)
+        {
+            _start  = TimeMonitor::instance ()->getTime ();
+            _active = true;
+
+            return this->activate (THR_NEW_LWP | THR_JOINABLE, _num_threads);
+        }
+
+        // service termination method (called by ACE as each thread leaves svc ())
+        int close (u_long i)
+        {
+            return 0;
+        }
+
+        // service method
+        int svc (void);
+
+        // stop all threads & wait until they end
+        void stop ()
+        {
+            if (_active == false)
+                return;
+
+            _active = false;
+            this->wait ();
+        }
+
+        // add / remove a VASTVerse to be ticked
+        void attach (VASTVerse *world)
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard (_list_mutex);
+
+            if (_location.find (world) != _location.end ())
+                return;
+
+            // the least loaded thread, then its least loaded slot
+            int thread = 0;
+            for (int i=1; i < _num_threads; i++)
+                if (_thread_size[i] < _thread_size[thread])
+                    thread = i;
+
+            int slot = 0;
+            for (int i=1; i < _num_slots; i++)
+                if (_wheels[thread][i].size () < _wheels[thread][slot].size ())
+                    slot = i;
+
+            _wheels[thread][slot].push_back (world);
+            _thread_size[thread]++;
+            _location[world] = pair<int, int> (thread, slot);
+        }
+
+        void detach (VASTVerse *world)
+        {
+            _list_mutex.acquire ();
+
+            map<VASTVerse *, pair<int, int> >::iterator it = _location.find (world);
+            if (it == _location.end ())
+            {
+                _list_mutex.release ();
+                return;
+            }
+
+            int thread = it->second.first;
+            vector<VASTVerse *> &slot = _wheels[thread][it->second.second];
+            slot.erase (std::find (slot.begin (), slot.end (), world));
+            _thread_size[thread]--;
+            _location.erase (it);
+
+            _list_mutex.release ();
+
+            // wait for a round of ticking that may still include the VASTVerse
+            _tick_mutex[thread].acquire ();
+            _tick_mutex[thread].release ();
+        }
+
+        size_t size ()
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard (_list_mutex);
+            return _location.size ();
+        }
+
+    private:
+
+        unsigned long long  _period;        // time between ticks of a VASTVerse (in microseconds)
+        unsigned long long  _slot_period;   // time the wheel stays at a slot (in microseconds)
+        int                 _num_slots;
+        int                 _num_threads;
+        bool                _active;        // whether threads should keep running
+        int                 _started;       // # of threads started (to assign thread index)
+        unsigned long long  _start;         // time ticking starts, the wheel turns to the next slot at _start + k * _slot_period
+
+        vector<vector<vector<VASTVerse *> > >   _wheels;        // VASTVerse in each slot, for each thread
+        vector<size_t>                          _thread_size;   // # of VASTVerse of each thread
+        map<VASTVerse *, pair<int, int> >       _location;      // thread & slot of each VASTVerse
+        ACE_Thread_Mutex    _list_mutex;    // protects the wheel & _started
+        ACE_Thread_Mutex   *_tick_mutex;    // held by each thread while ticking a slot
+    };
+
+    int
+    VASTHostWorkers::svc (void)
+    {
+        // NEW_THREAD obtain index of this thread
+        _list_mutex.acquire ();
+        int index = _started++;
+        _list_mutex.release ();
+
+        printf ("VASTHostWorkers::svc () thread %d started, tick period: %llu us, slots: %d\n", index, _period, _num_slots);
+
+        vector<VASTVerse *> mine;
+
+        // the next slot to tick (counted from _start)
+        unsigned long long cursor = (TimeMonitor::instance ()->getTime () - _start) / _slot_period;
+
+        while (_active)
+        {
+            unsigned long long now    = TimeMonitor::instance ()->getTime ();
+            unsigned long long target = (now - _start) / _slot_period;
+
+            // if running late, tick each VASTVerse at most once, rather than making up all missed ticks
+            if (target >= cursor + _num_slots)
+                cursor = target - _num_slots + 1;
+
+            for (; cursor <= target; cursor++)
+            {
+                _tick_mutex[index].acquire ();
+
+                // VASTVerse of this thread in the current slot
+                mine.clear ();
+                _list_mutex.acquire ();
+                mine = _wheels[index][(size_t)(cursor % _num_slots)];
+                _list_mutex.release ();
+
+                // split the time of a slot among its VASTVerse
+                int budget = (mine.size () > 0 ? (int)(_slot_period / mine.size ()) : 0);
+
+                for (size_t i=0; i < mine.size (); i++)
+                    mine[i]->tick (budget > 0 ? budget : 1);
+
+                _tick_mutex[index].release ();
+            }
+
+            // sleep until the wheel turns to the next slot
+            now = TimeMonitor::instance ()->getTime ();
+            unsigned long long next = _start + cursor * _slot_period;
+
+            // NOTE the 2nd parameter is specified in microseconds (us) not milliseconds
+            if (next > now)
+            {
+                ACE_Time_Value duration (0, (long)(next - now));
+                ACE_OS::sleep (duration);
+            }
+        }
+
+        printf ("VASTHostWorkers::svc () thread %d leaving ticking loop\n", index);
+
+        return 0;
+    }
+
+    //
+    //  internal states of VASTHost
+    //
+
+    class VASTHostPointer
+    {
+    public:
+        VASTHostPointer ()
+        {
+            workers = NULL;
+            reactor = NULL;
+        }
+
+        VASTHostWorkers *   workers;        // threads ticking the VASTVerse
+        net_ace_reactor *   reactor;        // socket reactor shared by the VASTVerse
+        ACE_Thread_Mutex    mutex;          // for creating the reactor
+    };
+
+    VASTHost::VASTHost (int tick_persec, int num_threads)
+    {
+        ACE::init ();
+
+        VASTHostPointer *host = new VASTHostPointer ();
+        _pointers = host;
+
+        host->workers = new VASTHostWorkers (tick_persec, num_threads);
+        host->workers->open (this);
+    }
+
+    VASTHost::~VASTHost ()
+    {
+        VASTHostPointer *host = (VASTHostPointer *)_pointers;
+
+        if (host->workers->size () > 0)
+            printf ("VASTHost::~VASTHost () %lu VASTVerse still hosted, they should be deleted first\n", (unsigned long)host->workers->size ());
+
+        delete host->workers;
+
+        if (host->reactor != NULL)
+        {
+            host->reactor->stop ();
+            delete host->reactor;
+        }
+
+        delete host;
+        _pointers = NULL;
+
+        ACE::fini ();
+    }
+
+    // number of VASTVerse currently hosted
+    size_t
+    VASTHost::getSize ()
+    {
+        return ((VASTHostPointer *)_pointers)->workers->size ();
+    }
+
+    void
+    VASTHost::attach (VASTVerse *world)
+    {
+        ((VASTHostPointer *)_pointers)->workers->attach (world);
+    }
+
+    void
+    VASTHost::detach (VASTVerse *world)
+    {
+        ((VASTHostPointer *)_pointers)->workers->detach (world);
+    }
+
+    // obtain the shared reactor for the network layer (created when first needed)
+    net_ace_reactor *
+    VASTHost::getReactor ()
+    {
+        VASTHostPointer *host = (VASTHostPointer *)_pointers;
+
+        host->mutex.acquire ();
+        if (host->reactor == NULL)
+        {
+            host->reactor = new net_ace_reactor ();
+            if (host->reactor->open (0) == -1)
+            {
+                printf ("VASTHost::getReactor () cannot start shared reactor\n");
+                delete host->reactor;
+                host->reactor = NULL;
+            }
+        }
+        host->mutex.release ();
+
+        return host->reactor;
+    }
+
+} // end namespace Vast
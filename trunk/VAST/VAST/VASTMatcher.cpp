@@ -5,6 +5,8 @@
 #include "MessageQueue.h"
 
 #include "VASTUtil.h"   // LogManager
+#include "VASTRelay.h"  // RelayFanoutNode
+#include <algorithm>     // partial_sort
 
 
 using namespace Vast;
@@ -12,7 +14,7 @@ using namespace Vast;
 namespace Vast
 {   
 
-    VASTMatcher::VASTMatcher (bool is_matcher, int overload_limit, bool is_static, Position *coord)
+    VASTMatcher::VASTMatcher (bool is_matcher, int overload_limit, bool is_static, Position *coord, size_t send_quota, size_t recv_quota, Position *phys_coord)
             :MessageHandler (MSG_GROUP_VAST_MATCHER), 
              _state (ABSENT),
              _VSOpeer (NULL),
@@ -20,10 +22,19 @@ namespace Vast
              _origin_id (0),
              _is_matcher (is_matcher),
              _is_static (is_static),
-             _overload_limit (overload_limit)
+             _phys_coord (phys_coord),
+             _overload_limit (overload_limit),
+             _send_quota (send_quota),
+             _recv_quota (recv_quota)
     {
         _next_periodic = 0;
         _matcher_keepalive = 0;
+        _msg_count = 0;
+
+        _load_score = 0;
+        _cpu_time = 0;
+        _load_time = 0;
+        _last_sendsize = _last_recvsize = 0;
 
         // gateway only: set world_id assignment
         _world_counter = VAST_DEFAULT_WORLD_ID+1;
@@ -215,6 +226,19 @@ namespace Vast
     // returns whether the message was successfully handled
     bool 
     VASTMatcher::handleMessage (Message &in_msg)
+    {
+        unsigned long long start = TimeMonitor::instance ()->getTime ();
+
+        bool result = processMessage (in_msg);
+
+        _cpu_time += TimeMonitor::instance ()->getTime () - start;
+
+        return result;
+    }
+
+    // process a message actually
+    bool 
+    VASTMatcher::processMessage (Message &in_msg)
     {
         if (_state == ABSENT)
             return false;
@@ -267,6 +291,8 @@ namespace Vast
             _queue.clear ();
         }        
 
+        _msg_count++;
+
 #ifdef DEBUG_DETAIL
         if (in_msg.msgtype < VON_MAX_MSG)
             ; //printf ("[%d] VASTMatcher::handleMessage from: %d msgtype: %d, to be handled by VONPeer, size: %d\n", _self.id, in_msg.from, in_msg.msgtype, in_msg.size);            
@@ -307,6 +333,9 @@ namespace Vast
                 info.world_id = 0;
                 info.time = _net->getTimestamp ();
 
+                // physical coordinate of the candidate (optional)
+                in_msg.extract (info.phys_coord);
+
                 _matchers[matcher_id] = info;
             }
             break;
@@ -544,6 +573,12 @@ namespace Vast
                 world_t world_id;
                 in_msg.extract (world_id);
 
+                // physical coordinate of the client (optional)
+                vector<PlacementDemand> demand (1);
+                demand[0].weight = 1;
+                if (in_msg.extract (demand[0].coord) == 0 || demand[0].coord.isEmpty ())
+                    demand.clear ();
+
                 LogManager::instance ()->writeLogFile ("Gateway [%llu] JOIN from [%llu] on world (%u)\n", _self.id, in_msg.from, world_id);
                 
                 // '0' means to let gateway to assign, '1' is the default worldID, others can be assigned
@@ -574,7 +609,7 @@ namespace Vast
                     // TODO: if findCandidate () fails, insert new matcher hosted by gateway?
                     // NOTE: we use a loop as it's possible candidates already failed
                     bool promote_success = false;
-                    while (findCandidate (new_origin))
+                    while (findCandidate (new_origin, 0, &demand))
                     {                                       
                         // send promotion message
                         notifyMapping (new_origin.host_id, &new_origin);
@@ -691,6 +726,8 @@ namespace Vast
                         bool is_owner = true;
 
                         updateSubscription (sub.id, sub.aoi, 0, &sub.relay, &is_owner);
+                        it->second.phys_coord = sub.phys_coord;
+                        it->second.direct_addr = sub.direct_addr;
                     }
 
                     // notify relay of the client's subscription -> hostID mapping
@@ -733,6 +770,9 @@ namespace Vast
                     if (_closest.find (sub.id) != _closest.end ())
                         _closest.erase (sub.id);
 
+                    // likewise for neighbors authorized for direct updates
+                    _direct.erase (sub.id);
+
                     // record the subscription request                    
                     LogManager::instance ()->writeLogFile ("VASTMatcher: SUBSCRIBE request from [%llu] success\n", in_msg.from);
                 }
@@ -860,6 +900,25 @@ namespace Vast
             }
             break;
 
+        // subscribers of a fan-out message that a relay in the tree could not reach
+        case RELAY_FANOUT_FAILED:
+            {
+                listsize_t n;
+                in_msg.extract (n, true);
+
+                vector<id_t> failed_targets;
+                id_t target;
+                for (size_t i=0; i < n; i++)
+                {
+                    if (in_msg.extract (target, true) == 0)
+                        break;
+                    failed_targets.push_back (target);
+                }
+
+                removeFailedSubscribers (failed_targets);
+            }
+            break;
+
         // message specific to the origin matcher
         case ORIGIN_MESSAGE:
             {
@@ -1072,6 +1131,8 @@ namespace Vast
         // perform regular tick and check if our VONpeer has joined
         if (_VSOpeer == NULL)
             return;
+
+        unsigned long long start = TimeMonitor::instance ()->getTime ();
         
         // we perform matcher tasks only if VSOpeer has joined
         if (_VSOpeer->isJoined ())
@@ -1126,8 +1187,10 @@ namespace Vast
             }
         }
 
-        // allow VSOpeer to perform routine tasks
-        _VSOpeer->tick ();
+        // allow VSOpeer to perform routine tasks
+        _VSOpeer->tick ();
+
+        _cpu_time += TimeMonitor::instance ()->getTime () - start;
     }
 
     // record a new subscription at this VASTMatcher
@@ -1166,6 +1229,7 @@ namespace Vast
         _subscriptions.erase (sub_no);
 
         _closest.erase (sub_no);
+        _direct.erase (sub_no);
 
         if (_replicas.find (sub_no) != _replicas.end ())
         {
@@ -1384,6 +1448,8 @@ namespace Vast
         Message msg (MATCHER_CANDIDATE);
         msg.priority = 1;
         msg.store (_self.addr);
+        if (_phys_coord != NULL)
+            msg.store (*_phys_coord);
         msg.addTarget (_gateway.host_id);
         sendMessage (msg);
 
@@ -1414,13 +1480,34 @@ namespace Vast
         if (n > 0)
             _stat_sub.addRecord (n); 
 
-        // check if no limit is imposed
+        // check if no limit is imposed (load balancing is turned off)
         if (_overload_limit == 0)
             return;
 
-        // if # of subscriptions exceed limit, notify for overload
-        else if (n > _overload_limit)
-            _VSOpeer->notifyLoading (((float)n / (float)_overload_limit));
+        // update per-second resource usage
+        if (_net->getTimestamp () - _load_time >= _net->getTimestampPerSecond ())
+            updateLoadScore ();
+
+        // the load level is determined by the most constrained resource:
+        // subscriptions, CPU time, bandwidth, or queued messages
+        float level = _load_score;
+
+        if ((float)n / (float)_overload_limit > level)
+            level = (float)n / (float)_overload_limit;
+
+        if (MATCHER_LOAD_QUEUE_LIMIT > 0)
+        {
+            float queue_level = (float)(_net->getQueueSize () + _queue.size ()) / (float)MATCHER_LOAD_QUEUE_LIMIT;
+            if (queue_level > level)
+                level = queue_level;
+        }
+
+        // record raw load indicators so overload may be forecasted from trends
+        _VSOpeer->recordLoading (level, _msg_count, _net->getSendSize ());
+
+        // if any resource exceeds limit, notify for overload
+        if (level > 1.0f)
+            _VSOpeer->notifyLoading (level);
         
         // underload
         // TODO: if UNDERLOAD threshold is not 0,
@@ -1433,13 +1520,67 @@ namespace Vast
             _VSOpeer->notifyLoading (0);
     }
 
+    // combine resource usage in the last second into a normalized load score
+    void 
+    VASTMatcher::updateLoadScore ()
+    {
+        timestamp_t now = _net->getTimestamp ();
+        size_t sendsize = _net->getSendSize ();
+        size_t recvsize = _net->getReceiveSize ();
+
+        // first call only starts the measurement
+        if (_load_time != 0 && now > _load_time)
+        {
+            double elapsed = (double)(now - _load_time) / _net->getTimestampPerSecond ();
+            float score = 0;
+
+            // fraction of time spent in matcher handlers
+            // NOTE: CPU time is real time, so it's left out on emulated networks to keep simulations repeatable
+            if (MATCHER_LOAD_CPU_LIMIT > 0 && _net->getModel () != VAST_NET_EMULATED)
+            {
+                float cpu_level = (float)(((double)_cpu_time / MICROSECOND_PERSEC / elapsed) / MATCHER_LOAD_CPU_LIMIT);
+                if (cpu_level > score)
+                    score = cpu_level;
+            }
+
+            // bandwidth used against host quota (accumulated sizes may be reset)
+            if (_send_quota > 0 && sendsize >= _last_sendsize)
+            {
+                float send_level = (float)((sendsize - _last_sendsize) / elapsed / (_send_quota * MATCHER_LOAD_BANDWIDTH_FRACTION));
+                if (send_level > score)
+                    score = send_level;
+            }
+
+            if (_recv_quota > 0 && recvsize >= _last_recvsize)
+            {
+                float recv_level = (float)((recvsize - _last_recvsize) / elapsed / (_recv_quota * MATCHER_LOAD_BANDWIDTH_FRACTION));
+                if (recv_level > score)
+                    score = recv_level;
+            }
+
+            _load_score = score;
+        }
+
+        _load_time      = now;
+        _cpu_time       = 0;
+        _last_sendsize  = sendsize;
+        _last_recvsize  = recvsize;
+    }
+
     // re-send updates of our owned objects so they won't be deleted
     void 
     VASTMatcher::sendKeepAlive ()
     {
         // if I'm a working matcher, then notify gateway periodically of my alive status
         // NOTE: that we must first know our origin before sending KEEPALIVE
-        if (isActive () && _origin_id != 0 && --_matcher_keepalive <= 0)
+        if (isActive () == false || _origin_id == 0)
+            return;
+
+        // keep the connection to gateway alive in-between notifications
+        // (a heartbeat is sent by the network layer only if nothing else is sent to gateway)
+        _net->keepAlive (_gateway.host_id);
+
+        if (--_matcher_keepalive <= 0)
         {
             // reset countdown for notifications
             _matcher_keepalive = TIMEOUT_MATCHER_KEEPALIVE;
@@ -1492,6 +1633,8 @@ namespace Vast
         for ( ; it != _matchers.end (); it++)
         {                        
             MatcherInfo &info = it->second;
+            // NOTE: liveness is judged per matcher from its own MATCHER_ALIVE (info.time),
+            //       not from host-level traffic, as several nodes may share the same host
             if (info.state == ACTIVE && now > (info.time + expire_time))
                 remove_list.push_back (it->first);
         }        
@@ -1538,6 +1681,7 @@ namespace Vast
             {            
                 //printf ("VASTMatcher::notifyClients () updates exist for non-owned subscription [%llu]\n", sub.id);
                 // TODO: update_status for non-own subscribers occur during refreshSubscriptionNeighbors (), try to avoid it?
+                _direct.erase (sub.id);
                 continue;
             }
 
@@ -1651,6 +1795,10 @@ namespace Vast
             // it's cleared when refreshing neighbor states
             //update_status.clear ();
             
+#ifdef VAST_DIRECT_NEIGHBORS
+            notifyDirectNeighbors (sub);
+#endif
+
             // clear dirty flag 
             // (IMPORTANT, to prevent UNCHANGED status be continously sent)
             sub.dirty = false;
@@ -1661,6 +1809,78 @@ namespace Vast
 
     }
 
+    // authorize direct updates between a subscriber & its mutually visible neighbors, or revoke them
+    // NOTE: both must be on public IPs, neighbors are still decided & notified by matcher
+    void
+    VASTMatcher::notifyDirectNeighbors (Subscription &sub)
+    {
+        map<id_t, bool> &authorized = _direct[sub.id];
+        map<id_t, NeighborUpdateStatus> &update_status = sub.getUpdateStatus ();
+
+        Message msg (NEIGHBOR_DIRECT);
+        msg.priority = 1;
+
+        listsize_t listsize = 0;
+        Addr revoked;
+
+        map<id_t, NeighborUpdateStatus>::iterator itr = update_status.begin ();
+        for (; itr != update_status.end (); itr++)
+        {
+            id_t neighbor_id = itr->first;
+            bool was_allowed = (authorized.find (neighbor_id) != authorized.end ());
+
+            // a deleted neighbor is also dropped by the client
+            if (itr->second == DELETED)
+            {
+                authorized.erase (neighbor_id);
+                continue;
+            }
+
+            map<id_t, Subscription>::iterator it = _subscriptions.find (neighbor_id);
+            if (it == _subscriptions.end ())
+                continue;
+
+            Subscription &neighbor = it->second;
+
+            bool allowed = (sub.direct_addr.host_id != NET_ID_UNASSIGNED &&
+                            neighbor.direct_addr.host_id != NET_ID_UNASSIGNED &&
+                            sub.aoi.overlaps (neighbor.aoi.center) &&
+                            neighbor.aoi.overlaps (sub.aoi.center));
+
+            if (allowed == was_allowed)
+                continue;
+
+            msg.store (neighbor_id);
+            if (allowed)
+            {
+                authorized[neighbor_id] = true;
+                msg.store (neighbor.direct_addr);
+            }
+            else
+            {
+                authorized.erase (neighbor_id);
+                msg.store (revoked);
+            }
+            listsize++;
+        }
+
+        // forget neighbors no longer reported (the client has removed them)
+        map<id_t, bool>::iterator ita = authorized.begin ();
+        while (ita != authorized.end ())
+        {
+            if (update_status.find (ita->first) == update_status.end ())
+                authorized.erase (ita++);
+            else
+                ita++;
+        }
+
+        if (listsize > 0)
+        {
+            msg.store (listsize);
+            sendClientMessage (msg, sub.host_id);
+        }
+    }
+
     // handle the failure of a origin matcher
     // NOTE: matcher_id must be a origin matcher
     void
@@ -1712,11 +1932,50 @@ namespace Vast
 
     // get a candidate origin matcher to use
     bool 
-    VASTMatcher::findCandidate (Addr &new_origin, float level)
+    VASTMatcher::findCandidate (Addr &new_origin, float level, vector<PlacementDemand> *demand)
     {
+        map<id_t, MatcherInfo>::iterator it;
+
+#ifdef MATCHER_PLACEMENT_LOCALITY
+        // choose the candidate with the least weighted physical distance to the demand
+        // NOTE: candidates without physical coordinate are only chosen if no others exist
+        if (demand != NULL && demand->size () > 0)
+        {
+            map<id_t, MatcherInfo>::iterator best = _matchers.end ();
+            double best_cost = 0;
+
+            for (it = _matchers.begin (); it != _matchers.end (); it++)
+            {
+                MatcherInfo &info = it->second;
+                if (info.state != CANDIDATE || info.phys_coord.isEmpty ())
+                    continue;
+
+                double cost = 0;
+                for (size_t i=0; i < demand->size (); i++)
+                    cost += (*demand)[i].weight * info.phys_coord.distance ((*demand)[i].coord);
+
+                if (best == _matchers.end () || cost < best_cost)
+                {
+                    best = it;
+                    best_cost = cost;
+                }
+            }
+
+            if (best != _matchers.end ())
+            {
+                new_origin = best->second.addr;
+                best->second.state = PROMOTING;
+
+                printf ("[%llu] promoting [%llu] as new matcher, weighted physical distance: %.2f\n\n", _self.id, new_origin.host_id, best_cost);
+
+                return true;
+            }
+        }
+#endif
+
         // simply return the first available
         // TODO: better method? (newest, oldest, etc.?)
-        map<id_t, MatcherInfo>::iterator it = _matchers.begin ();
+        it = _matchers.begin ();
         for (; it != _matchers.end (); it++)
         {
             MatcherInfo &info = it->second;
@@ -1737,6 +1996,68 @@ namespace Vast
         return false;
     }
 
+#ifdef MATCHER_PLACEMENT_LOCALITY
+    // sort placement demand by weight, heaviest first
+    static bool heavierDemand (const PlacementDemand &a, const PlacementDemand &b)
+    {
+        return a.weight > b.weight;
+    }
+#endif
+
+    // obtain the physical demand of owned subscribers a new matcher at 'join_pos' will take over
+    int
+    VASTMatcher::getPlacementDemand (const Position &join_pos, vector<PlacementDemand> &demand)
+    {
+        demand.clear ();
+
+#ifdef MATCHER_PLACEMENT_LOCALITY
+        if (_VSOpeer == NULL)
+            return 0;
+
+        Position &center = _VSOpeer->getSelf ()->aoi.center;
+
+        // group subscribers by their relays, as clients connect to physically close relays
+        map<id_t, size_t> relay2index;
+
+        map<id_t, Subscription>::iterator it = _subscriptions.begin ();
+        for (; it != _subscriptions.end (); it++)
+        {
+            Subscription &sub = it->second;
+
+            // only owned subscribers on the new matcher's side are taken over
+            if (sub.phys_coord.isEmpty () || 
+                _VSOpeer->isOwner (sub.id) == false ||
+                sub.aoi.center.distanceSquare (join_pos) >= sub.aoi.center.distanceSquare (center))
+                continue;
+
+            map<id_t, size_t>::iterator itr = relay2index.find (sub.relay.host_id);
+            if (itr == relay2index.end ())
+            {
+                relay2index[sub.relay.host_id] = demand.size ();
+                demand.push_back (PlacementDemand ());
+                itr = relay2index.find (sub.relay.host_id);
+            }
+
+            // accumulate coordinates, averaged below
+            PlacementDemand &group = demand[itr->second];
+            group.coord  += sub.phys_coord;
+            group.weight += 1;
+        }
+
+        for (size_t i=0; i < demand.size (); i++)
+            demand[i].coord /= demand[i].weight;
+
+        // keep only the largest groups
+        if (demand.size () > MATCHER_PLACEMENT_DEMAND_MAX)
+        {
+            std::partial_sort (demand.begin (), demand.begin () + MATCHER_PLACEMENT_DEMAND_MAX, demand.end (), heavierDemand);
+            demand.resize (MATCHER_PLACEMENT_DEMAND_MAX);
+        }
+#endif
+
+        return (int)demand.size ();
+    }
+
     // send a message to clients (optional to include the client's hostID for direct message)
     // returns # of targets successfully sent, optional to return failed targets
     int 
@@ -1756,12 +2077,82 @@ namespace Vast
             msg.msggroup = MSG_GROUP_VAST_CLIENT;    
         }
         else
+        {
             msg.msggroup = MSG_GROUP_VAST_RELAY;
 
+#ifdef MATCHER_RELAY_FANOUT
+            // the same content for subscribers at many relays is passed along a tree of relays
+            if (VAST_MSGTYPE (msg.msgtype) == MESSAGE)
+            {
+                int sent = sendFanoutMessage (msg, failed_targets);
+                if (sent > 0)
+                    return sent;
+            }
+#endif
+        }
+
         // NOTE: for messages directed to relays, the network layer will do the translation from targets to relay's hostID
         return sendMessage (msg, failed_targets);    
     }
 
+    // send a message for subscribers at many relays along a tree of relays
+    int
+    VASTMatcher::sendFanoutMessage (Message &msg, vector<id_t> *failed_targets)
+    {
+        // group targets by their relays
+        vector<RelayFanoutNode> relays;
+        map<id_t, size_t>       relay2index;
+        vector<id_t>            others;         // targets whose relays are unknown
+
+        for (size_t i=0; i < msg.targets.size (); i++)
+        {
+            map<id_t, Subscription>::iterator it = _subscriptions.find (msg.targets[i]);
+            if (it == _subscriptions.end ())
+            {
+                others.push_back (msg.targets[i]);
+                continue;
+            }
+
+            Addr &relay = it->second.relay;
+            map<id_t, size_t>::iterator itr = relay2index.find (relay.host_id);
+            if (itr == relay2index.end ())
+            {
+                itr = relay2index.insert (map<id_t, size_t>::value_type (relay.host_id, relays.size ())).first;
+                relays.push_back (RelayFanoutNode ());
+                relays.back ().relay = relay;
+            }
+
+            relays[itr->second].targets.push_back (msg.targets[i]);
+        }
+
+        if (relays.size () < MATCHER_RELAY_FANOUT_MIN)
+            return 0;
+
+        // hand the message & all relays to the relay on this host, which builds the tree
+        Message fanout (msg);
+        fanout.msgtype = (APP_MSGTYPE (msg.msgtype) << VAST_MSGTYPE_RESERVED) | RELAY_FANOUT;
+        fanout.targets.clear ();
+        VASTRelay::storeFanout (fanout, _self.addr, relays, 0, relays.size ());
+
+        id_t host_id = _net->getHostID ();
+        notifyMapping (host_id, &_net->getHostAddress ());
+        fanout.addTarget (host_id);
+
+        if (sendMessage (fanout) == 0)
+            return 0;
+
+        int sent = (int)(msg.targets.size () - others.size ());
+
+        // targets not known as subscribers here are sent the usual way
+        if (others.size () > 0)
+        {
+            msg.targets = others;
+            sent += sendMessage (msg, failed_targets);
+        }
+
+        return sent;
+    }
+
 
     // deal with unsuccessful send targets
     void 
@@ -1908,6 +2299,17 @@ namespace Vast
         
     }
 
+    // obtain the size of an object when copied in full
+    size_t 
+    VASTMatcher::getObjectSize (id_t obj_id)
+    {
+        map<id_t, Subscription>::iterator it = _subscriptions.find (obj_id);
+        if (it == _subscriptions.end ())
+            return 0;
+
+        return it->second.sizeOf ();
+    }
+
     // remove an obsolete unowned object
     bool 
     VASTMatcher::removeObject (id_t obj_id)
@@ -48,6 +48,11 @@
 
 #define SUBSCRIPTION_AOI_BUFFER                (10)     // extended AOI to avoid ghost objects
 
+// load model settings, a matcher is overloaded if any resource exceeds its limit (set to 0 to ignore a resource)
+#define MATCHER_LOAD_CPU_LIMIT                 (0.5)    // fraction of CPU time matcher handlers may use
+#define MATCHER_LOAD_QUEUE_LIMIT               (500)    // # of unprocessed incoming messages
+#define MATCHER_LOAD_BANDWIDTH_FRACTION        (0.8)    // fraction of send / recv quota that may be used
+
 // flag to send NEIGHBOR notices via relay (slower but can test relay correctness)
 // IMPORTANT NOTE: if position updates are not sent via relay, need to make sure
 //                 clients contact relays periodically so relays will not timeout
@@ -56,6 +61,15 @@
 //                              TIMEOUT_REMOVE_CONNECTION   (in VASTnet.h)
 #define SEND_NEIGHBORS_VIA_RELAY_
 
+// flag to pass a message for subscribers at many relays along a tree of relays (see VASTRelay),
+// the matcher then sends it once to the relay on its own host, which sends to only a few relays
+// (remove '_' to enable)
+#define MATCHER_RELAY_FANOUT_
+#define MATCHER_RELAY_FANOUT_MIN                (8)     // min # of relays for a message to be sent along a tree
+
+// NOTE: the flag to place new matchers close to their subscribers (MATCHER_PLACEMENT_LOCALITY) is in Config.h
+#define MATCHER_PLACEMENT_DEMAND_MAX            (16)    // max # of subscriber groups reported for placing a new matcher
+
 using namespace std;
 
 namespace Vast
@@ -76,6 +90,7 @@ namespace Vast
         world_t         world_id;   // world the matcher belongs
         Addr            addr;       // address for matcher        
         timestamp_t     time;       // last update of the info
+        Position        phys_coord; // physical coordinate of the matcher's host (empty if unknown)
     };
 
     class VASTMatcher : public MessageHandler, public VONNetwork, public VSOPolicy
@@ -85,8 +100,10 @@ namespace Vast
 
         // constructor, passing in whether the node can be a matcher candidate, 
         // and what's the threshold considered as overload
-        // optionally a logical coordinate can be supplied as the initial join position
-        VASTMatcher (bool is_matcher, int overload_limit, bool is_static = false, Position *coord = NULL);
+        // optionally a logical coordinate can be supplied as the initial join position,
+        // and the host's send / recv quota (bytes per second, 0 for unlimited)
+        // 'phys_coord' is the host's physical coordinate (kept & refined by VASTRelay)
+        VASTMatcher (bool is_matcher, int overload_limit, bool is_static = false, Position *coord = NULL, size_t send_quota = 0, size_t recv_quota = 0, Position *phys_coord = NULL);
         ~VASTMatcher ();
         
         // join the Matcher overlay for a given world (gateway)
@@ -125,8 +142,12 @@ namespace Vast
         void initHandler ();
 
         // returns whether the message was successfully handled
+        // (also records handling time for load estimation)
         bool handleMessage (Message &in_msg);
 
+        // process a message actually
+        bool processMessage (Message &in_msg);
+
         // performs tasks after all messages are handled
         void postHandling ();
 
@@ -160,7 +181,10 @@ namespace Vast
         //
 
         // get a candidate origin matcher to use (gateway-only)
-        bool findCandidate (Addr &new_origin, float level = 0);
+        bool findCandidate (Addr &new_origin, float level = 0, vector<PlacementDemand> *demand = NULL);
+
+        // obtain the physical demand of owned subscribers a new matcher at 'join_pos' will take over
+        int getPlacementDemand (const Position &join_pos, vector<PlacementDemand> &demand);
 
         // obtain the ID of the gateway node
         id_t getGatewayID ();
@@ -169,6 +193,9 @@ namespace Vast
         // returns # of successful transfer
         int copyObject (id_t target, vector<id_t> &obj_list, bool update_only);
 
+        // obtain the size of an object when copied in full
+        size_t getObjectSize (id_t obj_id);
+
         // remove an obsolete unowned object
         bool removeObject (id_t obj_id);
 
@@ -222,6 +249,10 @@ namespace Vast
 
         // check to call additional matchers for load sharing
         void checkOverload ();
+
+        // combine resource usage in the last second into a normalized load score
+        // (1.0 means the most constrained resource is at its limit)
+        void updateLoadScore ();
         
         // re-send updates of our owned objects so they won't be deleted
         void sendKeepAlive ();
@@ -232,6 +263,9 @@ namespace Vast
         // tell clients updates of their neighbors (changes in other nodes subscribing at same layer)
         void notifyClients (); 
 
+        // authorize direct updates between a subscriber & its mutually visible neighbors, or revoke them
+        void notifyDirectNeighbors (Subscription &sub);
+
         // handle the failure of a origin matcher (gateway-only)
         void originDisconnected (id_t matcher_id);
 
@@ -243,6 +277,10 @@ namespace Vast
         // returns # of targets successfully sent, optional to return failed targets
         int sendClientMessage (Message &msg, id_t client_ID = NET_ID_UNASSIGNED, vector<id_t> *failed_targets = NULL);
 
+        // send a message for subscribers at many relays along a tree of relays
+        // returns # of targets sent, or 0 if there are too few relays (message is not sent)
+        int sendFanoutMessage (Message &msg, vector<id_t> *failed_targets);
+
         // deal with unsuccessful send targets
         void removeFailedSubscribers (vector<id_t> &list);
 
@@ -280,8 +318,11 @@ namespace Vast
 
         map<id_t, id_t>     _closest;           // mapping of subscription to closest alternative matcher
 
+        map<id_t, map<id_t, bool> > _direct;    // neighbors each subscription is authorized to update directly
+
         bool                _is_matcher;        // whether the node can be a matcher candidate
         bool                _is_static;         // whether the current matcher will never move
+        Position *          _phys_coord;        // physical coordinate of this host, NULL if unknown
         int                 _overload_limit;    // # of subscriptions considered overload
         
         timestamp_t         _next_periodic;     // record for next time stamp to process periodic (per-second) tasks
@@ -290,6 +331,17 @@ namespace Vast
 
         int                 _matcher_keepalive; // # of seconds before reporting to gateway of keep alive status
 
+        size_t              _msg_count;         // accumulated # of matcher messages handled (for load forecasting)
+
+        // load accounting
+        size_t              _send_quota;        // send quota of this host (bytes per second)
+        size_t              _recv_quota;        // recv quota of this host (bytes per second)
+        float               _load_score;        // normalized load over all resources, > 1 is overload
+        unsigned long long  _cpu_time;          // time spent in handlers since last load update (microseconds)
+        timestamp_t         _load_time;         // time of last load update
+        size_t              _last_sendsize;     // accumulated send size at last load update
+        size_t              _last_recvsize;     // accumulated recv size at last load update
+
         //
         // origin matcher management (gateway only)
         //
@@ -3,6 +3,7 @@
 
 #include "VASTRelay.h"
 #include "MessageQueue.h"
+#include <algorithm>      // sort
 
 
 using namespace Vast;
@@ -20,6 +21,7 @@ namespace Vast
              _timeout_ping (0),
              _timeout_query (0),
              _timeout_join (0),
+             _timeout_sample (0),
              _ping_all_count (0)
     {     
 
@@ -66,33 +68,40 @@ namespace Vast
         timestamp_t current_time = _net->getTimestamp ();
         msg.store (current_time);
 
-        // ping all known relays
+        // ping some known relays
         if (curr_relay_only == false)
         {
-            // set how many we send PING each time
-            int ping_num = ((int)_relays.size () > MAX_CONCURRENT_PING ? MAX_CONCURRENT_PING : (int)_relays.size ());
-        
-            // obtain list of targets (checking if redundent PING has been sent)
-            vector<bool> random_set;
-            randomSet (ping_num, _relays.size (), random_set);
-        
-            // TODO: should we keep PINGing the same set of hosts, or different?
-            //       which converges faster?
-            map<id_t, Node>::iterator it = _relays.begin ();
-            int i=0;
-            for (; it != _relays.end (); it++)
+            // candidates exclude self & relays with pending PING, 
+            // relays sampled recently (including by their PING to me) are only used if there aren't enough others
+            vector<id_t> stale;
+            vector<id_t> fresh;
+            timestamp_t recent = getSamplePeriod ();
+
+            for (map<id_t, Node>::iterator it = _relays.begin (); it != _relays.end (); it++)
             {
-                // skip relays not chosen this time
-                // NOTE: actual contact relays may be less than desired, if the target is already contacted
-                if (random_set[i++] == false)
-                    continue;
-        
-                // avoid self & check for redundency
                 id_t target = it->first;
-                if (_self.id != target && _pending.find (target) == _pending.end ())
+                if (_self.id == target || _pending.find (target) != _pending.end ())
+                    continue;
+
+                map<id_t, RTTFilter>::iterator itr = _rtt.find (target);
+                if (itr != _rtt.end () && current_time - itr->second.last_sample < recent)
+                    fresh.push_back (target);
+                else
+                    stale.push_back (target);
+            }
+
+            // pick randomly, stale ones first
+            int ping_num = getSampleSize ();
+            for (int k=0; k < 2 && ping_num > 0; k++)
+            {
+                vector<id_t> &list = (k == 0 ? stale : fresh);
+                for (size_t i=0; i < list.size () && ping_num > 0; i++, ping_num--)
                 {
-                    msg.addTarget (target);
-                    _pending[target] = current_time;             
+                    size_t j = i + (size_t)rand () % (list.size () - i);
+                    std::swap (list[i], list[j]);
+
+                    msg.addTarget (list[i]);
+                    _pending[list[i]] = current_time;
                 }
             }
         }
@@ -117,7 +126,8 @@ namespace Vast
             return false;
         }
         
-        if (curr_relay_only == false)            
+        // only rounds for the initial coordinate count towards forced convergence
+        if (curr_relay_only == false && _state != JOINED)
             _request_times++;
 
         // success means at least a few PING requests are sent
@@ -192,6 +202,34 @@ namespace Vast
     {
         return (int)_clients.size ();
     }
+
+    // obtain the error estimate of my physical coordinate
+    float
+    VASTRelay::getCoordinateError ()
+    {
+        return _error;
+    }
+
+    // # of relays to PING in a round, once joined a single relay is probed per round
+    // (only how often it is done varies with my coordinate error, see getSamplePeriod ())
+    int
+    VASTRelay::getSampleSize ()
+    {
+        if (_state != JOINED)
+            return MAX_CONCURRENT_PING;
+
+        return 1;
+    }
+
+    // time between rounds of PING once joined, longer as my coordinate error gets smaller
+    timestamp_t
+    VASTRelay::getSamplePeriod ()
+    {
+        float ratio = (_error >= RELAY_TOLERANCE ? 1.0f : _error / RELAY_TOLERANCE);
+        float period = TIMEOUT_COORD_QUERY - (TIMEOUT_COORD_QUERY - KEEPALIVE_RELAY) * ratio;
+
+        return (timestamp_t)(period * _net->getTimestampPerSecond ());
+    }
 
     // perform initialization tasks for this handler (optional)
     // NOTE that all internal variables (such as handler_no) have been set at this point
@@ -267,6 +305,12 @@ namespace Vast
                 }
                 
                 // call the Vivaldi algorithm to update my physical coordinate
+                // NOTE: both PONG (to my PING) & PONG_2 (to others' PING) give a sample,
+                //       samples are filtered only for known relays (whose filters are removed in removeRelay)
+                //       so that PONGs from clients won't leave filters behind
+                if (_relays.find (in_msg.from) != _relays.end ())
+                    rtt = _rtt[in_msg.from].add (rtt, current);
+
                 vivaldi (rtt, _temp_coord, xj, _error, ej);
 
 #ifdef DEBUG_DETAIL
@@ -276,11 +320,15 @@ namespace Vast
 
                 // if remote host is a relay, record its coordinates                
                 if (_relays.find (in_msg.from) != _relays.end ())
+                {
                     _relays[in_msg.from].aoi.center = xj;
+                    _relay_grid.update (in_msg.from, xj);
+                }
 
                 // if the local error value is small enough, we've got our physical coordinate
                 // or we force the convergence if too many queries are sent
-                if (_error < RELAY_TOLERANCE || _request_times > MAX_RELAY_QUERIES)
+                // once joined, refinements are always applied (so the coordinate stays valid)
+                if (_error < RELAY_TOLERANCE || _request_times > MAX_RELAY_QUERIES || _state == JOINED)
                 {
                     // print a small message to show it
                     if (_request_times > 0)
@@ -536,80 +584,114 @@ namespace Vast
             }
             break;
 
+        // a message for subscribers at many relays (from a matcher on this host), 
+        // or a message passed down a fan-out tree from another relay
+        case RELAY_FANOUT:
+        case RELAY_FANOUT_TREE:
+            {
+                if (extractFanout (in_msg, _fanout_origin, _fanout) == false)
+                {
+                    printf ("VASTRelay: cannot extract relays of fan-out message from [%llu]\n", in_msg.from);
+                    break;
+                }
+
+                // relays are given as a flat list by a matcher, build a tree rooted at myself
+                if (in_msg.msgtype == RELAY_FANOUT)
+                    buildFanoutTree (_fanout);
+
+                // NOTE must send to remote first before local, as sendtime will be extracted by local host
+                //      and the message structure will get changed
+
+                // pass the message down to each subtree, the first relay listed is myself
+                for (size_t i=1; i < _fanout.size (); i += _fanout[i].subtree)
+                    sendFanout (in_msg, app_msgtype, _fanout_origin, _fanout, i);
+
+                // deliver to my own clients
+                if (_fanout.size () > 0 && _fanout[0].targets.size () > 0)
+                {
+                    in_msg.targets  = _fanout[0].targets;
+                    in_msg.msgtype  = MESSAGE;
+                    return deliverMessage (in_msg, app_msgtype);
+                }
+            }
+            break;
+
         // assume all other messages are forwardwd messages 
         // receiving a forwarded message (source can be either PUBLISH or SEND) or NEIGHBOR
         default:
-        //case MESSAGE:
-        //case NEIGHBOR:
-            {
-                // forward message to clients 
-
-                // NOTE must send to remote first before local, as sendtime will be extracted by local host
-                //      and the message structure will get changed
-                
-                // store back app-specific message type
-                if (in_msg.msgtype == MESSAGE)
-                    in_msg.msgtype = (app_msgtype << VAST_MSGTYPE_RESERVED) | MESSAGE;
-                                                
-                // translate targets to actual client hostID 
-                vector<id_t> clients;
-                vector<id_t> unknown_clients;
-                
-                for (size_t i=0; i < in_msg.targets.size (); i++)
-                {
-                    id_t target = in_msg.targets[i];
-
-                    // mapping of subscription to clientID found
-                    if (_sub2client.find (target) != _sub2client.end ())
-                        clients.push_back (_sub2client[target]);
-
-                    // check for message to self 
-                    else if (target == _net->getHostID ())
-                    {
-                        clients.push_back (target);
-                    }
-                    else
-                    {
-                        // record unresolved client targets
-                        printf ("VASTRelay: cannot translate received subscriptionID [%llu] to clientID\n", target);
-                        unknown_clients.push_back (target);                        
-                    }
-                }
-
-                // all forward messages are addressed to clients
-                in_msg.msggroup = MSG_GROUP_VAST_CLIENT;
-                
-                // store unknown clients
-                timestamp_t now = _net->getTimestamp ();                
-                for (size_t i=0; i < unknown_clients.size (); i++)
-                {
-                    in_msg.targets.clear ();
-                    in_msg.addTarget (unknown_clients[i]);
-
-                    // store a copy of the message into queue, also record the time
-                    _queue.insert (multimap<id_t, Message *>::value_type (unknown_clients[i], new Message (in_msg)));
-                    _queue_time[unknown_clients[i]] = now + (KEEPALIVE_RELAY * _net->getTimestampPerSecond ());
-                }
-                                
-                // use the converted client hostID
-                if (clients.size () > 0)
-                {
-                    in_msg.targets = clients;
-                    
-                    sendMessage (in_msg);
-                }
-                else
-                {
-                    printf ("VASTRelay: cannot forward message, message type: %d\n", in_msg.msgtype);
-                    return false;                        
-                }
-            }
+        //case MESSAGE:
+        //case NEIGHBOR:
+            {
+                // NOTE must send to remote first before local, as sendtime will be extracted by local host
+                //      and the message structure will get changed
+                return deliverMessage (in_msg, app_msgtype);
+            }
             break;
         }
 
         return true;
     }
 
+    // deliver a message to the clients of its targets (subscription IDs)
+    bool 
+    VASTRelay::deliverMessage (Message &msg, msgtype_t app_msgtype)
+    {
+        // store back app-specific message type
+        if (msg.msgtype == MESSAGE)
+            msg.msgtype = (app_msgtype << VAST_MSGTYPE_RESERVED) | MESSAGE;
+                                        
+        // translate targets to actual client hostID 
+        vector<id_t> clients;
+        vector<id_t> unknown_clients;
+        
+        for (size_t i=0; i < msg.targets.size (); i++)
+        {
+            id_t target = msg.targets[i];
+            map<id_t, id_t>::iterator it = _sub2client.find (target);
+
+            // mapping of subscription to clientID found
+            if (it != _sub2client.end ())
+                clients.push_back (it->second);
+
+            // check for message to self 
+            else if (target == _net->getHostID ())
+            {
+                clients.push_back (target);
+            }
+            else
+            {
+                // record unresolved client targets
+                printf ("VASTRelay: cannot translate received subscriptionID [%llu] to clientID\n", target);
+                unknown_clients.push_back (target);                        
+            }
+        }
+
+        // all forward messages are addressed to clients
+        msg.msggroup = MSG_GROUP_VAST_CLIENT;
+        
+        // store one copy of the message for all unknown clients, to be forwarded once mapping is known
+        if (unknown_clients.size () > 0)
+        {
+            timestamp_t expire = _net->getTimestamp () + (KEEPALIVE_RELAY * _net->getTimestampPerSecond ());
+            _queue.push (msg, unknown_clients, expire);
+        }
+                        
+        // use the converted client hostID
+        if (clients.size () > 0)
+        {
+            msg.targets = clients;
+            
+            sendMessage (msg);
+        }
+        else
+        {
+            printf ("VASTRelay: cannot forward message, message type: %d\n", msg.msgtype);
+            return false;                        
+        }
+
+        return true;
+    }
+
     // performs some tasks the need to be done after all messages are handled
     // such as neighbor discovery checks
     void 
@@ -661,8 +743,29 @@ namespace Vast
 
                 //ping (curr_relay_only);
 
-                // we only ping current relay once joined (to reduce PING traffic)
-                ping (isJoined ());
+                // once joined, some relays are PINGed to refine physical coordinate,
+                // less often & fewer of them as the coordinate error gets smaller
+                if (isJoined () && now >= _timeout_sample)
+                {
+                    _timeout_sample = now + getSamplePeriod ();
+                    ping ();
+                }
+
+                // otherwise we only ping current relay once joined (to reduce PING traffic)
+                // NOTE: the network layer keeps the current relay connection alive (with heartbeats
+                //       if nothing else is sent), so PING is skipped if the relay is heard recently
+                else if (isJoined ())
+                {
+                    if (isRelay () == false && _curr_relay != NULL)
+                    {
+                        _net->keepAlive (_curr_relay->id);
+
+                        if (_net->isAlive (_curr_relay->id, KEEPALIVE_RELAY) == false)
+                            ping (true);
+                    }
+                }
+                else
+                    ping ();
                                
                 /*
                 else if (send_maintain)
@@ -673,15 +776,7 @@ namespace Vast
                 */
 
                 // remove unforwarded messages that are expired
-                vector<id_t> remove_list;
-                map<id_t, timestamp_t>::iterator it = _queue_time.begin ();
-                for (; it != _queue_time.end (); it++)
-                    if (now > it->second)
-                        remove_list.push_back (it->first);
-
-                // remove each unforwarded messages
-                for (size_t i=0; i < remove_list.size (); i++)
-                    forwardMessage (remove_list[i]);
+                _queue.expire (now);
             }
         }
         
@@ -806,19 +901,27 @@ namespace Vast
 
         double min_dist = _self.aoi.center.distance (pos);
 
+        // only relays as close as the nearest known relay (or myself) can qualify
+        vector<id_t> candidates;
+        if (_relay_grid.getNearest (pos, 1, candidates) > 0)
+        {
+            double nearest = _relays[candidates[0]].aoi.center.distance (pos);
+            _relay_grid.getWithin (pos, (length_t)((nearest < min_dist ? nearest : min_dist) + EQUAL_DISTANCE), candidates);
+        }
+
         // find closest among known neighbors
-        multimap<double, Node *>::iterator it = _dist2relay.begin ();
-        for (; it != _dist2relay.end (); it++)
+        for (size_t i=0; i < candidates.size (); i++)
         {
             // NOTE: it's important if distance is equal or very close, then 
             //       there's a second way to determine ordering (i.e., by ID)
             //       otherwise the query may be thrown in circles
 
-            double dist = it->second->aoi.center.distance (pos);
+            Node *relay = &_relays[candidates[i]];
+            double dist = relay->aoi.center.distance (pos);
             if (dist < min_dist || 
-                ((dist - min_dist < EQUAL_DISTANCE) && (it->second->id < closest->id)))
+                ((dist - min_dist < EQUAL_DISTANCE) && (relay->id < closest->id)))
             {
-                closest     = it->second;
+                closest     = relay;
                 min_dist    = dist;
             }            
         }
@@ -844,15 +947,12 @@ namespace Vast
         }
         else
         {
-            // begin looping to find the next available relay in terms of distance to self
-            multimap<double, Node *>::iterator it = _dist2relay.begin ();
-            
-            // find the next closest
-            for (; it != _dist2relay.end (); it++)
-            {
-                if (it->second->id == _contact_relay->id)
-                    break;
-            }
+            // find the next available relay in terms of distance to self
+            multimap<double, Node *>::iterator it = _dist2relay.end ();
+
+            map<id_t, multimap<double, Node *>::iterator>::iterator it_dist = _relay2dist.find (_contact_relay->id);
+            if (it_dist != _relay2dist.end ())
+                it = it_dist->second;
         
             // find next available
             if (it != _dist2relay.end ())
@@ -897,14 +997,12 @@ namespace Vast
             it->second = relay;
 
             // erase distance record            
-            for (multimap<double, Node *>::iterator it = _dist2relay.begin (); it != _dist2relay.end (); it++)
+            map<id_t, multimap<double, Node *>::iterator>::iterator it_dist = _relay2dist.find (relay.id);
+            if (it_dist != _relay2dist.end ())
             {
-                if (it->second->id == relay.id)
-                {                
-                    _dist2relay.erase (it);                
-                    break;
-                }
-            }           
+                _dist2relay.erase (it_dist->second);
+                _relay2dist.erase (it_dist);
+            }
         }
         else
         {
@@ -916,7 +1014,8 @@ namespace Vast
 
         _relays[relay.id].time = _net->getTimestamp ();
 
-        _dist2relay.insert (multimap<double, Node *>::value_type (dist, &(_relays[relay.id])));
+        _relay2dist[relay.id] = _dist2relay.insert (multimap<double, Node *>::value_type (dist, &(_relays[relay.id])));
+        _relay_grid.update (relay.id, relay.aoi.center);
         notifyMapping (relay.id, &relay.addr);
     }
     
@@ -942,23 +1041,22 @@ namespace Vast
 
         //double dist = it_relay->second.aoi.center.distance (_self.aoi.center);
 
-        multimap<double, Node *>::iterator it = _dist2relay.begin ();
-        for (; it != _dist2relay.end (); it++)
+        map<id_t, multimap<double, Node *>::iterator>::iterator it = _relay2dist.find (id);
+        if (it != _relay2dist.end ())
         {
-            if (it->second->id == id)
-            {
 #ifdef DEBUG_DETAIL
-                printf ("[%lld] VASTRelay::removeRelay () removing relay [%lld]..\n", _self.id, id);
+            printf ("[%lld] VASTRelay::removeRelay () removing relay [%lld]..\n", _self.id, id);
 #endif
                 
-                _dist2relay.erase (it);                
-                _relays.erase (id);
-                break;
-            }
+            _dist2relay.erase (it->second);                
+            _relay2dist.erase (it);
+            _relay_grid.remove (id);
+            _relays.erase (id);
         }
 
-        // also erase the pending tracker
+        // also erase the pending tracker & RTT samples
         _pending.erase (id);
+        _rtt.erase (id);
 
         // if no relays exist, need to re-create relays
         if (_relays.size () == 0)
@@ -1164,36 +1262,257 @@ namespace Vast
         }
     }
 
-    // forward a message meant for client 'sub_id', to an actual client host
-    // if host_id is not provided then the message is simply removed
+    // forward messages held for client 'sub_id', to an actual client host
     int
     VASTRelay::forwardMessage (id_t sub_id, id_t host_id)
     {
-        multimap<id_t, Message *>::iterator it; 
-        int processed = 0;
-        
-        while ((it = _queue.find (sub_id)) != _queue.end ())
-        {
-            // if client host is provided, forward it
-            if (host_id != NET_ID_UNASSIGNED)
-            {
-                Message *msg = it->second;
-                msg->targets.clear ();
-                msg->addTarget (host_id);
-                msg->msggroup = MSG_GROUP_VAST_CLIENT;
-
-                sendMessage (*msg);
-            }
-
-            _queue_time.erase (sub_id);
-
-            delete it->second;                                        
-            _queue.erase (it);
-
-            processed++;
+        _forwards.clear ();
+        if (_queue.pop (sub_id, _forwards) == 0)
+            return 0;
+
+        // NOTE: messages are sent back-to-back into the same send buffer of the client host,
+        //       so they go out together at the next flush
+        for (size_t i=0; i < _forwards.size (); i++)
+        {
+            // a held message may be shared with other subscribers, so its targets are reset each time
+            Message *msg = _forwards[i]->msg;
+            msg->targets.clear ();
+            msg->addTarget (host_id);
+            msg->msggroup = MSG_GROUP_VAST_CLIENT;
+
+            sendMessage (*msg);
+
+            _queue.release (_forwards[i]);
+        }
+
+        return (int)_forwards.size ();
+    }
+
+    // append relays of a fan-out tree (nodes [first, first + count)) to the end of a message
+    bool 
+    VASTRelay::storeFanout (Message &msg, Addr &origin, vector<RelayFanoutNode> &nodes, size_t first, size_t count)
+    {
+        Message tree (0);
+
+        if (first + count > nodes.size ())
+            return false;
+
+        tree.store (origin);
+        tree.store ((uint32_t)count);
+        for (size_t i = first; i < first + count; i++)
+        {
+            RelayFanoutNode &node = nodes[i];
+
+            tree.store (node.relay);
+            tree.store ((uint32_t)node.subtree);
+            tree.store ((uint32_t)node.targets.size ());
+            for (size_t j=0; j < node.targets.size (); j++)
+                tree.store (node.targets[j]);
+        }
+
+        // the size of the tree is stored last, so it can be extracted from the end first
+        return (msg.store (tree.data, tree.size) && msg.store ((uint32_t)tree.size));
+    }
+
+    // remove relays of a fan-out tree from the end of a message
+    bool 
+    VASTRelay::extractFanout (Message &msg, Addr &origin, vector<RelayFanoutNode> &nodes)
+    {
+        nodes.clear ();
+
+        uint32_t size = 0;
+        if (msg.extract ((char *)&size, sizeof (uint32_t), true) != sizeof (uint32_t) || size > msg.size)
+            return false;
+
+        char *buf = new char[size];
+        msg.extract (buf, size, true);
+        Message tree (0, buf, size, false);
+
+        uint32_t count = 0;
+        bool success = (tree.extract (origin) != 0 &&
+                        tree.extract ((char *)&count, sizeof (uint32_t)) == sizeof (uint32_t));
+
+        for (uint32_t i=0; success && i < count; i++)
+        {
+            nodes.push_back (RelayFanoutNode ());
+            RelayFanoutNode &node = nodes.back ();
+
+            uint32_t n = 0;
+            if (tree.extract (node.relay) == 0 ||
+                tree.extract ((char *)&node.subtree, sizeof (uint32_t)) == 0 ||
+                tree.extract ((char *)&n, sizeof (uint32_t)) == 0)
+            {
+                success = false;
+                break;
+            }
+
+            // each target needs sizeof (id_t) bytes, guard against a corrupted count
+            if ((size_t)n * sizeof (id_t) > size)
+            {
+                success = false;
+                break;
+            }
+
+            node.targets.resize (n);
+            for (size_t j=0; success && j < n; j++)
+                success = (tree.extract ((char *)&node.targets[j], sizeof (id_t)) != 0);
+        }
+
+        // subtree sizes must stay within the tree
+        for (size_t i=0; success && i < nodes.size (); i++)
+            success = (nodes[i].subtree >= 1 && i + nodes[i].subtree <= nodes.size ());
+
+        delete[] buf;
+
+        return success;
+    }
+
+    // turn a list of relays (each with its subscribers) into a tree rooted at myself
+    void 
+    VASTRelay::buildFanoutTree (vector<RelayFanoutNode> &nodes)
+    {
+        id_t self_id = _net->getHostID ();
+
+        // the root is myself, with subscribers at my own clients
+        vector<RelayFanoutNode> tree (1);
+        tree[0].relay = _net->getHostAddress ();
+
+        vector<size_t> members;
+        for (size_t i=0; i < nodes.size (); i++)
+        {
+            if (nodes[i].relay.host_id == self_id)
+                tree[0].targets.insert (tree[0].targets.end (), nodes[i].targets.begin (), nodes[i].targets.end ());
+            else
+                members.push_back (i);
+        }
+
+        addFanoutChildren (nodes, members, _temp_coord, tree);
+        tree[0].subtree = (uint32_t)tree.size ();
+
+        nodes.swap (tree);
+    }
+
+    // add 'members' (indices of 'nodes') as the subtrees of a relay at 'center'
+    void 
+    VASTRelay::addFanoutChildren (vector<RelayFanoutNode> &nodes, vector<size_t> &members, const Position &center, vector<RelayFanoutNode> &tree)
+    {
+        if (members.size () == 0)
+            return;
+
+        // sort members by distance to the center, relays of unknown coordinates go last
+        // NOTE: the sort key is (distance, relay ID) so the same tree is built given the same relays
+        vector<pair<pair<coord_t, id_t>, size_t> > sorted;
+        vector<Position> coords (members.size ());
+        vector<bool>     known (members.size ());
+        for (size_t i=0; i < members.size (); i++)
+        {
+            known[i] = getRelayCoordinate (nodes[members[i]].relay.host_id, coords[i]);
+            coord_t dist = (known[i] ? center.distance (coords[i]) : (coord_t)(-1));
+            sorted.push_back (pair<pair<coord_t, id_t>, size_t> (pair<coord_t, id_t> (dist, nodes[members[i]].relay.host_id), i));
+        }
+
+        // NOTE: unknown coordinates have negative distance, put them last
+        for (size_t i=0; i < sorted.size (); i++)
+            if (sorted[i].first.first < 0)
+                sorted[i].first.first = (coord_t)(1e30);
+
+        std::sort (sorted.begin (), sorted.end ());
+
+        // the closest relays become children, each of the rest joins the closest child that still has room,
+        // so that subtrees are of similar sizes & the tree stays shallow
+        size_t degree = (members.size () < (size_t)RELAY_FANOUT_DEGREE ? members.size () : (size_t)RELAY_FANOUT_DEGREE);
+        size_t rest   = members.size () - degree;
+        size_t room   = (rest + degree - 1) / degree;
+
+        vector<vector<size_t> > assigned (degree);
+        for (size_t k = degree; k < sorted.size (); k++)
+        {
+            size_t m = sorted[k].second;
+            size_t best = degree;
+            coord_t best_dist = 0;
+
+            for (size_t c=0; c < degree; c++)
+            {
+                if (assigned[c].size () >= room)
+                    continue;
+
+                size_t child = sorted[c].second;
+                coord_t dist = ((known[m] && known[child]) ? coords[m].distance (coords[child]) : 0);
+
+                if (best == degree || dist < best_dist)
+                {
+                    best = c;
+                    best_dist = dist;
+                }
+            }
+
+            assigned[best].push_back (members[m]);
+        }
+
+        for (size_t c=0; c < degree; c++)
+        {
+            size_t child = sorted[c].second;
+            size_t pos   = tree.size ();
+
+            tree.push_back (nodes[members[child]]);
+            addFanoutChildren (nodes, assigned[c], (known[child] ? coords[child] : center), tree);
+            tree[pos].subtree = (uint32_t)(tree.size () - pos);
+        }
+    }
+
+    // physical coordinate of a known relay, returns false if unknown
+    bool 
+    VASTRelay::getRelayCoordinate (id_t id, Position &coord)
+    {
+        map<id_t, Node>::iterator it = _relays.find (id);
+        if (it == _relays.end ())
+            return false;
+
+        coord = it->second.aoi.center;
+        return true;
+    }
+
+    // send a message down to the subtree rooted at nodes[i]
+    void 
+    VASTRelay::sendFanout (Message &msg, msgtype_t app_msgtype, Addr &origin, vector<RelayFanoutNode> &nodes, size_t i)
+    {
+        RelayFanoutNode &node = nodes[i];
+
+        Message subtree (msg);
+        subtree.msgtype  = (app_msgtype << VAST_MSGTYPE_RESERVED) | RELAY_FANOUT_TREE;
+        subtree.msggroup = MSG_GROUP_VAST_RELAY;
+        subtree.targets.clear ();
+        storeFanout (subtree, origin, nodes, i, node.subtree);
+
+        notifyMapping (node.relay.host_id, &node.relay);
+        subtree.addTarget (node.relay.host_id);
+
+        if (sendMessage (subtree) > 0)
+            return;
+
+        // repair the tree: the relay cannot be reached, so its own subscribers are reported back 
+        // to the sending matcher (as failed send targets) and its children are sent to directly
+        printf ("VASTRelay::sendFanout () relay [%llu] unreachable, reporting %lu subscribers & sending to its children\n", node.relay.host_id, (unsigned long)node.targets.size ());
+
+        if (node.targets.size () > 0)
+        {
+            Message failed (RELAY_FANOUT_FAILED);
+            failed.priority = 1;
+            failed.msggroup = MSG_GROUP_VAST_MATCHER;
+
+            for (size_t j=0; j < node.targets.size (); j++)
+                failed.store (node.targets[j]);
+
+            listsize_t n = (listsize_t)node.targets.size ();
+            failed.store (n);
+
+            notifyMapping (origin.host_id, &origin);
+            failed.addTarget (origin.host_id);
+            sendMessage (failed);
         }
 
-        return processed;
+        for (size_t j = i + 1; j < i + node.subtree; j += nodes[j].subtree)
+            sendFanout (msg, app_msgtype, origin, nodes, j);
     }
 
     // recalculate my physical coordinate estimation (using Vivaldi)
@@ -103,6 +103,10 @@ namespace Vast
  
         printf ("\nVASTThread svc (): time_budget: %lu us ticks_persec: %d\n\n", time_budget, _ticks_persec);
 
+#ifdef VASTTHREAD_EVENT_DRIVEN
+        tickByEvents (time_budget);
+#endif
+
         // entering main loop
         while (_active)
         {   
@@ -141,6 +145,64 @@ namespace Vast
             _down_cond->signal ();
 
         return 0;
-    }
-
+    }
+
+    // wake up when messages arrive or a tick is due, instead of sleeping a fixed time per tick
+    // returns when the thread is stopped
+    void
+    VASTThread::tickByEvents (size_t time_budget)
+    {
+        VASTVerse *world = (VASTVerse *)_world;
+        TimeMonitor *timer = TimeMonitor::instance ();
+
+        unsigned long long now          = timer->getTime ();
+        unsigned long long next_tick    = now;      // when the next tick is due
+        unsigned long long last_input   = 0;        // when input was last processed
+
+        while (_active)
+        {
+            now = timer->getTime ();
+
+            // perform a full tick (per-tick & per-second tasks) when due, 
+            // and send out what the callback has queued right away
+            if (now >= next_tick)
+            {
+                bool per_sec = false;
+                world->tick ((int)time_budget, &per_sec);
+                world->flushOutput ();
+
+                // ticks missed are skipped rather than made up
+                next_tick += time_budget;
+                if (next_tick <= now)
+                    next_tick = now + time_budget;
+
+                last_input = timer->getTime ();
+                continue;
+            }
+
+            // wait for input until the next tick is due
+            int result = world->waitInput ((int)(next_tick - now));
+
+            // waiting not supported (e.g. emulated network), sleep out the tick
+            if (result == -1)
+            {
+                ACE_Time_Value duration (0, (long)(next_tick - now));
+                ACE_OS::sleep (duration);
+            }
+            else if (result == 1)
+            {
+                // let input that arrives close together be processed together
+                now = timer->getTime ();
+                if (now < last_input + VASTTHREAD_COALESCE_TIME && last_input + VASTTHREAD_COALESCE_TIME < next_tick)
+                {
+                    ACE_Time_Value duration (0, (long)(last_input + VASTTHREAD_COALESCE_TIME - now));
+                    ACE_OS::sleep (duration);
+                }
+
+                world->processInput ((int)time_budget);
+                last_input = timer->getTime ();
+            }
+        }
+    }
+
 } // namespace Vast
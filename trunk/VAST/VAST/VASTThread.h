@@ -39,6 +39,8 @@
 #include "VASTUtil.h"               // TimeMonitor
 
 
+#define VASTTHREAD_COALESCE_TIME    (1000)  // min. # of microseconds between processing input, so bursts are processed together
+
 using namespace std;
 
 namespace Vast
@@ -83,6 +85,9 @@ namespace Vast
 
     private:
 
+        // wake up when messages arrive or a tick is due, instead of sleeping a fixed time per tick
+        void tickByEvents (size_t time_budget);
+
         int         _ticks_persec;      // # of ticks this thread should execute per second
 
         bool        _active;            // whether the currnet play thread is alive.
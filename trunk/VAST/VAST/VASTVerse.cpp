@@ -49,6 +49,8 @@ namespace Vast
             matcher     = NULL;
             callback    = NULL;
             thread      = NULL;
+            profiler    = NULL;
+            host        = NULL;
         }
 
         VASTnet *       net;            // network interface
@@ -58,22 +60,29 @@ namespace Vast
         VASTMatcher *   matcher;        // a relay node to the network
         VASTCallback *  callback;       // callback for processing incoming app messages
         VASTThread *    thread;         // thread for running a VASTNode
+        Profiler *      profiler;       // timing of tick () sections, handlers & message types
+        VASTHost *      host;           // host running this VASTVerse, if any
     };
 
+    // # of VASTVerse alive in this process (global instances are released with the last one)
+    size_t              g_verse_count = 0;
+    ACE_Thread_Mutex    g_verse_mutex;
+
     //
     //  Internal helper functions
     //
    
     VASTnet *
-    createNet (unsigned short port, VASTPara_Net &para, vector<IPaddr> &entries, int step_persec)
+    createNet (unsigned short port, VASTPara_Net &para, vector<IPaddr> &entries, VASTPara_Sim &simpara, net_ace_reactor *reactor)
     {
+        int step_persec = simpara.step_persec;
         if (step_persec == 0)
         {
             printf ("VASTnet::createNet () steps per second not specified, set to default: 10\n");
             step_persec = 10;
         }
 
-        VASTnet *net = new VASTnet (para.model, port, step_persec);
+        VASTnet *net = new VASTnet (para.model, port, step_persec, reactor, &simpara);
 
         // store initial entry points
         net->addEntries (entries);
@@ -81,6 +90,8 @@ namespace Vast
 		net->setBandwidthLimit (BW_UPLOAD,   para.send_quota / step_persec);
 		net->setBandwidthLimit (BW_DOWNLOAD, para.recv_quota / step_persec);
 
+        net->setConnectionLimit (para.conn_limit > 0 ? (size_t)para.conn_limit : 0);
+
         return net;
     }
 
@@ -95,9 +106,13 @@ namespace Vast
     }
     
     VASTVerse::
-    VASTVerse (bool is_gateway, const string &GWstr, VASTPara_Net *netpara, VASTPara_Sim *simpara, VASTCallback *callback, int tick_persec)
+    VASTVerse (bool is_gateway, const string &GWstr, VASTPara_Net *netpara, VASTPara_Sim *simpara, VASTCallback *callback, int tick_persec, VASTHost *host)
         :_netpara (*netpara)
     {
+        g_verse_mutex.acquire ();
+        g_verse_count++;
+        g_verse_mutex.release ();
+
         _state = ABSENT;
         _lastsend = _lastrecv = 0;
         _next_periodic = 0;
@@ -132,9 +147,24 @@ namespace Vast
         // store callback, if any
         VASTPointer *handlers   = (VASTPointer *)_pointers;
         handlers->callback      = callback;
-        
+        handlers->profiler      = new Profiler ();
+
+        // emulated networks are ticked by the simulator along with its logical clock
+        if (host != NULL && _netpara.model != VAST_NET_ACE)
+        {
+            printf ("VASTVerse::VASTVerse () only ACE network model can be hosted, host ignored\n");
+            host = NULL;
+        }
+
+        // let the host tick us with its own threads
+        if (host != NULL)
+        {
+            handlers->host = host;
+            host->attach (this);
+        }
+
         // start thread if both callback & tick_persec is specified
-        if (callback && tick_persec > 0)
+        else if (callback && tick_persec > 0)
         {
             printf ("starting thread..\n");
             handlers->thread = new VASTThread (tick_persec);
@@ -147,6 +177,13 @@ namespace Vast
     {
         VASTPointer *handlers = (VASTPointer *)_pointers;
 
+        // stop being ticked by the host (returns after any ongoing tick is done)
+        if (handlers->host != NULL)
+        {
+            handlers->host->detach (this);
+            handlers->host = NULL;
+        }
+
         // stop the running thread
         if (handlers->thread != NULL)
         {
@@ -197,11 +234,17 @@ namespace Vast
             handlers->net = NULL;
         }        
 
+        delete handlers->profiler;
+        handlers->profiler = NULL;
+
         delete (VASTPointer *)_pointers;
         _pointers = NULL;
 
-        // destory TimeMonitor
-        TimeMonitor::terminateInstance ();
+        // destory TimeMonitor, if we're the last VASTVerse
+        g_verse_mutex.acquire ();
+        if (--g_verse_count == 0)
+            TimeMonitor::terminateInstance ();
+        g_verse_mutex.release ();
 
     }
 
@@ -289,12 +332,13 @@ namespace Vast
             printf ("VASTVerse::isInitialized () creating VASTnet...\n");
 
             // create network layer
-            handlers->net = createNet (_netpara.port, _netpara, _entries, _simpara.step_persec);
+            handlers->net = createNet (_netpara.port, _netpara, _entries, _simpara, (handlers->host != NULL ? handlers->host->getReactor () : NULL));
             if (handlers->net == NULL)
                 return false;
 
             printf ("VASTVerse::isInitialized () creating MessageQueue...\n");
             handlers->msgqueue = new MessageQueue (handlers->net);
+            handlers->msgqueue->setProfiler (handlers->profiler);
         }
 
         // wait for the network layer to join properly
@@ -338,7 +382,7 @@ namespace Vast
             printf ("[%llu] physical coord: (%.3f, %.3f)\n", handlers->net->getHostID (), physcoord->x, physcoord->y);
 
             // create (idle) 'matcher' instance
-            handlers->matcher = new VASTMatcher (_netpara.is_matcher, _netpara.overload_limit, _netpara.is_static, (_netpara.matcher_coord.isEmpty () ? NULL : &_netpara.matcher_coord));
+            handlers->matcher = new VASTMatcher (_netpara.is_matcher, _netpara.overload_limit, _netpara.is_static, (_netpara.matcher_coord.isEmpty () ? NULL : &_netpara.matcher_coord), _netpara.send_quota, _netpara.recv_quota, physcoord);
             handlers->msgqueue->registerHandler (handlers->matcher);            
             return true;
         }
@@ -455,6 +499,9 @@ namespace Vast
 
         VASTPointer *handlers = (VASTPointer *)_pointers;
 
+        // time the whole tick, if profiling is enabled
+        ProfileScope tick_scope (handlers->profiler, PROFILE_TICK);
+
         // # of ticks a joining stage is considered timeout
         timestamp_t timeout_period = (handlers->net != NULL ? (VASTVERSE_RETRY_PERIOD * handlers->net->getTimestampPerSecond ()) : 0);
 
@@ -579,6 +626,7 @@ namespace Vast
         // call callback to perform per-tick task, if any
         if (handlers->callback)
         {
+            ProfileScope scope (handlers->profiler, PROFILE_CALLBACK);
             handlers->callback->performPerTickTasks ();
         }
 
@@ -617,6 +665,7 @@ namespace Vast
                 // call callback to perform per-second task, if any
                 if (handlers->callback)
                 {
+                    ProfileScope scope (handlers->profiler, PROFILE_CALLBACK);
                     handlers->callback->performPerSecondTasks (now);
                 }
             }
@@ -624,36 +673,7 @@ namespace Vast
             //
             // process incoming messages by calling app-specific message handlers, if any
             //
-            
-            // process incoming socket messages 
-            // NOTE: the we don't have to join in order to process
-            if (handlers->callback)
-            {
-                char *socket_msg = NULL;
-                id_t socket_id;
-                size_t size;
-                
-                while ((socket_msg = handlers->net->receiveSocket (socket_id, size)) != NULL)
-                {
-                    // if the callback cannot handle or does not wish to process more, stop
-                    if (handlers->callback->processSocketMessage (socket_id, socket_msg, size) == false)
-                        break;
-                }
-            }
-
-            // process incoming VAST messages, only after JOINED 
-            if (_state == JOINED && handlers->client && handlers->callback)
-            {
-                // process input VAST messages, if any
-                Message *msg;
-            
-                while ((msg = handlers->client->receive ()) != NULL)
-                {
-                    // if the callback cannot handle or does not wish to process more, stop
-                    if (handlers->callback->processMessage (*msg) == false)
-                        break;
-                }
-            }
+            deliverMessages ();
         }
 
         // return whether per_second tasks were performed
@@ -667,6 +687,84 @@ namespace Vast
         return time_left;
     }
 
+    // process network input only (without the callback's per-tick & per-second tasks)
+    void
+    VASTVerse::processInput (int time_budget)
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+
+        if (handlers->msgqueue == NULL)
+            return;
+
+        TimeMonitor::instance ()->setBudget (time_budget > 0 ? time_budget : 1);
+
+        handlers->msgqueue->tick ();
+        deliverMessages ();
+    }
+
+    // pass incoming socket & VAST messages to the callback
+    void
+    VASTVerse::deliverMessages ()
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+
+        // process incoming socket messages 
+        // NOTE: the we don't have to join in order to process
+        if (handlers->callback && handlers->net)
+        {
+            ProfileScope scope (handlers->profiler, PROFILE_CALLBACK);
+
+            char *socket_msg = NULL;
+            id_t socket_id;
+            size_t size;
+            
+            while ((socket_msg = handlers->net->receiveSocket (socket_id, size)) != NULL)
+            {
+                // if the callback cannot handle or does not wish to process more, stop
+                if (handlers->callback->processSocketMessage (socket_id, socket_msg, size) == false)
+                    break;
+            }
+        }
+
+        // process incoming VAST messages, only after JOINED 
+        if (_state == JOINED && handlers->client && handlers->callback)
+        {
+            ProfileScope scope (handlers->profiler, PROFILE_CALLBACK);
+
+            // process input VAST messages, if any
+            Message *msg;
+        
+            while ((msg = handlers->client->receive ()) != NULL)
+            {
+                // if the callback cannot handle or does not wish to process more, stop
+                if (handlers->callback->processMessage (*msg) == false)
+                    break;
+            }
+        }
+    }
+
+    // wait until network input arrives or 'timeout' (in microseconds) passes
+    int
+    VASTVerse::waitInput (int timeout)
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+
+        if (handlers->net == NULL)
+            return (-1);
+
+        return handlers->net->waitInput (timeout);
+    }
+
+    // send out messages queued since the last flush (e.g. by the callback's per-tick tasks)
+    void
+    VASTVerse::flushOutput ()
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+
+        if (handlers->net != NULL)
+            handlers->net->flush ();
+    }
+
     // move logical clock forward (perform periodic stuff here)
     void  
     VASTVerse::tickLogicalClock ()
@@ -828,6 +926,18 @@ namespace Vast
         return 0;
     }
 
+    // obtain the relative error of this node's physical coordinate, -1 if not available
+    float
+    VASTVerse::getCoordinateError ()
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+
+        if (handlers->relay != NULL)
+            return handlers->relay->getCoordinateError ();
+
+        return -1;
+    }
+
     // obtain the tranmission size by message type, default is to return all types
     StatType &
     VASTVerse::getSendStat (bool interval_only)
@@ -847,6 +957,30 @@ namespace Vast
             return _recvstat;
     }
 
+    // obtain size, queueing delay & latency histograms of a message type, NULL if not yet recorded
+    MessageTypeStat *
+    VASTVerse::getMessageTypeStat (msgtype_t msgtype)
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+        if (handlers->net != NULL)
+            return handlers->net->getMessageTypeStat (msgtype);
+
+        return NULL;
+    }
+
+    // obtain up to 'limit' remote hosts with the most bytes sent (or received), in descending order
+    int
+    VASTVerse::getTopTalkers (int limit, vector<pair<id_t, size_t> > &list, bool send)
+    {
+        list.clear ();
+
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+        if (handlers->net != NULL)
+            return handlers->net->getTopTalkers (limit, list, send);
+
+        return 0;
+    }
+
     // reset stat collection for a particular interval, however, accumulated stat will not be cleared
     void
     VASTVerse::clearStat ()
@@ -864,6 +998,22 @@ namespace Vast
             return handlers->net->recordLocalTarget (target);
     }
 
+    // turn on / off profiling of tick () (off by default)
+    void
+    VASTVerse::enableProfiling (bool enable)
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+        handlers->profiler->setEnabled (enable);
+    }
+
+    // obtain the profiler for querying or dumping the recorded stats
+    Profiler *
+    VASTVerse::getProfiler ()
+    {
+        VASTPointer *handlers = (VASTPointer *)_pointers;
+        return handlers->profiler;
+    }
+
     // obtain gateway's IP & port
     IPaddr &
     VASTVerse::getGateway ()
@@ -0,0 +1,197 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "VONNeighborTable.h"
+
+namespace Vast
+{
+
+#define NEIGHBOR_HASH_EMPTY     (-1)        // hash table entry never used
+#define NEIGHBOR_HASH_ERASED    (-2)        // hash table entry of a removed neighbor
+#define NEIGHBOR_HASH_MIN_SIZE  (16)        // initial size of hash table (a power of 2)
+
+    VONNeighborTable::VONNeighborTable ()
+        :_erased (0)
+    {
+        _hash.assign (NEIGHBOR_HASH_MIN_SIZE, NEIGHBOR_HASH_EMPTY);
+    }
+
+    VONNeighborTable::~VONNeighborTable ()
+    {
+    }
+
+    // add a neighbor, returns NULL if the ID already exists
+    VONNeighbor *
+    VONNeighborTable::insert (const Node &node)
+    {
+        // keep the table at most half occupied (including erased marks)
+        if ((_list.size () + 1 + _erased) * 2 > _hash.size ())
+        {
+            size_t capacity = NEIGHBOR_HASH_MIN_SIZE;
+            while (capacity < (_list.size () + 1) * 4)
+                capacity *= 2;
+            rehash (capacity);
+        }
+
+        size_t pos = lookup (node.id);
+        if (_hash[pos] >= 0)
+            return NULL;
+
+        if (_hash[pos] == NEIGHBOR_HASH_ERASED)
+            _erased--;
+
+        size_t slot;
+        if (_free.size () > 0)
+        {
+            slot = _free.back ();
+            _free.pop_back ();
+        }
+        else
+        {
+            slot = _slots.size ();
+            _slots.push_back (VONNeighbor ());
+        }
+
+        VONNeighbor &neighbor = _slots[slot];
+        neighbor.node       = node;
+        neighbor.generation++;
+        neighbor.used       = true;
+        neighbor.status     = INSERTED;
+        neighbor.time_drop  = 0;
+        neighbor.discovery.clear ();
+        neighbor.index      = _list.size ();
+
+        _list.push_back (slot);
+        _nodes.push_back (&neighbor.node);
+        _hash[pos] = (int)slot;
+
+        return &neighbor;
+    }
+
+    // remove a neighbor, its slot keeps the DELETED status until reused
+    bool
+    VONNeighborTable::remove (id_t id)
+    {
+        size_t pos = lookup (id);
+        if (_hash[pos] < 0)
+            return false;
+
+        size_t slot = (size_t)_hash[pos];
+        _hash[pos] = NEIGHBOR_HASH_ERASED;
+        _erased++;
+
+        VONNeighbor &neighbor = _slots[slot];
+
+        // move the last neighbor in the list to the removed place
+        size_t last = _list.size () - 1;
+        if (neighbor.index != last)
+        {
+            _list[neighbor.index]  = _list[last];
+            _nodes[neighbor.index] = _nodes[last];
+            _slots[_list[last]].index = neighbor.index;
+        }
+        _list.pop_back ();
+        _nodes.pop_back ();
+
+        neighbor.used   = false;
+        neighbor.status = DELETED;
+        _free.push_back (slot);
+
+        return true;
+    }
+
+    // remove all neighbors & slots
+    void
+    VONNeighborTable::clear ()
+    {
+        _slots.clear ();
+        _free.clear ();
+        _list.clear ();
+        _nodes.clear ();
+        _hash.assign (NEIGHBOR_HASH_MIN_SIZE, NEIGHBOR_HASH_EMPTY);
+        _erased = 0;
+    }
+
+    // find a neighbor, NULL if not found
+    VONNeighbor *
+    VONNeighborTable::find (id_t id)
+    {
+        int slot = _hash[lookup (id)];
+        return (slot >= 0 ? &_slots[slot] : NULL);
+    }
+
+    VONNeighbor *
+    VONNeighborTable::find (const VONNeighborHandle &handle)
+    {
+        if (handle.slot >= _slots.size ())
+            return NULL;
+
+        VONNeighbor &neighbor = _slots[handle.slot];
+        return ((neighbor.used && neighbor.generation == handle.generation) ? &neighbor : NULL);
+    }
+
+    VONNeighborHandle
+    VONNeighborTable::getHandle (const VONNeighbor &neighbor)
+    {
+        VONNeighborHandle handle;
+        handle.slot       = _list[neighbor.index];
+        handle.generation = neighbor.generation;
+        return handle;
+    }
+
+    // position in the hash table where an ID is, or should be inserted
+    size_t
+    VONNeighborTable::lookup (id_t id)
+    {
+        size_t mask   = _hash.size () - 1;
+        size_t pos    = (size_t)((id * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+        size_t erased = _hash.size ();
+
+        // linear probing, an erased position found on the way is reused for insertion
+        while (true)
+        {
+            int slot = _hash[pos];
+
+            if (slot == NEIGHBOR_HASH_EMPTY)
+                return (erased != _hash.size () ? erased : pos);
+            else if (slot == NEIGHBOR_HASH_ERASED)
+            {
+                if (erased == _hash.size ())
+                    erased = pos;
+            }
+            else if (_slots[slot].node.id == id)
+                return pos;
+
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    // rebuild the hash table with a given capacity (a power of 2)
+    void
+    VONNeighborTable::rehash (size_t capacity)
+    {
+        _hash.assign (capacity, NEIGHBOR_HASH_EMPTY);
+        _erased = 0;
+
+        for (size_t i=0; i < _list.size (); i++)
+            _hash[lookup (_slots[_list[i]].node.id)] = (int)_list[i];
+    }
+
+} // namespace Vast
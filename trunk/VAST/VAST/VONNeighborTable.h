@@ -0,0 +1,171 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * VONNeighborTable.h -- neighbors of a VONPeer & their per-neighbor states
+ *
+ *      each neighbor occupies a slot that stays in place until the neighbor is removed
+ *      (so Node pointers remain valid), freed slots are reused with a new generation.
+ *      neighbors are found by ID through an open-addressing hash table, and can be
+ *      iterated as one contiguous list.
+ */
+
+#ifndef _VAST_VONNeighborTable_H
+#define _VAST_VONNeighborTable_H
+
+#include "VASTTypes.h"
+#include <vector>
+#include <deque>
+
+using namespace std;
+
+namespace Vast
+{
+
+    // what a neighbor is believed to know about my other neighbors (for neighbor discovery check),
+    // kept across ticks so the buffers are reused & only changed neighbors are re-evaluated
+    class NeighborDiscoveryState
+    {
+    public:
+        NeighborDiscoveryState ()
+        {
+            clear ();
+        }
+
+        // reset to the state of a new neighbor (buffers are kept)
+        void clear ()
+        {
+            known.clear ();
+            en.clear ();
+            moved           = true;
+            reset           = false;
+            en_changed      = true;
+            region_changed  = true;
+        }
+
+        vector<pair<id_t, int> >    known;          // states (NeighborStates) of other neighbors, sorted by id
+        vector<id_t>                en;             // enclosing neighbors at the last check, sorted
+        bool                        moved;          // inserted, or AOI changed since the last check
+        bool                        reset;          // 'known' replaced by a received EN list since the last check
+        bool                        en_changed;     // (during a check) whether 'en' differs from the last check
+        bool                        region_changed; // (during a check) whether its Voronoi region may have changed
+    };
+
+    // a slot in the neighbor table
+    class VONNeighbor
+    {
+    public:
+        VONNeighbor ()
+            :generation (0), used (false), status (UNCHANGED), time_drop (0), index (0)
+        {
+        }
+
+        Node                    node;
+        uint32_t                generation;     // incremented each time the slot is given to a new neighbor
+        bool                    used;           // whether the slot holds a current neighbor
+        NeighborUpdateStatus    status;         // last change to the neighbor (of the last one if not used)
+        timestamp_t             time_drop;      // time to disconnect the neighbor if it stays irrelevant
+        NeighborDiscoveryState  discovery;
+        size_t                  index;          // position in the list of neighbors
+    };
+
+    // refers to a neighbor in a table, no longer valid once the neighbor is removed
+    class VONNeighborHandle
+    {
+    public:
+        VONNeighborHandle ()
+            :slot (0), generation (0)
+        {
+        }
+
+        size_t      slot;
+        uint32_t    generation;
+    };
+
+    class VONNeighborTable
+    {
+    public:
+
+        VONNeighborTable ();
+        ~VONNeighborTable ();
+
+        // add a neighbor, returns NULL if the ID already exists
+        VONNeighbor *insert (const Node &node);
+
+        // remove a neighbor, its slot keeps the DELETED status until reused
+        bool remove (id_t id);
+
+        // remove all neighbors & slots
+        void clear ();
+
+        // find a neighbor, NULL if not found
+        VONNeighbor *find (id_t id);
+        VONNeighbor *find (const VONNeighborHandle &handle);
+
+        VONNeighborHandle getHandle (const VONNeighbor &neighbor);
+
+        // # of neighbors & the i-th neighbor in a contiguous list
+        // NOTE: the order changes as neighbors are removed (the last one takes the removed place)
+        size_t size ()
+        {
+            return _list.size ();
+        }
+
+        VONNeighbor &operator[] (size_t i)
+        {
+            return _slots[_list[i]];
+        }
+
+        // the neighbors' Node, in the same order
+        vector<Node *> &getNodes ()
+        {
+            return _nodes;
+        }
+
+        // all slots, including unused ones
+        size_t getSlotCount ()
+        {
+            return _slots.size ();
+        }
+
+        VONNeighbor &getSlot (size_t slot)
+        {
+            return _slots[slot];
+        }
+
+    private:
+
+        // position in the hash table where an ID is, or should be inserted
+        size_t lookup (id_t id);
+
+        // rebuild the hash table with a given capacity (a power of 2)
+        void rehash (size_t capacity);
+
+        deque<VONNeighbor>  _slots;         // NOTE: deque does not move existing slots when growing
+        vector<size_t>      _free;          // unused slots
+        vector<size_t>      _list;          // slots of current neighbors
+        vector<Node *>      _nodes;         // Node of current neighbors (same order as _list)
+        vector<int>         _hash;          // slot of each ID, or empty / erased marks
+        size_t              _erased;        // # of erased marks in _hash
+    };
+
+} // namespace Vast
+
+#endif
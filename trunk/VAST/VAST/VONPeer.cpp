@@ -2,6 +2,7 @@
 
 #include "VONPeer.h"
 #include "VoronoiSF.h"
+#include <algorithm>        // sort, lower_bound
 
 using namespace Vast;
 
@@ -23,6 +24,7 @@ namespace Vast
     };
 
     VONPeer::VONPeer (id_t id, VONNetwork *net, length_t aoi_buffer, bool strict_aoi)
+        :_neighbors (_neighbor_table.getNodes ())
     {
         _net = net;
         _aoi_buffer = aoi_buffer;
@@ -110,15 +112,8 @@ namespace Vast
                 _net->sendVONMessage (msg, true);
         }
 
-        // delete allocated memory                
-        // NOTE: no need to clear the Node pointers in _neighbors as 
-        //       they are simply references to data in _id2node
-        for (map<id_t, map<id_t, int> *>::iterator it = _neighbor_states.begin (); it != _neighbor_states.end (); it++)
-            delete it->second;
-        _neighbor_states.clear ();
-
-        _id2node.clear ();
-        _neighbors.clear ();
+        // NOTE: _neighbors is cleared together as it's kept by the table
+        _neighbor_table.clear ();
 
         // stop all connections                       
         _state = ABSENT;
@@ -174,9 +169,9 @@ namespace Vast
         // go over each neighbor and do a boundary neighbor check	
         vector<id_t> boundary_list;
 
-        for (map<id_t, Node>::iterator it = _id2node.begin(); it != _id2node.end(); ++it)
+        for (size_t i=0; i < _neighbor_table.size (); ++i)
         {
-            if (isSelf (target = it->first)) // || !isAOINeighbor (_self.id, it->second))
+            if (isSelf (target = _neighbor_table[i].node.id)) // || !isAOINeighbor (_self.id, _neighbor_table[i].node))
                 continue;
 
             if (_Voronoi->is_boundary (target, _self.aoi.center, _self.aoi.radius))
@@ -249,15 +244,8 @@ namespace Vast
     Node *      
     VONPeer::getNeighbor (id_t id)
     {
-        size_t i;
-        for (i=0; i < _neighbors.size (); i++)
-            if (id == _neighbors[i]->id)
-                break;
-
-        if (i == _neighbors.size ())
-            return NULL;
-        else
-            return _neighbors[i];
+        VONNeighbor *neighbor = _neighbor_table.find (id);
+        return (neighbor != NULL ? &neighbor->node : NULL);
     }
 
     // obtain a list of subscribers with an area
@@ -285,6 +273,14 @@ namespace Vast
     map<id_t, NeighborUpdateStatus>& 
     VONPeer::getUpdateStatus ()
     {
+        // current neighbors & removed ones whose slots are not yet reused
+        _updateStatus.clear ();
+        for (size_t i=0; i < _neighbor_table.getSlotCount (); i++)
+        {
+            VONNeighbor &neighbor = _neighbor_table.getSlot (i);
+            _updateStatus[neighbor.node.id] = neighbor.status;
+        }
+
         return _updateStatus;
     }
 
@@ -399,25 +395,29 @@ namespace Vast
                 listsize_t n;
                 in_msg.extract (n);
                 
-                map<id_t, int> *list = new map<id_t, int>;                // list of EN received                
                 vector<id_t>    missing;                                  // list of missing EN ids (to be sent)
                 vector<id_t>    &en_list = _Voronoi->get_en (_self.id);   // list of my EN
                 
                 size_t i;
                 id_t id;
                 
-                // create a searchable list of EN
+                // store the EN received as initial known list (searchable once sorted)
+                // TODO: do we need to update the neighbor_states here?
+                //       because during neighbor discovery checks, each node's knowledge will be calculated               
+                // only neighbors are checked (a HELLO sender is inserted above)
+                VONNeighbor *sender = _neighbor_table.find (in_msg.from);
+                if (sender == NULL)
+                    break;
+
+                NeighborDiscoveryState &known_by = sender->discovery;
+                known_by.known.clear ();
                 for (i=0; i<n; ++i)
                 {
                     in_msg.extract (id);
-                    list->insert (map<id_t, int>::value_type (id, NEIGHBOR_OVERLAPPED));  
+                    known_by.known.push_back (pair<id_t, int> (id, NEIGHBOR_OVERLAPPED));  
                 }
-                
-                // store as initial known list                 
-                // TODO: do we need to update the neighbor_states here?
-                //       because during neighbor discovery checks, each node's knowledge will be calculated               
-                delete _neighbor_states[in_msg.from];
-                _neighbor_states[in_msg.from] = list;
+                std::sort (known_by.known.begin (), known_by.known.end ());
+                known_by.reset = true;
                 
                 size_t en_size = en_list.size ();
                 for (i=0; i < en_size; ++i)
@@ -430,8 +430,8 @@ namespace Vast
                     //  3) one of the sender node's relevant neighbors
                     //  
                     if (id != in_msg.from && 
-                        list->find (id) == list->end () && 
-                        isRelevantNeighbor (_id2node[id], _id2node[in_msg.from], _aoi_buffer))
+                        getKnownState (known_by, id) == 0 && 
+                        isRelevantNeighbor (*getNeighbor (id), sender->node, _aoi_buffer))
                         missing.push_back (id);
                 }
                 
@@ -475,7 +475,7 @@ namespace Vast
                 {
                     if (isNeighbor (in_msg.from))
                     {
-                        node = _id2node[in_msg.from];
+                        node = *getNeighbor (in_msg.from);
 
                         // NOTE both position & time are used
                         //in_msg.extract (node.aoi.center);
@@ -534,16 +534,10 @@ namespace Vast
         case VON_BYE:
         case VON_DISCONNECT:
             {               
-                size_t i;
-                for (i=0; i < _neighbors.size (); i++)
+                if (isNeighbor (in_msg.from))
                 {                                        
-                    if (_neighbors[i]->id == in_msg.from)
-                    {
-                        checkConsistency (in_msg.from);
-                        deleteNode (in_msg.from);
-
-                        break;
-                    }                   
+                    checkConsistency (in_msg.from);
+                    deleteNode (in_msg.from);
                 }
             }
             break;
@@ -573,7 +567,7 @@ namespace Vast
         //
         // new neighbor notification check
         //
-        vector<id_t> new_list;      // list of new, unknown nodes
+        vector<VoronoiProbe> new_list;      // list of new, unknown nodes
                 
         id_t target;
 
@@ -589,22 +583,29 @@ namespace Vast
             
             else
             {                                
-                _Voronoi->insert (target, new_node.aoi.center);            
-                new_list.push_back (target);
+                VoronoiProbe probe;
+                probe.id     = target;
+                probe.coord  = new_node.aoi.center;
+                probe.radius = new_node.aoi.radius + _aoi_buffer;
+                new_list.push_back (probe);
             }
         }
 
-        size_t i;
+        // evaluate all unknown nodes at once as if inserted into Voronoi, 
+        // the diagram itself is left unchanged (no insert & remove)
+        if (new_list.size () > 0)
+            _Voronoi->evaluate (_self.id, _self.aoi.radius + _aoi_buffer, new_list, (_strict_aoi == false));
         
-        // check through each newly inserted Voronoi for relevance                      
-        for (i=0; i < new_list.size (); ++i)
+        // check through each new node for relevance (same as isRelevantNeighbor (node, _self, _aoi_buffer))
+        for (size_t i=0; i < new_list.size (); ++i)
         {
-            target = new_list[i];
+            VoronoiProbe &probe = new_list[i];
+            target = probe.id;
             Node &node = _new_neighbors[target];
 
-            // if the neighbor is relevant and we insert it successfully
+            // if the neighbor is relevant
             // NOTE that we're more tolerant for AOI buffer when accepting notification
-            if (isRelevantNeighbor (node, _self, _aoi_buffer))
+            if (probe.enclosing || probe.overlaps || probe.overlapped)
             {   
                 // store new node as a potential neighbor, pending confirmation from the new node 
                 // this is to ensure that a newly discovered neighbor is indeed relevant
@@ -617,13 +618,9 @@ namespace Vast
                 // send HELLO message to newly discovered nodes
                 // NOTE that we do not perform insert yet (until the remote node has confirmed via MOVE)
                 //      this is to avoid outdated neighbor discovery notice from taking effect
-                sendHello (target, _Voronoi->get_en (target));
+                sendHello (target, probe.en);
             }           
         }
-
-        // clear up the temporarily inserted test node from Voronoi (if not becoming neighbor)
-        for (i=0; i < new_list.size (); ++i)            
-            _Voronoi->remove (new_list[i]);
         
         // NOTE: erase new neighbors seems to bring better consistency 
         //       (rather than keep to next round, as previous VAST)
@@ -640,6 +637,43 @@ namespace Vast
         vector<id_t> notify_list;       // list of neighbors to notify
         id_t from_id;
 
+        size_t num = _neighbor_table.size ();
+        size_t index;
+
+        //
+        // find neighbors whose Voronoi regions may have changed since the last check,
+        // i.e., those moved or whose enclosing neighbors have changed or moved
+        //
+
+        for (index=0; index < num; ++index)
+        {
+            NeighborDiscoveryState &neighbor = _neighbor_table[index].discovery;
+
+            vector<id_t> &en = _Voronoi->get_en (_neighbor_table[index].node.id);
+            _en_buffer.assign (en.begin (), en.end ());
+            std::sort (_en_buffer.begin (), _en_buffer.end ());
+
+            neighbor.en_changed = (_en_buffer != neighbor.en);
+            if (neighbor.en_changed)
+                neighbor.en.swap (_en_buffer);
+
+            neighbor.region_changed = (neighbor.moved || neighbor.en_changed);
+        }
+
+        for (index=0; index < num; ++index)
+        {
+            if (_neighbor_table[index].discovery.moved == false)
+                continue;
+
+            vector<id_t> &en = _neighbor_table[index].discovery.en;
+            for (size_t j=0; j < en.size (); ++j)
+            {
+                VONNeighbor *neighbor = _neighbor_table.find (en[j]);
+                if (neighbor != NULL)
+                    neighbor->discovery.region_changed = true;
+            }
+        }
+
         //
         // perform neighbor discovery only for those that have requested 
         // (i.e., those that have sent a MOVE_B message)
@@ -655,20 +689,25 @@ namespace Vast
                 continue;
 #else
         // we check for all known neighbors except myself
-        size_t num = _neighbors.size ();
-        size_t index;
         for (index=0; index < num; ++index)
         {
-            from_id = _neighbors[index]->id;
+            from_id = _neighbor_table[index].node.id;
 
             if (isSelf (from_id))
                 continue;
 #endif
-            // TODO: determine whether clear or new is better / faster (?)
             notify_list.clear ();            
-            map<id_t, int> *known_list = new map<id_t, int>;    // current neighbor states
-            map<id_t, int>::iterator it;                        // iterator for neighbor states
+            _known_buffer.clear ();                             // current neighbor states
+
+            VONNeighbor &from = *_neighbor_table.find (from_id);
+            NeighborDiscoveryState &known_by = from.discovery;
             
+            // if the moving node's AOI, ENs & known states are as before, only neighbors 
+            // whose regions may have changed need to be checked, others keep their known states
+            bool check_all = (known_by.moved || known_by.en_changed || known_by.reset);
+#ifdef CHECK_REQUESTING_NODES_ONLY
+            check_all = true;
+#endif
             id_t id;
             int state, known_state;
               
@@ -678,7 +717,7 @@ namespace Vast
             size_t n = en_list.size ();            
 #else            
             // loop through every known neighbor except myself
-            size_t n = _neighbors.size ();
+            size_t n = _neighbor_table.size ();
 #endif
             for (size_t i=0; i < n; ++i)
             {        
@@ -686,7 +725,7 @@ namespace Vast
 #ifdef CHECK_EN_ONLY
                 id = en_list[i];
 #else
-                id = _neighbors[i]->id;
+                id = _neighbor_table[i].node.id;
 #endif                
                 if (isSelf (id) || id == from_id)
                     continue;
@@ -699,20 +738,31 @@ namespace Vast
                 //if (right_of (id, from_id) == false)
                 //    continue;                
 
+                known_state = getKnownState (known_by, id);
+
+#ifdef CHECK_EN_ONLY
+                bool region_changed = true;
+#else
+                bool region_changed = _neighbor_table[i].discovery.region_changed;
+#endif
+                if (check_all == false && region_changed == false)
+                {
+                    // nothing to notify, as the state is the same as known
+                    if (known_state != 0)
+                        _known_buffer.push_back (pair<id_t, int> (id, known_state));
+                    continue;
+                }
+
                 state = 0;
-                known_state = 0;
-                if (isAOINeighbor (id, _id2node[from_id], _aoi_buffer))
+                if (isAOINeighbor (id, from.node, _aoi_buffer))
                     state = state | NEIGHBOR_OVERLAPPED;
-                if (_Voronoi->is_enclosing (id, from_id))
+                if (std::binary_search (known_by.en.begin (), known_by.en.end (), id))
                     state = state | NEIGHBOR_ENCLOSED;
 
                 // notify case1: new overlap by moving node's AOI
                 // notify case2: new EN for the moving node                
                 if (state != 0)
                 {                                                           
-                    if ((it = _neighbor_states[from_id]->find (id)) != _neighbor_states[from_id]->end ())
-                        known_state = it->second;
-                    
                     // note: what we want to achieve is:
                     //       1. notify just once when new enclosing neighbor (EN) is found
                     //       2. notify about new overlap, even if the node is known to be an EN
@@ -726,13 +776,13 @@ namespace Vast
                         notify_list.push_back (id);
                     
                     // store the state of this particular neighbor
-                    known_list->insert (map<id_t, int>::value_type (id, state));
+                    _known_buffer.push_back (pair<id_t, int> (id, state));
                 }
             }
 
-            // update known states about neighbors
-            delete _neighbor_states[from_id];
-            _neighbor_states[from_id] = known_list;
+            // update known states about neighbors (buffers are swapped to be reused)
+            std::sort (_known_buffer.begin (), _known_buffer.end ());
+            known_by.known.swap (_known_buffer);
 
             // notify moving node of new neighbors
             if (_req_nodes.find (from_id) != _req_nodes.end ())
@@ -740,6 +790,22 @@ namespace Vast
         }
 
         _req_nodes.clear ();
+
+        for (index=0; index < num; ++index)
+        {
+            _neighbor_table[index].discovery.moved = false;
+            _neighbor_table[index].discovery.reset = false;
+        }
+    }
+
+    // state of a neighbor as known by another (0 if unknown)
+    int
+    VONPeer::getKnownState (NeighborDiscoveryState &known_by, id_t id)
+    {
+        vector<pair<id_t, int> >::iterator it = 
+            std::lower_bound (known_by.known.begin (), known_by.known.end (), pair<id_t, int> (id, 0));
+
+        return ((it != known_by.known.end () && it->first == id) ? it->second : 0);
     }
 
     // check consistency of enclosing neighbors
@@ -770,9 +836,10 @@ namespace Vast
 
         id_t id;
         // go over each neighbor and do an overlap check
-        for (map<id_t, Node>::iterator it = _id2node.begin(); it != _id2node.end(); ++it)
+        for (size_t i=0; i < _neighbor_table.size (); ++i)
         {
-            id = it->first;
+            VONNeighbor &neighbor = _neighbor_table[i];
+            id = neighbor.node.id;
             
             // check if a neighbor is relevant (within AOI or enclosing)
             // or if the neighbor still covers me
@@ -780,19 +847,16 @@ namespace Vast
             //       neighbor discovery, this is so that if a node is recently disconnect
             //       here, other neighbors can re-notify should it comes closer again
             if (isSelf (id) ||
-                (isRelevantNeighbor (_self, _id2node[id], (length_t)(_aoi_buffer*NONOVERLAP_MULTIPLIER)) && 
+                (isRelevantNeighbor (_self, neighbor.node, (length_t)(_aoi_buffer*NONOVERLAP_MULTIPLIER)) && 
                  isTimelyNeighbor (id)))
             {
-                _time_drop[id] = grace_period;
+                neighbor.time_drop = grace_period;
                 continue;
             }
    
             // if current time exceeds grace period, then prepare to delete
-            if (now >= _time_drop[id]) 
-            {
+            if (now >= neighbor.time_drop) 
                 delete_list.push_back (id);
-                _time_drop.erase (id);
-            }
         }
         
         size_t n_deleted = delete_list.size ();
@@ -827,13 +891,9 @@ namespace Vast
         //node.addr.lastAccessed = _tick_count;
         node.addr.lastAccessed = _net->getTimestamp ();
 
+        // the new neighbor is marked INSERTED with a new drop timer & discovery state
         _Voronoi->insert (node.id, node.aoi.center);        
-        _id2node[node.id] = node;
-        _neighbors.push_back (&_id2node[node.id]);
-        _neighbor_states[node.id] = new map<id_t, int>;
-        _time_drop[node.id] = 0;
-        
-        _updateStatus[node.id] = INSERTED;
+        _neighbor_table.insert (node);
 
         return true;
     }
@@ -853,23 +913,9 @@ namespace Vast
         printf ("[%lu] disconnecting [%lu]\n", _self.id, id);
 #endif
 
+        // the slot is kept with DELETED status until reused
         _Voronoi->remove (id);
-        vector<Node *>::iterator it = _neighbors.begin();
-        for (; it != _neighbors.end (); it++)
-        {
-            if ((*it)->id == id)
-            {
-                _neighbors.erase (it);
-                break;
-            }
-        }
-
-        _id2node.erase (id);        
-        delete _neighbor_states[id];
-        _neighbor_states.erase (id);    
-        _time_drop.erase (id);
-                
-        _updateStatus[id] = DELETED;
+        _neighbor_table.remove (id);
 
         return true;
     }
@@ -880,8 +926,10 @@ namespace Vast
         if (isNeighbor (node.id) == false)
             return false;
         
+        VONNeighbor &neighbor = *_neighbor_table.find (node.id);
+
         // only update the node if it's at a later time
-        if (node.time < _id2node[node.id].time)
+        if (node.time < neighbor.node.time)
             return false;
 
 #ifdef DEBUG_DETAIL
@@ -889,7 +937,12 @@ namespace Vast
 #endif
 
         _Voronoi->update (node.id, node.aoi.center);
-        _id2node[node.id].update (node);   
+
+        // neighbor discovery needs to re-check only nodes that have moved
+        if (neighbor.node.aoi != node.aoi)
+            neighbor.discovery.moved = true;
+
+        neighbor.node.update (node);   
 
         // NOTE: should not reset drop counter here, as it might make irrelevant neighbor 
         //       difficult to get disconnected
@@ -900,8 +953,8 @@ namespace Vast
         node.addr.lastAccessed = _net->getTimestamp ();
 
         // prevent only send updates for newly inserted nodes
-        if (_updateStatus.find (node.id) == _updateStatus.end () || _updateStatus[node.id] != INSERTED)
-            _updateStatus[node.id] = UPDATED;    
+        if (neighbor.status != INSERTED)
+            neighbor.status = UPDATED;    
 
         return true;
     }
@@ -927,7 +980,7 @@ namespace Vast
 #ifdef DEBUG_DETAIL
             printf (" (%lu)", list[i]);
 #endif
-            msg.store (_id2node[list[i]]);
+            msg.store (*getNeighbor (list[i]));
         }
 #ifdef DEBUG_DETAIL
             printf ("\n");
@@ -1003,23 +1056,22 @@ namespace Vast
     bool 
     VONPeer::isNeighbor (id_t id)
     {
-        return (_id2node.find (id) != _id2node.end ());
+        return (_neighbor_table.find (id) != NULL);
     }
 
     Position &
     VONPeer::isOverlapped (Position &pos)
     {
         // check for position overlap with neighbors and make correction
-        map<id_t, Node>::iterator it; 
-        for (it = _id2node.begin(); it != _id2node.end(); ++it)
+        for (size_t i=0; i < _neighbors.size (); ++i)
         {
-            if (isSelf (it->first))
+            if (isSelf (_neighbors[i]->id))
                 continue;
-            if (it->second.aoi.center == pos)
+            if (_neighbors[i]->aoi.center == pos)
             {
                 // TODO: better movement?
                 pos.x++;
-                it = _id2node.begin();
+                i = (size_t)(-1);      // check again from the start
             }
         }
         return pos;
@@ -40,6 +40,7 @@
 #include "VASTTypes.h"
 #include "Voronoi.h"
 #include "VONNetwork.h"
+#include "VONNeighborTable.h"
 
 using namespace std;
 
@@ -146,7 +147,8 @@ namespace Vast
         VONNetwork         *_net;                       // pointer to network interface
         Node                _self;                      // info about my self
         NodeState           _state;                     // state of joining
-        vector<Node *>      _neighbors;                 // a list of currently connected neighboring managers
+        VONNeighborTable    _neighbor_table;            // currently connected neighbors & their states
+        vector<Node *>     &_neighbors;                 // a list of currently connected neighboring managers (kept by _neighbor_table)
         
         Voronoi            *_Voronoi;                   // a Voronoi diagram for keeping AOI neighbors                
 
@@ -167,6 +169,9 @@ namespace Vast
         // perform neighbor discovery check
         void checkNeighborDiscovery ();
 
+        // state of a neighbor as known by another (0 if unknown)
+        int getKnownState (NeighborDiscoveryState &known_by, id_t id);
+
         // check consistency of enclosing neighbors
         void checkConsistency (id_t skip_id = 0);
 
@@ -214,13 +219,11 @@ namespace Vast
         inline bool isSelf (id_t id);
 
                  
-        map<id_t, Node>     _id2node;                   // mapping from id to basic node info                        
-        map<id_t, map<id_t, int> *> _neighbor_states;   // neighbors' knowledge of my neighbors (for neighbor discovery check)        
         map<id_t, Node>     _new_neighbors;             // nodes worth considering to connect        
         map<id_t, Node>     _potential_neighbors;       // nodes that 
         map<id_t, bool>     _req_nodes;                 // nodes requesting for neighbor discovery check        
                 
-        map<id_t, NeighborUpdateStatus> _updateStatus;  // status about whether a neighbor is inserted/deleted/updated
+        map<id_t, NeighborUpdateStatus> _updateStatus;  // status about whether a neighbor is inserted/deleted/updated (filled by getUpdateStatus ())
                                                         //  1: inserted, 2: deleted, 3: updated
 
         length_t            _aoi_buffer;                // additional buffersize for checking relevant AOI neighbors
@@ -228,7 +231,10 @@ namespace Vast
 
         // internal statistics
         Ratio               _NEIGHBOR_Message;          // stats for NodeMessages received
-        map<id_t, timestamp_t> _time_drop;              // timestamp record for disconnecting a remote node
+
+        // buffers for checkNeighborDiscovery ()
+        vector<pair<id_t, int> > _known_buffer;
+        vector<id_t>        _en_buffer;
     };
 
 } // namespace Vast
@@ -1,6 +1,8 @@
 
 
 #include "VSOPeer.h"
+#include "VoronoiPower.h"
+#include <algorithm>    // find
 
 using namespace Vast;
 
@@ -23,6 +25,16 @@ namespace Vast
         _next_periodic = 0;
         _overload_timeout = _underload_timeout = 0;
 
+        _msg_count = _send_size = 0;
+        _last_msg_count = _last_send_size = 0;
+
+#ifdef VSO_WEIGHTED_REGION
+        // use weighted regions so region sizes can follow loading
+        // NOTE: neighbors yet to report their loading are treated as idle
+        delete _Voronoi;
+        _Voronoi = new VoronoiPower (VSO_REGION_WEIGHT);
+#endif
+
         _vso_state = JOINING;
     }
 
@@ -90,6 +102,26 @@ namespace Vast
                 in_msg.extract (join_pos);
                 in_msg.extract (origin);
 
+                // physical demand of the region to take over (optional)
+                vector<PlacementDemand> demand;
+                listsize_t n = 0;
+                if (in_msg.extract ((char *)&n, sizeof (listsize_t)) > 0)
+                {
+                    // guard against a count larger than what the message holds
+                    if ((size_t)n * (Position ().sizeOf () + sizeof (float)) > in_msg.remaining ())
+                    {
+                        printf ("[%llu] VSOPeer::handleMessage () VSO_INSERT has invalid demand size %u\r\n", _self.id, (unsigned)n);
+                        n = 0;
+                    }
+
+                    demand.resize (n);
+                    for (listsize_t i=0; i < n; i++)
+                    {
+                        in_msg.extract (demand[i].coord);
+                        in_msg.extract (demand[i].weight);
+                    }
+                }
+
                 // TODO: ignore redundent requests at same position
                 
                 // promote one of the spare potential nodes
@@ -98,7 +130,7 @@ namespace Vast
                 // TODO: findCandidate () would always be successful (if no candidate found, then create gateway node)
                 // return from loop either request successfully served (promotion sent) 
                 // or no candidates can be found
-                while (_policy->findCandidate (new_node, level))
+                while (_policy->findCandidate (new_node, level, &demand))
                 {
                     // fill in the stressed node's contact info & join location
                     Node requester;
@@ -159,6 +191,12 @@ namespace Vast
                 float level;
                 in_msg.extract ((char *)&level, sizeof (float));
 
+#ifdef VSO_PREDICTIVE_LOAD
+                // do not move closer to share load if I'm going to be overloaded myself
+                if (_load.forecast >= 1.0f)
+                    break;
+#endif
+
                 // calculate new position after moving closer to the stressed node
                 Position neighbor_pos = _Voronoi->get (in_msg.from);
                 Position temp_pos = _newpos.aoi.center;
@@ -199,18 +237,34 @@ namespace Vast
         // acknowledgment of ownership transfer received
         case VSO_TRANSFER_ACK:            
             {
+                listsize_t n;
+                in_msg.extract (n);
+
                 id_t obj_id;
-                in_msg.extract (obj_id);                
-                
-                // check if object exists
-                if (_objects.find (obj_id) == _objects.end ())
+                vector<id_t> confirmed;
+
+                for (listsize_t i=0; i < n; i++)
                 {
-                    printf ("[%llu] VSOPeer: TRANSFER_ACK received for unknown object [%llu]\n", _self.id, obj_id);
-                    break;
+                    in_msg.extract (obj_id);
+                
+                    // check if object exists
+                    if (_objects.find (obj_id) == _objects.end ())
+                    {
+                        printf ("[%llu] VSOPeer: TRANSFER_ACK received for unknown object [%llu]\n", _self.id, obj_id);
+                        continue;
+                    }
+
+                    // new owner has confirmed, release ownership & update in_transit stat
+                    VSOSharedObject &so = _objects[obj_id];
+                    so.is_owner   = false;
+                    so.in_transit = 0;
+
+                    confirmed.push_back (obj_id);
                 }
 
-                // update in_transit stat                
-                _objects[obj_id].in_transit = 0;
+                // only now can the clients switch to the new owner
+                if (confirmed.size () > 0)
+                    _policy->ownershipTransferred (in_msg.from, confirmed);
             }
             break;
 
@@ -233,6 +287,20 @@ namespace Vast
             }
             break;
 
+        // load report from an enclosing neighbor
+        case VSO_LOAD:
+            {
+                VSOLoadStat stat;
+                in_msg.extract (stat);
+
+                _neighbor_load[in_msg.from] = stat;
+
+#ifdef VSO_WEIGHTED_REGION
+                _Voronoi->setWeight (in_msg.from, getRegionWeight (stat.forecast));
+#endif
+            }
+            break;
+
         case VSO_DISCONNECT:
             {
                 // claim ownership of objects managed by departing peer
@@ -246,6 +314,8 @@ namespace Vast
                         _reclaim_timeout[it->first] = 0;
                 }
 
+                _neighbor_load.erase (in_msg.from);
+
                 // then notify VON component to remove the departing peer
                 in_msg.msgtype = VON_DISCONNECT;
                 VONPeer::handleMessage (in_msg);
@@ -267,6 +337,17 @@ namespace Vast
     {                         
         timestamp_t now = _net->getTimestamp ();
 
+#ifdef VSO_PREDICTIVE_LOAD
+        // treat a forecasted overload as overload, so relief can arrive before overload occurs
+        if (level == 0 && _load.forecast > 1.0f)
+            level = _load.forecast;
+
+        // do not depart if incoming load is forecasted to overload me
+        // (any non-zero load forecasts some load, which alone shouldn't keep an underloaded node from departing)
+        else if (level < 0 && _load.forecast >= 1.0f)
+            level = 0;
+#endif
+
         // first adjust the current load level record
         if (level == 0)
         {
@@ -298,6 +379,13 @@ namespace Vast
                 _overload_count = 0;
 
             _overload_count++;
+
+#ifdef VSO_PREDICTIVE_LOAD
+            // if a steep load increase is forecasted, or neighbors are too loaded to share, 
+            // moving boundaries won't relieve us in time, so request insertion directly
+            if (_load.forecast >= VSO_PREINSERT_LEVEL || getNeighborLoading () >= 1.0f)
+                _overload_count = VSO_INSERTION_TRIGGER;
+#endif
                        
             // if the overload situation just occurs, try to move boundary first
             if (_overload_count < VSO_INSERTION_TRIGGER) 
@@ -328,6 +416,20 @@ namespace Vast
                     msg.store (level);
                     msg.store (pos);
                     msg.store (_origin);
+
+                    // physical demand of the region, so the new node can be placed close to the subscribers
+                    vector<PlacementDemand> demand;
+                    listsize_t n = (listsize_t)_policy->getPlacementDemand (pos, demand);
+                    if (n > 0)
+                    {
+                        msg.store (n);
+                        for (listsize_t i=0; i < n; i++)
+                        {
+                            msg.store (demand[i].coord);
+                            msg.store (demand[i].weight);
+                        }
+                    }
+
                     msg.addTarget (_policy->getGatewayID ());
                     _net->sendVONMessage (msg);    
                 }
@@ -368,6 +470,22 @@ namespace Vast
             _overload_count = 0;        
     }
 
+    // record raw load indicators for trend forecasting
+    void 
+    VSOPeer::recordLoading (float level, size_t msg_count, size_t send_size)
+    {
+        _load.level = level;
+        _msg_count  = msg_count;
+        _send_size  = send_size;
+    }
+
+    // get the forecasted load level
+    float 
+    VSOPeer::getLoadForecast ()
+    {
+        return _load.forecast;
+    }
+
     // change the center position in response to overload signals
     void 
     VSOPeer::movePeerPosition ()
@@ -544,11 +662,10 @@ namespace Vast
             return 0;
                                              
         //
-        // transfer current subscriptions to neighbor nodes
+        // queue current subscriptions for transfer to neighbor nodes
         //
 
-        // a list of ownership transfer info, grouped by transfer target (closest node)
-        map<id_t, vector<VSOOwnerTransfer> *> transfer_list;
+        int num_transfer = 0;
         
         for (map<id_t, VSOSharedObject>::iterator it = _objects.begin (); it != _objects.end (); ++it)
         {
@@ -565,26 +682,16 @@ namespace Vast
                     if (_transfer_timeout.find (obj_id) == _transfer_timeout.end ())
                         _transfer_timeout[obj_id] = now + (timestamp_t)(VSO_TIMEOUT_TRANSFER * _net->getTimestampPerSecond ());
 
-                    // if timeout exceeds, then begin transfer to nearest node
-                    else if (now >= _transfer_timeout[obj_id])
+                    // if timeout exceeds, then queue the transfer to nearest node
+                    // NOTE: we remain owner until the new owner acknowledges, 
+                    //       the actual target is determined when the object is streamed out
+                    else if (now >= _transfer_timeout[obj_id] && so.in_transit == 0)
                     {
-                        id_t closest = _Voronoi->closest_to (so.aoi.center);
-                        
-                        if (closest != _self.id)
+                        if (_Voronoi->closest_to (so.aoi.center) != _self.id)
                         {            
-                            // record the transfer
-                            VSOOwnerTransfer transfer (obj_id, closest, _self.id);
-
-                            if (transfer_list.find (closest) == transfer_list.end ())
-                                transfer_list[closest] = new vector<VSOOwnerTransfer>;
-
-                            transfer_list[closest]->push_back (transfer);
-                                                          
-                            // we release ownership for now (but will still be able to process events via in-transit records)
-                            // this is important as we can only transfer ownership to one neighbor at a time
-    
-                            so.is_owner = false;
-                            so.in_transit = now + (timestamp_t)(VSO_TIMEOUT_TRANSFER * _net->getTimestampPerSecond () * 3); 
+                            _transfer_queue.push_back (obj_id);
+                            so.in_transit = VSO_TRANSIT_QUEUED;
+                            num_transfer++;
 
                             _transfer_timeout.erase (obj_id);
                         }                        
@@ -623,19 +730,75 @@ namespace Vast
             }     
 
             // reclaim in-transit objects taking too long to complete
+            // (if still owner, the transfer is unconfirmed and will be attempted again)
             if (so.in_transit != 0 && (now >= so.in_transit))
             {
-                claimOwnership (obj_id, so);
+                if (so.is_owner)
+                    so.in_transit = 0;
+                else
+                    claimOwnership (obj_id, so);
             }
         }
 
         // TODO: need to make sure the above countdowns do not stay alive
         //       and errously affect future countdown detection
+        
+        return num_transfer;
+    }
+
+    // stream queued ownership transfers to new owners, within VSO_TRANSFER_BUDGET bytes per tick
+    int 
+    VSOPeer::streamTransfers ()
+    {
+        if (_transfer_queue.size () == 0)
+            return 0;
+
+        // a list of objects to transfer, grouped by transfer target (closest node)
+        map<id_t, vector<id_t> > transfer_list;
+
+        timestamp_t now = _net->getTimestamp ();
+        size_t bytes = 0;
+        size_t i;
+
+        for (i=0; i < _transfer_queue.size (); i++)
+        {
+            id_t obj_id = _transfer_queue[i];
+
+            // object may have been removed, re-claimed or cancelled since being queued
+            map<id_t, VSOSharedObject>::iterator it = _objects.find (obj_id);
+            if (it == _objects.end () || it->second.is_owner == false || it->second.in_transit != VSO_TRANSIT_QUEUED)
+                continue;
+
+            VSOSharedObject &so = it->second;
+
+            // object may have moved back to my region
+            id_t closest = _Voronoi->closest_to (so.aoi.center);
+            if (closest == _self.id)
+            {
+                so.in_transit = 0;
+                continue;
+            }
+
+            // stop if budget is used up (but always send at least one object per tick)
+            size_t size = _policy->getObjectSize (obj_id);
+            if (bytes > 0 && bytes + size > VSO_TRANSFER_BUDGET)
+                break;
+
+            bytes += size;
+            transfer_list[closest].push_back (obj_id);
+
+            // we remain the owner (and keep processing events) until the new owner acknowledges,
+            // the transfer is attempted again if no acknowledgement arrives before countdown
+            so.in_transit = now + (timestamp_t)(VSO_TIMEOUT_TRANSFER * _net->getTimestampPerSecond () * 3); 
+        }
+
+        // remove processed transfers, the rest will be sent in later ticks
+        _transfer_queue.erase (_transfer_queue.begin (), _transfer_queue.begin () + i);
 
         // perform the actual transfer from list
         Message msg (VSO_TRANSFER);
         
-        map<id_t, vector<VSOOwnerTransfer> *>::iterator it = transfer_list.begin ();
+        map<id_t, vector<id_t> >::iterator it = transfer_list.begin ();
 
         int num_transfer = 0;
         for (; it != transfer_list.end (); it++)
@@ -643,18 +806,16 @@ namespace Vast
             msg.clear (VSO_TRANSFER);
             msg.priority = 1;
 
-            vector<VSOOwnerTransfer> &transfers = *it->second;            
-            vector<id_t> obj_list;
+            vector<id_t> &obj_list = it->second;            
 
-            listsize_t n = (listsize_t)transfers.size ();
+            listsize_t n = (listsize_t)obj_list.size ();
             msg.store (n);
         
             // store each transfer
-            for (listsize_t i=0; i < n; i++)
+            for (listsize_t j=0; j < n; j++)
             {
-                msg.store (transfers[i]);
-
-                obj_list.push_back (transfers[i].obj_id);
+                VSOOwnerTransfer transfer (obj_list[j], it->first, _self.id);
+                msg.store (transfer);
 
                 num_transfer++;               
             }
@@ -665,23 +826,14 @@ namespace Vast
             //       some tests show that copy object in full before ownership transfer helps to improve overall consistency at
             //       slight additional bandwidth
             _policy->copyObject (it->first, obj_list, false);
-            _policy->ownershipTransferred (it->first, obj_list);
-
-            // TODO: notify other nodes to remove ghost objects?
-            // remove closest & send to all other neighbors
-            // causes crash? 
             
-            // send ownership transfer message to closest & all enclosing neighbors
-            msg.targets = _Voronoi->get_en (_self.id);
+            // send ownership transfer message to the new owner,
+            // clients are notified of the switch only after it acknowledges
             msg.addTarget (it->first);                            
             
             _net->sendVONMessage (msg);
-
-            // cleanup
-            delete it->second;
         }
 
-        // TODO: also transfer some states?        
         return num_transfer;
     }
 
@@ -698,6 +850,9 @@ namespace Vast
         // missing objects to request
         vector<id_t> request_list;
 
+        // accepted transfers to acknowledge, grouped by old owner
+        map<id_t, vector<id_t> > ack_list;
+
         // go through each transfer
         for (listsize_t i=0; i < n; i++)
         {
@@ -724,10 +879,18 @@ namespace Vast
                         
             // if I am new owner
             if (to_me)
+            {
                 acceptTransfer (transfer);
+                if (transfer.old_owner != 0)
+                    ack_list[transfer.old_owner].push_back (transfer.obj_id);
+            }
 
         } // for each transfer
 
+        // confirm accepted transfers so old owners can release ownership
+        for (map<id_t, vector<id_t> >::iterator it = ack_list.begin (); it != ack_list.end (); it++)
+            acknowledgeTransfer (it->first, it->second);
+
         // send request for missing objects to policy layer
         if (request_list.size () > 0)
             requestObjects (in_msg.from, request_list);
@@ -744,21 +907,27 @@ namespace Vast
         so.is_owner     = true;
         so.last_update  = _net->getTimestamp ();
         
-        // send acknowledgement of TRANSFER
-        if (transfer.old_owner != 0)
-        {
-            Message msg (VSO_TRANSFER_ACK);
-            msg.priority = 1;
-            msg.store (transfer.obj_id);
-            msg.addTarget (transfer.old_owner);
-            _net->sendVONMessage (msg);
-        }
-        
         // reset reclaim countdown 
         if (_reclaim_timeout.find (transfer.obj_id) != _reclaim_timeout.end ())
             _reclaim_timeout.erase (transfer.obj_id);        
     }
 
+    // confirm accepted ownership transfers to the previous owner
+    void 
+    VSOPeer::acknowledgeTransfer (id_t old_owner, vector<id_t> &obj_list)
+    {
+        Message msg (VSO_TRANSFER_ACK);
+        msg.priority = 1;
+
+        listsize_t n = (listsize_t)obj_list.size ();
+        msg.store (n);
+        for (listsize_t i=0; i < n; i++)
+            msg.store (obj_list[i]);
+
+        msg.addTarget (old_owner);
+        _net->sendVONMessage (msg);
+    }
+
     // make an object my own
     void 
     VSOPeer::claimOwnership (id_t obj_id, VSOSharedObject &so)
@@ -910,6 +1079,15 @@ namespace Vast
             // remove obsolete objects (those unowned objects no longer being updated)
             // and send keep alive for owned objects
             refreshObjects ();
+
+#ifdef VSO_PREDICTIVE_LOAD
+            // record load history & exchange load forecast with neighbors
+            if (_is_static == false)
+            {
+                sampleLoading ();
+                reportLoading ();
+            }
+#endif
         }
 
         // move the VSOPeer's position 
@@ -918,6 +1096,9 @@ namespace Vast
         // check if we need to transfer ownership to neighboring region periodically
         checkOwnershipTransfer ();
 
+        // send out some of the queued transfers
+        streamTransfers ();
+
         // check if we need to send object updates to neighboring regions
         // NOTE: must run *after* ownership transfer check, so only owned objects are checked
         checkUpdateToNeighbors ();
@@ -950,6 +1131,13 @@ namespace Vast
         {                    
             VSOOwnerTransfer &transfer = _transfer[obj_id];
             acceptTransfer (transfer);
+
+            if (transfer.old_owner != 0)
+            {
+                vector<id_t> obj_list;
+                obj_list.push_back (obj_id);
+                acknowledgeTransfer (transfer.old_owner, obj_list);
+            }
             _transfer.erase (obj_id);
         }
 
@@ -975,6 +1163,10 @@ namespace Vast
 
         VSOSharedObject &so = it->second;
 
+        // record whether an object not owned by me is moving towards me (likely to become my load)
+        if (so.is_owner == false)
+            so.approaching = (aoi.center.distance (_self.aoi.center) < so.aoi.center.distance (_self.aoi.center));
+
         // NOTE that it's okay to update an object not owned by me 
         // for example, if object's AOI covers this VSOPeer's region
         so.aoi = aoi;
@@ -1080,6 +1272,149 @@ namespace Vast
         return true;
     }
 
+    // sample current load indicators into history, and forecast loading from trends
+    void 
+    VSOPeer::sampleLoading ()
+    {
+        VSOLoadStat sample = _load;
+
+        // per-second rates (counters may restart if the underlying network is re-created)
+        sample.msg_rate  = (float)(_msg_count >= _last_msg_count ? _msg_count - _last_msg_count : 0);
+        sample.send_rate = (float)(_send_size >= _last_send_size ? _send_size - _last_send_size : 0);
+
+        _last_msg_count = _msg_count;
+        _last_send_size = _send_size;
+
+        _load_history.push_back (sample);
+        if (_load_history.size () > VSO_LOAD_HISTORY)
+            _load_history.erase (_load_history.begin ());
+
+        float forecast = sample.level;
+        size_t n = _load_history.size ();
+        size_t i;
+
+        // estimate the per-second trend of each indicator by least squares
+        if (n >= 2)
+        {
+            float mean_x = (float)(n - 1) / 2;
+            float mean_level = 0, mean_msg = 0, mean_send = 0;
+
+            for (i=0; i < n; i++)
+            {
+                mean_level += _load_history[i].level;
+                mean_msg   += _load_history[i].msg_rate;
+                mean_send  += _load_history[i].send_rate;
+            }
+            mean_level /= n;
+            mean_msg   /= n;
+            mean_send  /= n;
+
+            float sxx = 0, s_level = 0, s_msg = 0, s_send = 0;
+            for (i=0; i < n; i++)
+            {
+                float dx = (float)i - mean_x;
+                sxx     += dx * dx;
+                s_level += dx * (_load_history[i].level - mean_level);
+                s_msg   += dx * (_load_history[i].msg_rate - mean_msg);
+                s_send  += dx * (_load_history[i].send_rate - mean_send);
+            }
+
+            // extrapolate the subscription load linearly
+            forecast += (s_level / sxx) * VSO_LOAD_FORECAST;
+
+            // growth in traffic relative to its average signals more load per subscription
+            // (e.g., a flash crowd publishing heavily), scale current load accordingly
+            float growth = 0;
+            if (mean_msg > 0 && (s_msg / sxx) * VSO_LOAD_FORECAST / mean_msg > growth)
+                growth = (s_msg / sxx) * VSO_LOAD_FORECAST / mean_msg;
+            if (mean_send > 0 && (s_send / sxx) * VSO_LOAD_FORECAST / mean_send > growth)
+                growth = (s_send / sxx) * VSO_LOAD_FORECAST / mean_send;
+
+            if (sample.level * (1 + growth) > forecast)
+                forecast = sample.level * (1 + growth);
+        }
+
+        // objects in neighboring regions moving towards me will likely become my load
+        int owned = getOwnedObjectSize ();
+        if (owned > 0)
+        {
+            int inbound = 0;
+            for (map<id_t, VSOSharedObject>::iterator it = _objects.begin (); it != _objects.end (); it++)
+            {
+                if (it->second.is_owner == false && it->second.approaching)
+                    inbound++;
+            }
+
+            forecast += inbound * (sample.level / owned);
+        }
+
+        if (forecast < 0)
+            forecast = 0;
+
+        _load = sample;
+        _load.forecast = forecast;
+
+#ifdef VSO_WEIGHTED_REGION
+        // shrink or grow my region according to (forecasted) loading
+        _Voronoi->setWeight (_self.id, getRegionWeight (forecast));
+#endif
+    }
+
+    // send my load stat to enclosing neighbors
+    void 
+    VSOPeer::reportLoading ()
+    {
+        if (isJoined () == false)
+            return;
+
+        vector<id_t> &en_list = _Voronoi->get_en (_self.id);
+
+        // forget load reports of nodes no longer my enclosing neighbors
+        map<id_t, VSOLoadStat>::iterator it = _neighbor_load.begin ();
+        while (it != _neighbor_load.end ())
+        {
+            if (find (en_list.begin (), en_list.end (), it->first) == en_list.end ())
+                _neighbor_load.erase (it++);
+            else
+                it++;
+        }
+
+        if (en_list.size () == 0)
+            return;
+
+        Message msg (VSO_LOAD);
+        msg.priority = 1;
+        msg.store (_load);
+        msg.targets = en_list;
+
+        _net->sendVONMessage (msg);
+    }
+
+    // get the average forecasted load level of my enclosing neighbors
+    float 
+    VSOPeer::getNeighborLoading ()
+    {
+        if (_neighbor_load.size () == 0)
+            return 0;
+
+        float total = 0;
+        for (map<id_t, VSOLoadStat>::iterator it = _neighbor_load.begin (); it != _neighbor_load.end (); it++)
+            total += it->second.forecast;
+
+        return total / _neighbor_load.size ();
+    }
+
+    // get the region weight for a given load level
+    double 
+    VSOPeer::getRegionWeight (float level)
+    {
+        // limit the range of weights so that regions of loaded nodes do not vanish
+        if (level > 2.0f)
+            level = 2.0f;
+
+        return VSO_REGION_WEIGHT * (1.0 - level);
+    }
+
     bool 
     VSOPeer::isLegalPosition (const Position &pos, bool include_self)
     {        
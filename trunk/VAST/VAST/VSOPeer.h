@@ -52,9 +52,22 @@
 #define VSO_PEER_AOI_BUFFER             (5)    // buffer for a VSOPeer's AOI (which needs to cover all AOI of the objects it manages)
 
 
+// predictive load balancing settings
+#define VSO_PREDICTIVE_LOAD_                    // forecast overload from load trends & act before it occurs (remove '_' to enable)
+#define VSO_LOAD_HISTORY                (8)     // # of per-second load samples kept for trend estimation
+#define VSO_LOAD_FORECAST               (3)     // # of seconds ahead to forecast the loading
+#define VSO_PREINSERT_LEVEL             (1.5f)  // forecasted load level beyond which insertion is requested directly
+
+// weighted region settings (requires VSO_PREDICTIVE_LOAD to exchange loading among neighbors)
+#define VSO_WEIGHTED_REGION_                    // size regions by load with a power Voronoi diagram instead of moving only (remove '_' to enable)
+#define VSO_REGION_WEIGHT               (2500)  // region weight (in squared distance) of an idle node, decreases as load level increases
+
 // ownership transfer setting
 #define VSO_TIMEOUT_TRANSFER            (0.3)   // # of seconds before transfering ownership to a neighbor
 #define VSO_TIMEOUT_AUTO_REMOVE         (2.0)   // # of seconds to delete an un-owned object if it's not being updated
+#define VSO_TRANSFER_BUDGET             (8192)  // max bytes of object states streamed to new owners per tick
+
+#define VSO_TRANSIT_QUEUED              ((timestamp_t)(-1))     // in_transit value for objects waiting to be streamed
 
 using namespace std;
 
@@ -75,6 +88,7 @@ namespace Vast
         VSO_TRANSFER,           // transfer ownership of an object
         VSO_TRANSFER_ACK,       // acknowledgment of ownership transfer
         VSO_REQUEST,            // request for object
+        VSO_LOAD,               // periodic load report to enclosing neighbors
         
     } VSO_Message;
 
@@ -90,14 +104,67 @@ namespace Vast
             in_transit  = 0;
             last_update = 0;
             closest     = 0;
+            approaching = false;
         };
 
         void *      obj;            // pointer to the object itself
         Area        aoi;            // area of interest of the object (will determine how far the object should spread)
         bool        is_owner;       // whether it is owned by the local host
-        timestamp_t in_transit;     // countdown of object in ownership transfer to others 
+        timestamp_t in_transit;     // countdown of object in ownership transfer to others (VSO_TRANSIT_QUEUED if not yet sent)
         timestamp_t last_update;    // time of object's last update (used for Object expiring)
         id_t        closest;        // ID for closest managing node for this object
+        bool        approaching;    // whether an un-owned object is moving towards this node (inbound load)
+    };
+
+    // load indicators of a VSOPeer, sampled once per second
+    class VSOLoadStat : public Serializable
+    {
+    public:
+        VSOLoadStat ()
+        {
+            level       = 0;
+            msg_rate    = 0;
+            send_rate   = 0;
+            forecast    = 0;
+        }
+
+        // size of this class
+        inline size_t sizeOf () const
+        {
+            return sizeof (float)*4;
+        }
+
+        size_t serialize (char *p) const
+        {
+            if (p != NULL)
+            {
+                memcpy (p, &level, sizeof (float));     p += sizeof (float);
+                memcpy (p, &msg_rate, sizeof (float));  p += sizeof (float);
+                memcpy (p, &send_rate, sizeof (float)); p += sizeof (float);
+                memcpy (p, &forecast, sizeof (float));
+            }
+            return sizeOf ();
+        }
+
+        size_t deserialize (const char *p, size_t size)
+        {
+            // perform size check
+            if (p != NULL && size >= sizeOf ())
+            {
+                memcpy (&level, p, sizeof (float));     p += sizeof (float);
+                memcpy (&msg_rate, p, sizeof (float));  p += sizeof (float);
+                memcpy (&send_rate, p, sizeof (float)); p += sizeof (float);
+                memcpy (&forecast, p, sizeof (float));
+
+                return sizeOf ();
+            }
+            return 0;
+        }
+
+        float   level;      // subscription load (# of owned objects / limit)
+        float   msg_rate;   // # of messages handled per second
+        float   send_rate;  // # of bytes sent per second
+        float   forecast;   // forecasted load level VSO_LOAD_FORECAST seconds later
     };
 
     // message for ownership transfer
@@ -176,6 +243,14 @@ namespace Vast
         // note that this will be called continously until the situation improves
         void notifyLoading (float level);
 
+        // record raw load indicators for trend forecasting, may be called every tick
+        // level is the un-thresholded load level (# of owned objects / limit), 
+        // msg_count & send_size are accumulated counts of messages handled & bytes sent
+        void recordLoading (float level, size_t msg_count, size_t send_size);
+
+        // get the forecasted load level (VSO_LOAD_FORECAST seconds later)
+        float getLoadForecast ();
+
         // notify the gateway that I can be available to join
         //bool notifyCandidacy ();
 
@@ -254,12 +329,19 @@ namespace Vast
         // returns the # of transfers
         int checkOwnershipTransfer ();
 
+        // stream queued ownership transfers to new owners, within VSO_TRANSFER_BUDGET bytes per tick
+        // returns the # of objects sent
+        int streamTransfers ();
+
         // process ownership transfer notification
         void processTransfer (Message &in_msg);
 
         // accept and ownership transfer
         void acceptTransfer (VSOOwnerTransfer &transfer);
 
+        // confirm accepted ownership transfers to the previous owner
+        void acknowledgeTransfer (id_t old_owner, vector<id_t> &obj_list);
+
         // make an object my own
         void claimOwnership (id_t obj_id, VSOSharedObject &so);
 
@@ -273,6 +355,20 @@ namespace Vast
         // get the center of all current objects I maintain
         bool getLoadCenter (Position &center);
 
+        // sample current load indicators into history, and forecast loading from trends
+        void sampleLoading ();
+
+        // send my load stat to enclosing neighbors
+        void reportLoading ();
+
+        // get the average forecasted load level of my enclosing neighbors
+        // returns 0 if no load reports are known
+        float getNeighborLoading ();
+
+        // get the region weight for a given load level
+        // NOTE load level is normalized by each host's own resources, so it reflects host capacity as well
+        double getRegionWeight (float level);
+
         // check whether a new node position is legal
         bool isLegalPosition (const Position &pos, bool include_self);
 
@@ -304,6 +400,7 @@ namespace Vast
         map<id_t, timestamp_t>      _reclaim_timeout;         // onset time to reclaim ownership to unowned objects
         
         map<id_t, VSOOwnerTransfer> _transfer;              // pending ownership transfers
+        vector<id_t>                _transfer_queue;        // owned objects waiting to be streamed to new owners (oldest first)
         map<id_t, id_t>             _obj_requested;         // objects request & the target being asked
 
         // counters & time record 
@@ -313,6 +410,15 @@ namespace Vast
         timestamp_t         _underload_timeout;   // underload time   
 
         timestamp_t         _next_periodic;     // last timestamp executing periodic task
+
+        // load history & forecast
+        VSOLoadStat         _load;              // most recent load stat (with forecast)
+        vector<VSOLoadStat> _load_history;      // per-second load samples, oldest first
+        map<id_t, VSOLoadStat> _neighbor_load;  // last load stat reported by enclosing neighbors
+        size_t              _msg_count;         // accumulated # of messages handled (as last recorded)
+        size_t              _send_size;         // accumulated # of bytes sent (as last recorded)
+        size_t              _last_msg_count;    // _msg_count at last sampling
+        size_t              _last_send_size;    // _send_size at last sampling
     };
 
 } // namespace Vast
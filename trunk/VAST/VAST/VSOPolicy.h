@@ -33,12 +33,27 @@
 #include "Config.h"
 #include "VASTTypes.h"
 #include <map>
+#include <vector>
 
 using namespace std;
 
 
 namespace Vast
 {
+    // physical coordinate of some subscribers & their weight (e.g. # of subscribers),
+    // used to place a new node physically close to those it will serve
+    class PlacementDemand
+    {
+    public:
+        PlacementDemand ()
+            :weight (0)
+        {
+        }
+
+        Position    coord;
+        float       weight;
+    };
+
     class VSOPolicy
     {
 
@@ -51,8 +66,13 @@ namespace Vast
         // whether the current node can be a spare node for load balancing
         //virtual bool isCandidate () = 0;
 
-        // find a candidate node suitable for promotion (gateway-only)
-        virtual bool findCandidate (Addr &new_node, float level) = 0;
+        // find a candidate node suitable for promotion (gateway-only),
+        // optionally the physical demand of the region the new node will serve
+        virtual bool findCandidate (Addr &new_node, float level, vector<PlacementDemand> *demand = NULL) = 0;
+
+        // obtain the physical demand of the region a new node inserted at 'join_pos' will take over
+        // returns the # of entries
+        virtual int getPlacementDemand (const Position &join_pos, vector<PlacementDemand> &demand) = 0;
 
         // obtain the ID of the gateway node
         virtual id_t getGatewayID () = 0;
@@ -61,6 +81,9 @@ namespace Vast
         // returns # of successful transfer
         virtual int copyObject (id_t target, vector<id_t> &obj_list, bool update_only) = 0;
 
+        // obtain the size of an object when copied in full (to stream ownership transfers under a byte budget)
+        virtual size_t getObjectSize (id_t obj_id) = 0;
+
         // remove an obsolete unowned object
         virtual bool removeObject (id_t obj_id) = 0;
 
@@ -33,9 +33,13 @@
 #include "VAST.h"
 #include "VASTATEsim.h"
 #include "SimPeer.h"
+#include "AOIGroundTruth.h"
 
 #define SNAPSHOT_INTERVAL   (100)
 
+// # of nodes sampled in each snapshot interval to estimate consistency (0 checks all nodes)
+#define STAT_SAMPLE_SIZE    (0)
+
 using namespace std;
 using namespace Vast;
 
@@ -49,6 +53,10 @@ public:
         _AN_actual_accumulated = _AN_visible_accumulated = 0;
         _AN_actual_first_interval = _AN_visible_first_interval =0;
         _fp = NULL;
+        _truth = NULL;
+        _sample_size = STAT_SAMPLE_SIZE;
+        _sample_count = 0;
+        _sample_seed = 37;
     }
 
     ~statistics ()
@@ -64,6 +72,9 @@ public:
         _inconsistent_nodes.clear ();
 
         _simnodes.clear ();
+
+        if (_truth != NULL)
+            delete _truth;
     }
 
     void init_variables ()
@@ -79,6 +90,40 @@ public:
 
         for (int i=0; i<_para.NODE_SIZE; ++i)
             _last_consistent.push_back (_steps);
+
+        // draw a new sample of nodes for the coming interval
+        if (_sample_size > 0)
+        {
+            _sampled.assign (_para.NODE_SIZE, false);
+            _sample_actual.assign (_para.NODE_SIZE, 0);
+            _sample_visible.assign (_para.NODE_SIZE, 0);
+            _sample_count = 0;
+
+            // partial shuffle of current nodes (independent of rand (), to keep simulations repeatable)
+            vector<size_t> order;
+            for (size_t i=0; i < _simnodes.size (); i++)
+                order.push_back (i);
+
+            for (size_t i=0; i < order.size () && _sample_count < _sample_size; i++)
+            {
+                _sample_seed ^= _sample_seed << 13;
+                _sample_seed ^= _sample_seed >> 17;
+                _sample_seed ^= _sample_seed << 5;
+
+                size_t j = i + _sample_seed % (order.size () - i);
+                swap (order[i], order[j]);
+
+                _sampled[order[i]] = true;
+                _sample_count++;
+            }
+        }
+    }
+
+    // check consistency of only a random sample of nodes in each snapshot interval
+    // (0 checks all nodes), should be called before init_timer ()
+    void set_sample_size (size_t size)
+    {
+        _sample_size = size;
     }
 
     void init_timer (SimPara &para)
@@ -91,6 +136,9 @@ public:
         sprintf (filename, "N%04d_S%d_A%d_C%02d_V%02d_L%03d_F%03d", _para.NODE_SIZE, _para.TIME_STEPS, _para.AOI_RADIUS, _para.CONNECT_LIMIT, _para.VELOCITY, _para.LOSS_RATE, _para.FAIL_RATE);
         _fp = LogFileManager::open (filename);
 
+        // grid cells about the size of an AOI (negative radius means random radius up to the value)
+        _truth = new AOIGroundTruth ((coord_t)abs (_para.AOI_RADIUS));
+
         print_header ();
         init_variables ();
     }
@@ -99,49 +147,63 @@ public:
     void add_node (SimPeer *node)
     {
         _simnodes.push_back (node);
+
+        // nodes joining before the sample is full are sampled
+        if (_sample_size > 0 && _sample_count < _sample_size && _simnodes.size () <= _sampled.size ())
+        {
+            _sampled[_simnodes.size () - 1] = true;
+            _sample_count++;
+        }
+    }
+
+    // whether a node's consistency is checked in the current interval
+    bool is_sampled (size_t i)
+    {
+        return (_sample_size == 0 || (i < _sampled.size () && _sampled[i]));
+    }
+
+    // pass positions of all nodes to the ground truth, only neighbors of moved nodes are recomputed
+    void update_ground_truth ()
+    {
+        for (size_t i=0; i < _simnodes.size (); ++i)
+            _truth->update (i, _simnodes[i]->isFailed () == false, _simnodes[i]->get_pos (), _simnodes[i]->get_aoi ());
     }
 
     void calc_consistency (size_t i, size_t &AN_actual, size_t &AN_visible, size_t &total_drift, size_t &max_drift, size_t &drift_nodes)
     {
-        size_t n = _simnodes.size ();
         Node *neighbor;
         AN_actual = AN_visible = total_drift = max_drift = drift_nodes = 0;
 
-        // loop through all nodes
-        for (size_t j=0; j<n; ++j)
+        // actual AOI neighbors (failed nodes excluded)
+        const vector<size_t> &actual = _truth->getNeighbors (i);
+
+        // loop through all nodes within AOI
+        for (size_t k=0; k < actual.size (); ++k)
         {
-            // skip self-check
-            if (i == j || _simnodes[j]->isFailed ())
-                continue;
+            size_t j = actual[k];
 
-            // visible neighbors
-            if (_simnodes[i]->in_view (_simnodes[j]))
-            {
-                AN_actual++;
+            AN_actual++;
 
-                if ((neighbor = _simnodes[i]->knows (_simnodes[j])) != NULL)
-                {
-                    AN_visible++;
+            if ((neighbor = _simnodes[i]->knows (_simnodes[j])) != NULL)
+            {
+                AN_visible++;
 
-                    // calculate drift distance (except self)
-                    // NOTE: drift distance is calculated for all known AOI neighbors
-                    drift_nodes++;
+                // calculate drift distance (except self)
+                // NOTE: drift distance is calculated for all known AOI neighbors
+                drift_nodes++;
 
-                    size_t drift = (size_t)neighbor->aoi.center.distance (_simnodes[j]->get_pos ());
-                    total_drift += drift;
+                size_t drift = (size_t)neighbor->aoi.center.distance (_simnodes[j]->get_pos ());
+                total_drift += drift;
 
-                    if (max_drift < drift)
-                    {
-                        max_drift = drift;
+                if (max_drift < drift)
+                {
+                    max_drift = drift;
 #ifdef DEBUG_DETAIL
-                        printf ("%4d - max drift updated: [%d] info on [%d] drift: %d\n", _steps+1, (int)_simnodes[i]->get_id (), (int)neighbor->id, (int)drift);
+                    printf ("%4d - max drift updated: [%d] info on [%d] drift: %d\n", _steps+1, (int)_simnodes[i]->get_id (), (int)neighbor->id, (int)drift);
 #endif
-                    }
                 }
             }
-        } // end looping through all other nodes
-
-
+        } // end looping through AOI neighbors
     }
 
     // NOTE: some variable abbreviation
@@ -169,16 +231,24 @@ public:
 
         size_t recovery_steps;
 
+        update_ground_truth ();
+
         // loop through all nodes to calculate statistics
         for (i=0; i<n; ++i)
         {
             // skip all failed nodes
-            if (_simnodes[i]->isFailed ())
+            if (_simnodes[i]->isFailed () || is_sampled (i) == false)
                 continue;
 
             // find actual AOI neighbor (from a global view)
             calc_consistency (i, AN_actual, AN_visible, total_drift, max_drift, drift_nodes);
 
+            if (_sample_size > 0)
+            {
+                _sample_actual[i]  += AN_actual;
+                _sample_visible[i] += AN_visible;
+            }
+
             // record stat
             _drift_nodes += drift_nodes;
             _total_drift += total_drift;
@@ -278,9 +348,14 @@ public:
         fprintf (_fp, "For each metric, first number is the average, the second is either the maximum or minimum.                    \n");
         fprintf (_fp, "                                                                                                              \n");
         fprintf (_fp, "Snapshot interval: %d time-steps                                                                              \n", SNAPSHOT_INTERVAL);
+        if (_sample_size > 0)
+            fprintf (_fp, "TC is estimated from %lu sampled nodes per interval, with a 95%% confidence interval                          \n", (unsigned long)_sample_size);
         fprintf (_fp, "                                                                                                              \n");
         //if (_para.VAST_MODEL != VAST_MODEL_MULTICAST)
-        fprintf (_fp, "TC              Send (max)         Recv (max)     RS (max)   DD (max)   AOI (min)   CN (max)    AN (max)     RC (total)         TC raw data\n");
+        fprintf (_fp, "TC              Send (max)         Recv (max)     RS (max)   DD (max)   AOI (min)   CN (max)    AN (max)     RC (total)         TC raw data");
+        if (_sample_size > 0)
+            fprintf (_fp, "   TC (95%% CI) sampled");
+        fprintf (_fp, "\n");
 
         //else
         //    fprintf (_fp, "TC              Send (max)         Recv (max)       Send-d (max)       Recv-d (max)     RS (max)   DD (max)   AOI (min)   CN (max)    AN (max)    RC (total)         TC raw data\n");
@@ -293,9 +368,10 @@ public:
             return;
 
         int num_nodes   = _simnodes.size ();
-        int num_samples = (_steps % SNAPSHOT_INTERVAL) * num_nodes;
+        int num_checked = (_sample_size > 0 ? (int)_sample_count : num_nodes);
+        int num_samples = (_steps % SNAPSHOT_INTERVAL) * num_checked;
         if (num_samples == 0)
-            num_samples = SNAPSHOT_INTERVAL * num_nodes;
+            num_samples = SNAPSHOT_INTERVAL * num_checked;
 
         long min_aoi = _para.AOI_RADIUS;
         float total_aoi = 0;
@@ -315,7 +391,7 @@ public:
         int i;
         for (i=0; i<num_nodes; ++i)
         {
-            if (_last_consistent[i] < _steps)
+            if (_last_consistent[i] < _steps && is_sampled (i))
             {
                 _inconsistent_count++;
 
@@ -385,6 +461,25 @@ public:
         // TC actual data
         fprintf (_fp, " %7u %7u ", _total_AN_visible, _total_AN_actual);
 
+        // estimated consistency of all nodes from the sampled ones
+        if (_sample_size > 0)
+        {
+            RatioSample sample;
+            int num_active = 0;
+
+            for (i=0; i<num_nodes; ++i)
+            {
+                if (_simnodes[i]->isFailed ())
+                    continue;
+
+                num_active++;
+                if (_sampled[i])
+                    sample.add ((double)_sample_visible[i], (double)_sample_actual[i]);
+            }
+
+            fprintf (_fp, "  %3.4f%% (+-%3.4f%%) %lu", sample.getRatio () * 100, sample.getInterval (num_active) * 100, (unsigned long)sample.size ());
+        }
+
 
 
 
@@ -512,6 +607,16 @@ private:
     size_t          _max_RS, _recovery_steps, _recovery_count, _inconsistent_count;
 
     vector<pair<size_t, Vast::id_t> *> _inconsistent_nodes;    // node ids
+
+    // actual AOI neighbors of all nodes
+    AOIGroundTruth *_truth;
+
+    // sampled consistency
+    size_t          _sample_size;       // # of nodes to sample per interval (0 for all)
+    size_t          _sample_count;      // # of nodes sampled in current interval
+    uint32_t        _sample_seed;
+    vector<bool>    _sampled;           // whether each node is sampled
+    vector<size_t>  _sample_actual, _sample_visible;    // AN of sampled nodes over current interval
 };
 
 
@@ -140,22 +140,52 @@ namespace Vast
     void
     MessageQueue::tick ()
     {
+        bool profiling = (_profiler != NULL && _profiler->isEnabled ());
+
         // convert incoming messages to VAST or socket messages first
-        _net->process ();
+        {
+            ProfileScope scope (_profiler, PROFILE_NET_PROCESS);
+            _net->process ();
+        }
+
+        if (profiling)
+            _profiler->recordQueueDepth (_net->getQueueSize ());
 
         // process incoming (external) messages first and flushing out the messages
-        processMessages ();
+        {
+            ProfileScope scope (_profiler, PROFILE_MESSAGES);
+            processMessages ();
+        }
 
         // perform post handleMessage tasks for each handler        
-        map<id_t, MessageHandler *>::iterator it;       
-        for (it = _handlers.begin (); it != _handlers.end (); it++)
-            it->second->postHandling ();
+        {
+            ProfileScope scope (_profiler, PROFILE_POST_HANDLING);
+
+            map<id_t, MessageHandler *>::iterator it;       
+            for (it = _handlers.begin (); it != _handlers.end (); it++)
+            {
+                if (profiling)
+                {
+                    uint64_t start = _profiler->getTime ();
+                    it->second->postHandling ();
+                    _profiler->recordPostHandling (it->first, _profiler->getTime () - start);
+                }
+                else
+                    it->second->postHandling ();
+            }
+        }
 
-        _net->flush ();
+        {
+            ProfileScope scope (_profiler, PROFILE_NET_FLUSH);
+            _net->flush ();
+        }
 
         // process once more for internal messages (targeted at self)
         // (e.g., to reflect proper neighbor list for Clients)
-        processMessages ();
+        {
+            ProfileScope scope (_profiler, PROFILE_MESSAGES);
+            processMessages ();
+        }
     }
 
     // store default route for unaddressable targets
@@ -165,6 +195,13 @@ namespace Vast
         _default_host = default_host;
     }
 
+    // set profiler to record time spent in each part of tick () (NULL to disable)
+    void 
+    MessageQueue::setProfiler (Profiler *profiler)
+    {
+        _profiler = profiler;
+    }
+
 
     // process all currently received messages (invoking previously registered handlers)
     // return the number of messsages processed
@@ -178,6 +215,8 @@ namespace Vast
         
         map<id_t, MessageHandler *>::iterator it;       // iterator for message handlers
 
+        bool profiling = (_profiler != NULL && _profiler->isEnabled ());
+
         // go through each of the message received at the network layer, 
         // invoke the respective handlers 
         // NOTE: if it's a UDP message, fromhost may be NET_ID_UNASSIGNED
@@ -278,8 +317,16 @@ namespace Vast
                         printf ("MessageQueue::processMessages () cannot find proper handler with msggroup: %d for message from [%d]\n", (int)msggroup, (int)recvmsg->from);
                         continue;
                     }
+
+                    // handler may modify the message, so record its type first
+                    msgtype_t msgtype = recvmsg->msgtype;
+                    uint64_t start = (profiling ? _profiler->getTime () : 0);
+
                     if (_handlers[msggroup]->handleMessage (*recvmsg) == true)
                         num_msg++;                          
+
+                    if (profiling)
+                        _profiler->recordMessage (msggroup, msgtype, _profiler->getTime () - start);
                 }
 
                 /*
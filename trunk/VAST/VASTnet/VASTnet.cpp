@@ -21,6 +21,7 @@
 #include "VASTnet.h"
 #include "net_ace.h"
 #include "net_emu.h"
+#include <functional>     // greater
 
 namespace Vast
 {   
@@ -30,19 +31,20 @@ namespace Vast
 
     using namespace std;
 
-    VASTnet::VASTnet (VAST_NetModel model, unsigned short port, int steps_persec)
+    VASTnet::VASTnet (VAST_NetModel model, unsigned short port, int steps_persec, net_ace_reactor *reactor, VASTPara_Sim *simpara)
         : _model (model),
           _is_public (true), 
-          _timeout_IDrequest (0),
-          _timeout_cleanup (0)
+          _timeout_IDrequest (0),
+          _timeout_cleanup (0),
+          _conn_limit (0)
     {        
 
         // create network manager given the network model and start it
         if (_model == VAST_NET_EMULATED)
-            _manager = new net_emu (steps_persec);
+            _manager = new net_emu (steps_persec, simpara);
 
         else if (_model == VAST_NET_ACE)
-            _manager = new net_ace (port);
+            _manager = new net_ace (port, reactor);
 
         _recvmsg = NULL;
         _recvmsg_socket = NULL;
@@ -178,6 +180,7 @@ namespace Vast
         }
 
         // make sure we have a connection, or establish one if not
+        // NOTE: messages to a host still being connected stay queued until the connection completes
         if (validateConnection (target) == false)
             return 0;
         
@@ -197,11 +200,26 @@ namespace Vast
         header.end = 5;
         header.type = type;
         header.msg_size = msg.serialize (NULL);
+
+#ifdef VASTNET_RECORD_LATENCY
+        // send time is appended after the message
+        header.msg_size += sizeof (timestamp_t);
+#endif
         
         // prepare bytestring with header & serialized message
         buf->add ((char *)&header, sizeof (VASTHeader));
         buf->add (&msg);
 
+#ifdef VASTNET_RECORD_LATENCY
+        timestamp_t sendtime = getTimestamp ();
+        buf->add ((char *)&sendtime, sizeof (timestamp_t));
+#endif
+
+#ifdef VASTNET_RECORD_QUEUE_DELAY
+        // record when the message is queued, to find its queueing delay at flush
+        _pending_sends.push_back (std::pair<msgtype_t, unsigned long long> (msg.msgtype, TimeMonitor::instance ()->getTime ()));
+#endif
+
         // collect download transmission stat
         updateTransmissionStat (target, msg.msgtype, msg.size + sizeof (VASTHeader), 1);
 
@@ -284,6 +302,16 @@ namespace Vast
         }        
 
         size_t flush_size = 0;     // number of total bytes sent this time
+
+        timestamp_t now = _manager->getTimestamp (); 
+
+        // idle kept-alive hosts get a heartbeat in their TCP queues
+        if (_liveness.size () > 0)
+            sendHeartbeats (now);
+
+        // see which pending connections are now established
+        if (_connecting.size () > 0)
+            checkConnecting (now);
         
         // check if there are any pending TCP queues
         std::map<id_t, VASTBuffer *>::iterator it;
@@ -292,10 +320,17 @@ namespace Vast
             id_t target = it->first;        
             VASTBuffer *buf = it->second;
 
+            // keep the messages until the connection is established
+            if (buf->size > 0 && _connecting.find (target) != _connecting.end ())
+                continue;
+
             // check if there's something to send
             // TODO: remove empty buffers after some time
             if (buf->size > 0)
+            {
                 flush_size += _manager->send (target, buf->data, buf->size);            
+                _liveness[target].last_send = now;
+            }
 
             // clear the buffer whether the message is sent or not
             buf->clear ();
@@ -312,14 +347,25 @@ namespace Vast
             {
                 Addr &addr = _id2addr[target];
                 flush_size += _manager->send (target, buf->data, buf->size, &addr);
+                _liveness[target].last_send = now;
             }
                 
             // clear buffer whether we've sent sucessfully or not
             buf->clear ();
         }
 
+#ifdef VASTNET_RECORD_QUEUE_DELAY
+        // record how long each message has been waiting
+        if (_pending_sends.size () > 0)
+        {
+            unsigned long long now_us = TimeMonitor::instance ()->getTime ();
+            for (size_t i=0; i < _pending_sends.size (); i++)
+                _type2stat[_pending_sends[i].first].queue_delay.record (now_us - _pending_sends[i].second);
+            _pending_sends.clear ();
+        }
+#endif
+
         // call cleanup every once in a while
-        timestamp_t now = _manager->getTimestamp (); 
         if (now > _timeout_cleanup)
         {
             _timeout_cleanup = now + (TIMEOUT_CONNECTION_CLEANUP * _manager->getTimestampPerSecond ());
@@ -364,6 +410,15 @@ namespace Vast
             // first check for disconnection message
             if (curr_msg->size == 0)
             {
+                // a connection closed to stay within the connection limit (by either end) is not reported,
+                // it'll be re-established when next used
+                std::set<id_t>::iterator closing = _closing.find (curr_msg->fromhost);
+                if (closing != _closing.end ())
+                {
+                    _closing.erase (closing);
+                    continue;
+                }
+
                 Message *msg = new Message (DISCONNECT);
                 msg->from = curr_msg->fromhost;
                 storeVASTMessage (curr_msg->fromhost, msg);
@@ -380,7 +435,8 @@ namespace Vast
                 hq = it->second;
 
             // otherwise, determine if this is a VAST message            
-            else if (curr_msg->size > sizeof (VASTHeader))
+            // NOTE: a heartbeat is a VASTHeader only
+            else if (curr_msg->size >= sizeof (VASTHeader))
             {
                 memcpy (&header, curr_msg->msg, sizeof (VASTHeader));
 
@@ -593,6 +649,13 @@ namespace Vast
         return _is_public;
     }
 
+    // get the network model in use
+    VAST_NetModel 
+    VASTnet::getModel ()
+    {
+        return _model;
+    }
+
     // if an id is an entry point on the overlay
     bool 
     VASTnet::isEntryPoint (id_t id)
@@ -639,11 +702,41 @@ namespace Vast
         if (it == _id2addr.end ())
             return false;
 
+        // a connection is being established, messages will be queued till then
+        if (_connecting.find (host_id) != _connecting.end ())
+            return true;
+
         IPaddr &remote_addr = it->second.publicIP;
+        timestamp_t now = _manager->getTimestamp ();
+
+        // avoid repeated attempts to a host that just failed to connect
+        std::map<id_t, timestamp_t>::iterator retry = _connect_retry.find (host_id);
+        if (retry != _connect_retry.end ())
+        {
+            if (now < retry->second)
+                return false;
+            _connect_retry.erase (retry);
+        }
+
+        // make room for the new connection if the limit is reached
+        if (_conn_limit > 0 && countConnections () >= _conn_limit &&
+            evictConnection (now) == false)
+        {
+            printf ("VASTnet::validateConnection () connection limit (%lu) reached, cannot connect to [%llu]\n", (unsigned long)_conn_limit, host_id);
+            return false;
+        }
 
         // otherwise try to initiate connection & send handshake message
-        if (_manager->connect (host_id, remote_addr.host, remote_addr.port) == false)
+        // NOTE: the connection may complete later, the handshake is then the first message sent
+        int result = _manager->connectAsync (host_id, remote_addr.host, remote_addr.port);
+        if (result == (-1))
+        {
+            _connect_retry[host_id] = now + (TIMEOUT_CONNECT_RETRY * _manager->getTimestampPerSecond ());
             return false;
+        }
+
+        if (result == 0)
+            _connecting[host_id] = now;
         
         sendHandshake (host_id);
 
@@ -679,6 +772,13 @@ namespace Vast
         // TODO: currently empty
     }
 
+    // set max # of connections kept open (0 for no limit)
+    void 
+    VASTnet::setConnectionLimit (size_t limit)
+    {
+        _conn_limit = limit;
+    }
+
     // get how many timestamps (as returned by getTimestamp) is in a second 
     timestamp_t
     VASTnet::getTimestampPerSecond ()
@@ -691,7 +791,7 @@ namespace Vast
     std::map<id_t, Addr> &
     VASTnet::getConnections ()
     {
-        static std::map<id_t, Addr> conn_list;
+        std::map<id_t, Addr> &conn_list = _conn_list;
         conn_list.clear ();
 
         std::map<id_t, Addr>::iterator it = _id2addr.begin ();
@@ -829,8 +929,141 @@ namespace Vast
         _sendsize = _recvsize = 0;
         _type2sendsize.clear ();
         _type2recvsize.clear ();
+        _type2stat.clear ();
+        _peer2stat.clear ();
+    }
+
+    // obtain size, queueing delay & latency histograms of a message type, NULL if not yet recorded
+    MessageTypeStat *
+    VASTnet::getMessageTypeStat (msgtype_t msgtype)
+    {
+        std::map<msgtype_t, MessageTypeStat>::iterator it = _type2stat.find (msgtype);
+        if (it == _type2stat.end ())
+            return NULL;
+
+        return &it->second;
     }
 
+    // obtain the message types recorded so far
+    void
+    VASTnet::getMessageTypes (std::vector<msgtype_t> &list)
+    {
+        list.clear ();
+
+        std::map<msgtype_t, MessageTypeStat>::iterator it = _type2stat.begin ();
+        for (; it != _type2stat.end (); it++)
+            list.push_back (it->first);
+    }
+
+    // obtain up to 'limit' remote hosts with the most bytes sent (or received), in descending order
+    // returns the # of hosts found
+    int
+    VASTnet::getTopTalkers (int limit, std::vector<std::pair<id_t, size_t> > &list, bool send)
+    {
+        list.clear ();
+
+        if (limit <= 0)
+            return 0;
+
+        // sort by size first (descending), then by ID
+        std::multimap<size_t, id_t, std::greater<size_t> > sorted;
+
+        std::map<id_t, PeerStat>::iterator it = _peer2stat.begin ();
+        for (; it != _peer2stat.end (); it++)
+        {
+            size_t size = (send ? it->second.send_size : it->second.recv_size);
+            if (size > 0)
+                sorted.insert (std::multimap<size_t, id_t, std::greater<size_t> >::value_type (size, it->first));
+        }
+
+        std::multimap<size_t, id_t, std::greater<size_t> >::iterator it2 = sorted.begin ();
+        for (; it2 != sorted.end () && (int)list.size () < limit; it2++)
+            list.push_back (std::pair<id_t, size_t> (it2->second, it2->first));
+
+        return (int)list.size ();
+    }
+
+    // obtain the # of complete incoming messages not yet processed
+    size_t 
+    VASTnet::getQueueSize ()
+    {
+        return _full_queue.size ();
+    }
+
+    // wait until incoming messages are available or 'timeout' (in microseconds) passes
+    int 
+    VASTnet::waitInput (int timeout)
+    {
+        // messages already received but not yet processed
+        if (_full_queue.size () > 0)
+            return 1;
+
+        return _manager->waitInput (timeout);
+    }
+
+    // let a remote host know that we're alive for the next LIVENESS_KEEP_PERIOD seconds
+    void 
+    VASTnet::keepAlive (id_t host)
+    {
+        if (host == NET_ID_UNASSIGNED || host == _manager->getID ())
+            return;
+
+        _liveness[host].keep_until = getTimestamp () + (LIVENESS_KEEP_PERIOD * getTimestampPerSecond ());
+    }
+
+    // last time anything is received from a remote host, 0 if never
+    timestamp_t 
+    VASTnet::getLastReceived (id_t host)
+    {
+        std::map<id_t, PeerLiveness>::iterator it = _liveness.find (host);
+        return (it == _liveness.end () ? 0 : it->second.last_recv);
+    }
+
+    // whether anything is received from a remote host within the last 'period' seconds
+    bool 
+    VASTnet::isAlive (id_t host, double period)
+    {
+        timestamp_t last_recv = getLastReceived (host);
+        if (last_recv == 0)
+            return false;
+
+        return ((getTimestamp () - last_recv) < (timestamp_t)(period * getTimestampPerSecond ()));
+    }
+
+    // queue heartbeats (a header without message) to kept-alive hosts that are idle
+    void 
+    VASTnet::sendHeartbeats (timestamp_t now)
+    {
+        timestamp_t interval = LIVENESS_HEARTBEAT_INTERVAL * _manager->getTimestampPerSecond ();
+
+        VASTHeader header;
+        header.start    = 10;
+        header.end      = 5;
+        header.type     = REGULAR;
+        header.msg_size = 0;
+
+        std::map<id_t, PeerLiveness>::iterator it = _liveness.begin ();
+        for (; it != _liveness.end (); it++)
+        {
+            PeerLiveness &peer = it->second;
+
+            if (peer.keep_until < now || now - peer.last_send < interval)
+                continue;
+
+            // only existing connections are kept, a lost connection is not re-established here
+            if (_manager->isConnected (it->first) == false)
+                continue;
+
+            std::map<id_t, VASTBuffer *>::iterator buf = _sendbuf_TCP.find (it->first);
+            if (buf == _sendbuf_TCP.end ())
+                buf = _sendbuf_TCP.insert (std::pair<id_t, VASTBuffer *> (it->first, new VASTBuffer ())).first;
+
+            // a message already pending serves as a heartbeat
+            if (buf->second->size == 0)
+                buf->second->add ((char *)&header, sizeof (VASTHeader));
+        }
+    }
+
     // record which other IDs belong to the same host
     void 
     VASTnet::recordLocalTarget (id_t target)
@@ -847,7 +1080,36 @@ namespace Vast
     // returns NET_ID_UNASSIGNED for serious error
     bool
     VASTnet::processVASTMessage (VASTHeader &header, const char *p, id_t remote_id)
-    {
+    {
+        // any regular message shows the remote host is alive, heartbeats carry no message
+        // NOTE: IDs may still be switched during ID request / handshake, so they're not recorded
+        if (header.type == REGULAR)
+        {
+            _liveness[remote_id].last_recv = getTimestamp ();
+            if (header.msg_size == 0)
+                return true;
+
+            // remote host is closing an idle connection to stay within its connection limit,
+            // so the disconnection that follows is not reported
+            if (header.msg_size == sizeof (uint32_t))
+            {
+                uint32_t marker;
+                memcpy (&marker, p, sizeof (uint32_t));
+
+                if (marker == VASTNET_CLOSE_MARKER)
+                {
+#ifdef DEBUG_DETAIL
+                    printf ("VASTnet::processVASTMessage () [%llu] is closing its idle connection\n", remote_id);
+#endif
+                    _closing.insert (remote_id);
+                }
+                else
+                    printf ("VASTnet::processVASTMessage () unrecognized marker %x from [%llu]\n", marker, remote_id);
+
+                return true;
+            }
+        }
+
         // convert byte string to Message object here
         Message *msg = new Message (0);
         
@@ -914,6 +1176,19 @@ namespace Vast
         case REGULAR:
             // TODO: check with net_manager for successful handshake first
             {
+#ifdef VASTNET_RECORD_LATENCY
+                // send time is found at the end of the message
+                // NOTE: only comparable with our clock if the sender is on the same machine or emulated
+                if (header.msg_size >= sizeof (timestamp_t) && isSameClock (remote_id))
+                {
+                    timestamp_t sendtime;
+                    memcpy (&sendtime, p + header.msg_size - sizeof (timestamp_t), sizeof (timestamp_t));
+
+                    timestamp_t now = getTimestamp ();
+                    if (now >= sendtime)
+                        _type2stat[msg->msgtype].latency.record (now - sendtime);
+                }
+#endif
                 // return first so Message object would not be de-allocated, unless store was unsuccessful        
                 storeVASTMessage (remote_id, msg);
 
@@ -1103,6 +1378,10 @@ namespace Vast
             _sendbuf_UDP.erase (target);
             removed = true;
         }
+
+        _liveness.erase (target);
+        _connecting.erase (target);
+        _peer2stat.erase (target);
         
         // TODO: at some point should clean up id2host mappings
 
@@ -1152,6 +1431,160 @@ namespace Vast
             printf ("\n");
 #endif
         }
+
+        // forget failed connection attempts that are no longer delaying a retry
+        std::map<id_t, timestamp_t>::iterator retry = _connect_retry.begin ();
+        while (retry != _connect_retry.end ())
+        {
+            if (now >= retry->second)
+                _connect_retry.erase (retry++);
+            else
+                retry++;
+        }
+
+        // close idle connections beyond the limit (incoming connections are not checked when accepted)
+        // NOTE: a closed connection may only be removed later by the network thread, so the excess is counted once
+        if (_conn_limit > 0)
+        {
+            size_t count = countConnections ();
+            for (; count > _conn_limit; count--)
+            {
+                if (evictConnection (now) == false)
+                    break;
+            }
+        }
+    }
+
+    // check outgoing connections being established, remove those failed or timed out
+    void 
+    VASTnet::checkConnecting (timestamp_t now)
+    {
+        timestamp_t timeout = TIMEOUT_CONNECT * _manager->getTimestampPerSecond ();
+
+        std::vector<id_t> connected;
+        std::vector<id_t> failed;
+
+        std::map<id_t, timestamp_t>::iterator it = _connecting.begin ();
+        for (; it != _connecting.end (); it++)
+        {
+            int result = (-1);
+
+            std::map<id_t, Addr>::iterator addr = _id2addr.find (it->first);
+            if (addr != _id2addr.end ())
+                result = _manager->connectAsync (it->first, addr->second.publicIP.host, addr->second.publicIP.port);
+
+            if (result == 1)
+                connected.push_back (it->first);
+            else if (result == (-1) || now - it->second >= timeout)
+                failed.push_back (it->first);
+        }
+
+        size_t i;
+        for (i=0; i < connected.size (); i++)
+            _connecting.erase (connected[i]);
+
+        // messages queued for a failed host are dropped, as they would be if the connection failed right away
+        for (i=0; i < failed.size (); i++)
+        {
+            printf ("VASTnet::checkConnecting () connection to [%llu] failed\n", failed[i]);
+
+            removeConnection (failed[i]);
+            _connect_retry[failed[i]] = now + (TIMEOUT_CONNECT_RETRY * _manager->getTimestampPerSecond ());
+        }
+    }
+
+    // close the least recently used idle connection to make room for a new one
+    // hosts kept alive or with messages pending are not closed
+    bool 
+    VASTnet::evictConnection (timestamp_t now)
+    {
+        id_t        victim = NET_ID_UNASSIGNED;
+        timestamp_t oldest = 0;
+
+        // both connections made & accepted are considered
+        std::vector<id_t> ids;
+        _manager->getConnectionIDs (ids);
+
+        for (size_t i=0; i < ids.size (); i++)
+        {
+            id_t id = ids[i];
+
+            // skip connections already being closed or made
+            if (_closing.find (id) != _closing.end () || _connecting.find (id) != _connecting.end ())
+                continue;
+
+            std::map<id_t, VASTBuffer *>::iterator buf = _sendbuf_TCP.find (id);
+            if (buf != _sendbuf_TCP.end () && buf->second->size > 0)
+                continue;
+
+            // NOTE: connections that do not record time (such as socket-only) are not closed
+            timestamp_t lasttime = _manager->getLastTime (id);
+            if (lasttime == 0)
+                continue;
+
+            std::map<id_t, PeerLiveness>::iterator peer = _liveness.find (id);
+            if (peer != _liveness.end () && peer->second.keep_until >= now)
+                continue;
+
+            if (victim == NET_ID_UNASSIGNED || lasttime < oldest)
+            {
+                victim = id;
+                oldest = lasttime;
+            }
+        }
+
+        if (victim == NET_ID_UNASSIGNED)
+            return false;
+
+#ifdef DEBUG_DETAIL
+        printf ("VASTnet::evictConnection () closing idle connection to [%llu]\n", victim);
+#endif
+
+        // notify the remote host first, so neither end reports a DISCONNECT to the handlers
+        // NOTE: the notice is sent right away, as the connection is closed before the next flush ()
+        char notice[sizeof (VASTHeader) + sizeof (uint32_t)];
+
+        VASTHeader header;
+        header.start    = 10;
+        header.end      = 5;
+        header.type     = REGULAR;
+        header.msg_size = sizeof (uint32_t);
+
+        memcpy (notice, &header, sizeof (VASTHeader));
+        memcpy (notice + sizeof (VASTHeader), &VASTNET_CLOSE_MARKER, sizeof (uint32_t));
+
+        _manager->send (victim, notice, sizeof (notice));
+
+        // NOTE: the disconnection may be reported during disconnect () (emulated network), so record it first
+        _closing.insert (victim);
+        if (_manager->disconnect (victim) == false)
+            _closing.erase (victim);
+
+        // NOTE: liveness & UDP queue are kept, the connection is re-established when next used
+        std::map<id_t, VASTBuffer *>::iterator buf = _sendbuf_TCP.find (victim);
+        if (buf != _sendbuf_TCP.end ())
+        {
+            delete buf->second;
+            _sendbuf_TCP.erase (buf);
+        }
+
+        return true;
+    }
+
+    // # of connections counted towards the limit (including those being made, excluding those being closed)
+    size_t 
+    VASTnet::countConnections ()
+    {
+        size_t count = _manager->getConnectionSize () + _connecting.size ();
+
+        std::set<id_t>::iterator it = _closing.begin ();
+        for (; it != _closing.end () && count > 0; it++)
+        {
+            if (_manager->isConnected (*it))
+                count--;
+        }
+
+        return count;
     }
 
     // update send/recv size statistics
@@ -1171,6 +1604,12 @@ namespace Vast
             if (_type2sendsize.find (msgtype) == _type2sendsize.end ())
                 _type2sendsize [msgtype] = 0;
             _type2sendsize[msgtype] += size;
+
+            _type2stat[msgtype].send_size.record (size);
+
+            PeerStat &peer = _peer2stat[target];
+            peer.send_size += size;
+            peer.send_count++;
         }
         
         // record receive stat
@@ -1181,9 +1620,26 @@ namespace Vast
             if (_type2recvsize.find (msgtype) == _type2recvsize.end ())
                 _type2recvsize [msgtype] = 0;
             _type2recvsize[msgtype] += size;
+
+            _type2stat[msgtype].recv_size.record (size);
+
+            PeerStat &peer = _peer2stat[target];
+            peer.recv_size += size;
+            peer.recv_count++;
         }
     }
 
+    // whether a remote host's timestamps can be compared with ours (emulated, or on the same machine)
+    bool 
+    VASTnet::isSameClock (id_t host)
+    {
+        if (_model == VAST_NET_EMULATED)
+            return true;
+
+        std::map<id_t, Addr>::iterator it = _id2addr.find (host);
+        return (it != _id2addr.end () && it->second.publicIP.host == _manager->getAddress ().publicIP.host);
+    }
+
     // obtain the port portion of the ID
     id_t 
     VASTnet::resolvePort (id_t host_id)
@@ -25,11 +25,14 @@
 namespace Vast {
 
     // constructor
-    net_ace::net_ace (uint16_t port)
+    net_ace::net_ace (uint16_t port, net_ace_reactor *shared)
         :_port_self (port), 
          _up_cond (NULL), 
          _down_cond (NULL), 
-         _acceptor (NULL)
+         _reactor (NULL),
+         _shared (shared),
+         _acceptor (NULL),
+         _msg_cond (_msg_mutex)
     {
         // necessary when using ACE within WinMain to avoid crash 
         ACE::init ();
@@ -148,40 +151,9 @@ namespace Vast {
     {        
         // NEW_THREAD net_ace runs as ACE_TASK
         _reactor = new ACE_Reactor;                
-        _acceptor = new net_ace_acceptor (this);
-        
-        ACE_INET_Addr addr (_port_self, getIPFromHost ());
-       
-        printf ("net_ace::svc () default port: %d\n", _port_self);
-
-        // obtain a valid server TCP listen port        
-        while (true) 
-        {
-            // NEW_THREAD (ACE_DEBUG called for 1st time?)
-            ACE_DEBUG ((LM_DEBUG, "(%5t) attempting to start server at %s:%d\n", addr.get_host_addr (), addr.get_port_number ()));
 
-            if (_acceptor->open (addr, _reactor) == 0)
-                break;
-            
-            _port_self++;
-            addr.set_port_number (_port_self);
-        }        
-                
-        ACE_DEBUG ((LM_DEBUG, "net_ace::svc () called. actual port binded: %d\n", _port_self));
-                
-        // create new handler for listening to UDP packets        
-        // NEW_THREAD will be created (new handler that will listen to port?)
-        ACE_NEW_RETURN (_udphandler, net_ace_handler, -1);
-        _udp = _udphandler->openUDP (addr);
-        _udphandler->open (_reactor, this);
-
-        // NOTE: this is a private IP, publicIP is obtained from server
-        // register my own address        
-        _self_addr.setPublic ((uint32_t)addr.get_ip_address (), 
-                              (uint16_t)addr.get_port_number ());
-
-        // self-determine preliminary hostID first
-        _self_addr.host_id = this->resolveHostID (&_self_addr.publicIP);
+        if (openSockets () == false)
+            return -1;
          
         // wait a bit to avoid signalling before the main thread tries to wait
         ACE_Time_Value sleep_interval (0, 200000);
@@ -225,6 +197,49 @@ namespace Vast {
     }    
 
 
+    // open the TCP listen port & UDP socket with the current reactor
+    bool
+    net_ace::
+    openSockets ()
+    {
+        _acceptor = new net_ace_acceptor (this);
+        
+        ACE_INET_Addr addr (_port_self, getIPFromHost ());
+       
+        printf ("net_ace::openSockets () default port: %d\n", _port_self);
+
+        // obtain a valid server TCP listen port        
+        while (true) 
+        {
+            // NEW_THREAD (ACE_DEBUG called for 1st time?)
+            ACE_DEBUG ((LM_DEBUG, "(%5t) attempting to start server at %s:%d\n", addr.get_host_addr (), addr.get_port_number ()));
+
+            if (_acceptor->open (addr, _reactor) == 0)
+                break;
+            
+            _port_self++;
+            addr.set_port_number (_port_self);
+        }        
+                
+        ACE_DEBUG ((LM_DEBUG, "net_ace::openSockets () actual port binded: %d\n", _port_self));
+                
+        // create new handler for listening to UDP packets        
+        // NEW_THREAD will be created (new handler that will listen to port?)
+        ACE_NEW_RETURN (_udphandler, net_ace_handler, false);
+        _udp = _udphandler->openUDP (addr);
+        _udphandler->open (_reactor, this);
+
+        // NOTE: this is a private IP, publicIP is obtained from server
+        // register my own address        
+        _self_addr.setPublic ((uint32_t)addr.get_ip_address (), 
+                              (uint16_t)addr.get_port_number ());
+
+        // self-determine preliminary hostID first
+        _self_addr.host_id = this->resolveHostID (&_self_addr.publicIP);
+
+        return true;
+    }
+
     //
     // inherent methods from 'net_manager'
     //
@@ -234,6 +249,15 @@ namespace Vast {
     {               
         net_manager::start ();
 
+        // with a shared reactor, only register our sockets with it
+        if (_shared != NULL)
+        {
+            _reactor = _shared->getReactor ();
+            if (_reactor != NULL && openSockets ())
+                _active = true;
+            return;
+        }
+
         // open the listening thread, _active will be true after calling
         this->open (0);
     }
@@ -243,6 +267,28 @@ namespace Vast {
     {                
         net_manager::stop ();
 
+        cancelConnects ();
+
+        // with a shared reactor, unregister our sockets but leave the reactor running
+        if (_shared != NULL)
+        {
+            if (_active == false)
+                return;
+
+            _active = false;
+
+            // NOTE: both handlers delete themselves once closed
+            _reactor->remove_handler (_acceptor, ACE_Event_Handler::ACCEPT_MASK);
+            _acceptor = NULL;
+
+            _udphandler->close ();
+            _udphandler = NULL;
+            _udp = NULL;
+
+            _reactor = NULL;
+            return;
+        }
+
         // close the listening thread, _active will set to false after calling
         this->close (0);
     }
@@ -326,6 +372,29 @@ namespace Vast {
         return result;
     }
 
+    // get # of active connections
+    // NOTE: connections are added & removed by the reactor thread, so mutex is needed
+    size_t 
+    net_ace::getConnectionSize ()
+    {
+        _conn_mutex.acquire ();
+        size_t size = _id2conn.size ();
+        _conn_mutex.release ();
+
+        return size;
+    }
+
+    // get IDs of all active connections (both made & accepted)
+    size_t 
+    net_ace::getConnectionIDs (std::vector<id_t> &ids)
+    {
+        _conn_mutex.acquire ();
+        size_t size = net_manager::getConnectionIDs (ids);
+        _conn_mutex.release ();
+
+        return size;
+    }
+
     bool
     net_ace::
     connect (id_t target, unsigned int host, unsigned short port, bool is_secure)
@@ -396,10 +465,103 @@ namespace Vast {
         return true;
     }
 
+    // start a non-blocking connection to a remote node, or check the one already started
+    // returns 1 if connected, 0 if still connecting, (-1) if failed
+    int
+    net_ace::
+    connectAsync (id_t target, unsigned int host, unsigned short port)
+    {
+        if (_active == false)
+            return (-1);
+
+        // we're always connected to self
+        if (target == _id || isConnected (target))
+            return 1;
+
+        ACE_INET_Addr target_addr (port, (ACE_UINT32)host);
+        net_ace_handler *handler;
+
+        std::map<id_t, net_ace_handler *>::iterator it = _connecting.find (target);
+
+        if (it == _connecting.end ())
+        {
+            ACE_NEW_RETURN (handler, net_ace_handler, (-1));
+
+            // NOTE: with a zero timeout, connect () returns right away and fails with EWOULDBLOCK 
+            //       if the connection is still in progress
+            if (_connector.connect (*handler, target_addr, &ACE_Time_Value::zero) == -1)
+            {
+                if (errno != EWOULDBLOCK)
+                {
+                    handler->close ();
+                    ACE_ERROR_RETURN ((LM_ERROR, "connect to %s:%u failed\n", target_addr.get_host_addr (), target_addr.get_port_number ()), (-1));
+                }
+
+                _connecting[target] = handler;
+                return 0;
+            }
+        }
+        else
+        {
+            handler = it->second;
+            ACE_SOCK_Stream &stream = *handler;
+
+            // NOTE: the connector's complete () is not used, as it closes the stream if not yet connected
+            if (ACE::handle_timed_complete (stream.get_handle (), &ACE_Time_Value::zero) == ACE_INVALID_HANDLE)
+            {
+                if (errno == ETIME)
+                    return 0;
+
+                _connecting.erase (it);
+                handler->close ();
+                ACE_ERROR_RETURN ((LM_ERROR, "connect to %s:%u failed\n", target_addr.get_host_addr (), target_addr.get_port_number ()), (-1));
+            }
+
+            _connecting.erase (it);
+
+            // connected sockets are used in blocking mode
+            stream.disable (ACE_NONBLOCK);
+        }
+
+        // open the handler object, this will 
+        // 1) register handler with reactor 2) cause socket_connected () be called
+        if (handler->open (_reactor, this, target) == -1)
+        {
+            handler->close ();
+            return (-1);
+        }
+
+        ACE_DEBUG ((LM_DEBUG, "(%5t) connectAsync(): connected to (%s:%d)\n", target_addr.get_host_addr (), target_addr.get_port_number ()));
+
+        return 1;
+    }
+
+    // close connections that are still being established
+    void
+    net_ace::
+    cancelConnects ()
+    {
+        // NOTE: the handlers are not yet opened, so they simply close the stream & delete themselves
+        std::map<id_t, net_ace_handler *>::iterator it = _connecting.begin ();
+        for (; it != _connecting.end (); it++)
+            it->second->close ();
+
+        _connecting.clear ();
+    }
+
     bool
     net_ace::
     disconnect (id_t target)
     {
+        // a connection not yet established is simply dropped
+        std::map<id_t, net_ace_handler *>::iterator pending = _connecting.find (target);
+        if (pending != _connecting.end ())
+        {
+            pending->second->close ();
+            _connecting.erase (pending);
+            return true;
+        }
+
         // we need to use mutex to access the handler object, because it's
         // possible that remote disconnection occurs at the same time when disconnect () 
         // is called. Then, it'll be possible the id2conn object is already gone,
@@ -512,6 +674,26 @@ namespace Vast {
         return _recvmsg;
     }
     
+    // wait until a message is received or 'timeout' (in microseconds) passes
+    int
+    net_ace::
+    waitInput (int timeout)
+    {
+        if (_active == false)
+            return (-1);
+
+        // NOTE: the condition takes an absolute time
+        ACE_Time_Value abstime = ACE_OS::gettimeofday () + ACE_Time_Value (0, timeout);
+
+        _msg_mutex.acquire ();
+        if (_recv_queue.size () == 0)
+            _msg_cond.wait (&abstime);
+        bool received = (_recv_queue.size () > 0);
+        _msg_mutex.release ();
+
+        return (received ? 1 : 0);
+    }
+
     // change the ID for a remote host
     bool 
     net_ace::switchID (id_t prevID, id_t newID)
@@ -575,6 +757,7 @@ namespace Vast {
             _recv_queue.insert (_recv_queue.begin (), newmsg);
         else
             _recv_queue.push_back (newmsg);
+        _msg_cond.signal ();
         _msg_mutex.release ();
 
         // update last accessed time of the connection
@@ -55,6 +55,7 @@
 
 #include "VASTnet.h"
 #include "net_ace_acceptor.h"
+#include "net_ace_reactor.h"
 
 #ifdef VAST_USE_SSL
 #include "ace/SSL/SSL_SOCK_Connector.h" // ACE_SSL_SOCK_Connector
@@ -74,7 +75,8 @@ namespace Vast {
 
     public:
         
-        net_ace (uint16_t port);
+        // if 'shared' is given, sockets are handled by the shared reactor instead of a thread of our own
+        net_ace (uint16_t port, net_ace_reactor *shared = NULL);
         ~net_ace ();
 
         //
@@ -110,6 +112,15 @@ namespace Vast {
         bool connect (id_t target, unsigned int host, unsigned short port, bool is_secure = false);
         bool disconnect (id_t target);      
 
+        // start a non-blocking connection to a remote node, or check the one already started
+        int connectAsync (id_t target, unsigned int host, unsigned short port);
+
+        // get # of active connections
+        size_t getConnectionSize ();
+
+        // get IDs of all active connections (both made & accepted)
+        size_t getConnectionIDs (std::vector<id_t> &ids);
+
         // send an outgoing message to a remote host, if addr is specified, message is UDP
         // return the number of bytes sent
         size_t send (id_t target, char const *msg, size_t size, const Addr *addr = NULL);
@@ -124,6 +135,9 @@ namespace Vast {
         // perform a tick of the logical clock 
         void tickLogicalClock () {}
 
+        // wait until a message is received or 'timeout' (in microseconds) passes
+        int waitInput (int timeout);
+
         // store a message into priority queue
         // returns success or not
         bool msg_received (id_t fromhost, const char *message, size_t size, timestamp_t recvtime = 0, bool in_front = false);
@@ -134,6 +148,12 @@ namespace Vast {
 
     private:
 
+        // open the TCP listen port & UDP socket with the current reactor
+        bool openSockets ();
+
+        // close connections that are still being established
+        void cancelConnects ();
+
         // bind port for this node
         uint16_t              _port_self;
 
@@ -145,6 +165,9 @@ namespace Vast {
         // ACE reactor for handling both accept and incoming message events
         ACE_Reactor                *_reactor;
 
+        // reactor shared with other nodes, if any (we don't own it)
+        net_ace_reactor            *_shared;
+
         // acceptor for listen for incoming connections
         net_ace_acceptor           *_acceptor;
 
@@ -154,12 +177,16 @@ namespace Vast {
         ACE_SSL_SOCK_Connector      _SSL_connector;
 #endif
 
+        // handlers of connections still being established (accessed by the main thread only)
+        std::map<id_t, net_ace_handler *> _connecting;
+
         // UDP datagram wrapper
         ACE_SOCK_Dgram              *_udp;
         net_ace_handler             *_udphandler;
 
         // for critical section access control 
         ACE_Thread_Mutex            _msg_mutex;
+        ACE_Condition<ACE_Thread_Mutex> _msg_cond;      // signalled when a message is received
         ACE_Thread_Mutex            _conn_mutex;        // connection mutex
 
         // hostname & IP of current host
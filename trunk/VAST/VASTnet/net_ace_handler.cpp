@@ -265,11 +265,13 @@ namespace Vast {
             _reactor->remove_handler (this, mask | ACE_Event_Handler::DONT_CALL);
      
         // IMPORTANT: close the socket so port can be released for re-use
+        if (_udp != NULL)
+            _udp->close ();
 #ifdef VAST_USE_SSL
-        if (_secure)
+        else if (_secure)
             _ssl_stream.close ();
-        else
 #endif
+        else
             _stream.close ();
      
         ACE_DEBUG ((LM_DEBUG, "(%5t) handle_close (): [%d]\n", _remote_id));
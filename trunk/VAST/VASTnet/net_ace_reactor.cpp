@@ -0,0 +1,115 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "net_ace_reactor.h"
+
+// with many nodes per process the number of sockets may exceed what select () handles
+#if defined (ACE_HAS_EVENT_POLL) || defined (ACE_HAS_DEV_POLL)
+#include "ace/Dev_Poll_Reactor.h"
+#endif
+
+namespace Vast {
+
+    net_ace_reactor::net_ace_reactor ()
+        :_active (false),
+         _reactor (NULL)
+    {
+        ACE::init ();
+    }
+
+    net_ace_reactor::~net_ace_reactor ()
+    {
+        stop ();
+        ACE::fini ();
+    }
+
+    // service initialization method
+    int
+    net_ace_reactor::
+    open (void *p)
+    {
+        if (_active == true)
+            return 0;
+
+        // create the reactor here so nodes can register with it right away
+#if defined (ACE_HAS_EVENT_POLL) || defined (ACE_HAS_DEV_POLL)
+        _reactor = new ACE_Reactor (new ACE_Dev_Poll_Reactor (ACE::max_handles ()), 1);
+#else
+        _reactor = new ACE_Reactor;
+#endif
+
+        _active = true;
+        if (this->activate () == -1)
+        {
+            _active = false;
+            delete _reactor;
+            _reactor = NULL;
+            return -1;
+        }
+
+        return 0;
+    }
+
+    // service termination method
+    int
+    net_ace_reactor::
+    close (u_long i)
+    {
+        // nothing to do, stop () ends the thread
+        return 0;
+    }
+
+    // service method
+    int
+    net_ace_reactor::
+    svc (void)
+    {
+        // NEW_THREAD the only thread handling socket events for all nodes sharing this reactor
+        _reactor->owner (ACE_Thread::self ());
+
+        printf ("net_ace_reactor::svc () entering event handling loop\n");
+
+        while (_active)
+            _reactor->handle_events ();
+
+        printf ("net_ace_reactor::svc () leaving event handling loop\n");
+
+        return 0;
+    }
+
+    // stop the event handling thread & release the reactor
+    void
+    net_ace_reactor::stop ()
+    {
+        if (_active == false)
+            return;
+
+        // allow the reactor to leave its event handling loop & wait for the thread to end
+        _active = false;
+        _reactor->end_reactor_event_loop ();
+        this->wait ();
+
+        // any remaining handlers will be closed by the reactor
+        _reactor->close ();
+        delete _reactor;
+        _reactor = NULL;
+    }
+
+} // end namespace Vast
@@ -0,0 +1,76 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * net_ace_reactor.h -- an ACE reactor & its event handling thread shared by many net_ace
+ *
+ *      normally each net_ace runs its own reactor in its own thread, when many VAST
+ *      nodes are hosted in one process (see VASTHost), the sockets of all nodes
+ *      are handled by one reactor & one thread instead.
+ */
+
+#ifndef VAST_NET_ACE_REACTOR_H
+#define VAST_NET_ACE_REACTOR_H
+
+#include "ace/ACE.h"
+#include "ace/Task.h"
+#include "ace/Reactor.h"
+
+namespace Vast {
+
+class net_ace_reactor : public ACE_Task<ACE_MT_SYNCH>
+{
+public:
+
+    net_ace_reactor ();
+    ~net_ace_reactor ();
+
+    //
+    //  Standard ACE_Task methods (must implement)
+    //
+
+    // service initialization method, the reactor can be used after this returns
+    int open (void *);
+
+    // service termination method (also called by ACE when svc () returns)
+    int close (u_long);
+
+    // service method
+    int svc (void);
+
+    // stop the event handling thread & release the reactor,
+    // all net_ace using the reactor should have been stopped
+    void stop ();
+
+    // the shared reactor, NULL if not opened
+    ACE_Reactor *getReactor ()
+    {
+        return _reactor;
+    }
+
+private:
+
+    bool            _active;        // whether the event handling thread should run
+    ACE_Reactor    *_reactor;
+};
+
+} // end namespace Vast
+
+#endif // VAST_NET_ACE_REACTOR_H
@@ -31,7 +31,7 @@ namespace Vast
     static net_emubridge *g_bridge     = NULL;
     int                   g_bridge_ref = 0;            // reference count for the bridge
 
-    net_emu::net_emu (timestamp_t sec2timestamp)
+    net_emu::net_emu (timestamp_t sec2timestamp, VASTPara_Sim *simpara)
     {
         // initialize rand generator (for node fail simulation, NOTE: same seed is used to produce exactly same results)
         //srand ((unsigned int)time (NULL));
@@ -42,8 +42,10 @@ namespace Vast
         {
             // create a shared net-bridge (used in simulation to locate other simulated nodes)
             // NOTE: g_bridge may be shared across different VASTVerse instances            
-            //g_bridge = new net_emubridge (_simpara.loss_rate, _simpara.fail_rate, 1, _simpara.step_persec, 1);
-            g_bridge = new net_emubridge (0, 0, 1, (size_t)sec2timestamp, 1);
+            if (simpara != NULL)
+                g_bridge = new net_emubridge (simpara->loss_rate, simpara->fail_rate, simpara->seed, (size_t)sec2timestamp, 1, simpara->with_latency, simpara->latency_file);
+            else
+                g_bridge = new net_emubridge (0, 0, 1, (size_t)sec2timestamp, 1);
         }
 
         g_bridge_ref++;
@@ -63,6 +65,11 @@ namespace Vast
         // make sure the bridge stores proper unique ID
         g_bridge->replaceHostID (id, _self_addr.host_id);
 
+        // link capacities of this host, if not default
+        if (simpara != NULL && (simpara->uplink > 0 || simpara->downlink > 0))
+            g_bridge->setLinkCapacity (_self_addr.host_id, (simpara->uplink > 0 ? simpara->uplink : EMU_DEFAULT_UPLINK),
+                                                           (simpara->downlink > 0 ? simpara->downlink : EMU_DEFAULT_DOWNLINK));
+
         // set the conversion rate between seconds and timestamp unit
         // for net_emu it's the same as tick_persec
         _sec2timestamp = sec2timestamp;
@@ -187,7 +194,9 @@ namespace Vast
             return false;
 
         this->socket_disconnected (target);
-        receiver->remoteDisconnect (_id);  
+
+        // the remote host notices the disconnection only after messages already sent to it arrive (as in TCP)
+        receiver->remoteDisconnect (_id, g_bridge->getArrivalTime (_id, target, 0, true));  
 
         return true;
     }
@@ -416,10 +425,17 @@ namespace Vast
     // remote host has disconnected me
     void 
     net_emu::
-    remoteDisconnect (Vast::id_t remote_id)
+    remoteDisconnect (Vast::id_t remote_id, timestamp_t recvtime)
     {
+        // cut connection
+        map<id_t, ConnectInfo>::iterator it = _id2conn.find (remote_id); 
+        if (it == _id2conn.end ())
+            return;
+
+        _id2conn.erase (it);
+
         // NOTE: this will cause a DISCONNECT message be stored in local message queue
-        this->socket_disconnected (remote_id);
+        this->msg_received (remote_id, NULL, 0, recvtime);
 
         // send a DISCONNECT notification
         //Message *msg = new Message (DISCONNECT);
@@ -41,7 +41,8 @@ namespace Vast {
     class net_emu : public Vast::net_manager
     {
     public:
-        net_emu (timestamp_t sec2timestamp);
+        // 'simpara' configures the shared bridge (if not yet created) & link capacities of this host, optional
+        net_emu (timestamp_t sec2timestamp, VASTPara_Sim *simpara = NULL);
 
         ~net_emu ();
         
@@ -101,7 +102,8 @@ namespace Vast {
         // emulator-specific methods
         //               
         virtual bool remoteConnect (id_t remote_id, Addr const &addr);
-        virtual void remoteDisconnect (id_t remote_id);
+        // 'recvtime' is when the disconnection is noticed (after earlier messages from the remote host arrive)
+        virtual void remoteDisconnect (id_t remote_id, timestamp_t recvtime = 0);
 
     protected:
 
@@ -309,9 +309,9 @@ namespace Vast
     // remote host has disconnected me
     void 
     net_emu_bl::
-    remoteDisconnect (id_t remote_id)
+    remoteDisconnect (id_t remote_id, timestamp_t recvtime)
     {		
-        net_emu::remoteDisconnect (remote_id);
+        net_emu::remoteDisconnect (remote_id, recvtime);
 
         // clear up sendqueue
         std::map<id_t, netmsg *>::iterator it;
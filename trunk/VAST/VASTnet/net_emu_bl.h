@@ -108,7 +108,7 @@ namespace Vast {
         // emulator-specific methods
         //
 
-        void remoteDisconnect (Vast::id_t remote_id);
+        void remoteDisconnect (Vast::id_t remote_id, timestamp_t recvtime = 0);
 
     protected:
 
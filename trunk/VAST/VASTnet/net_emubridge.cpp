@@ -19,27 +19,11 @@
  */
 
 #include "net_emubridge.h"
-//#include <cmath.h>
-#define  SEC_PER_STEP (100)
+#include <stdio.h>
 
 namespace Vast
 {	
 
-	int round (float F)
-	{   
-		bool minus = (F < 0.0 ? true : false);  
-		
-        if (minus)   
-            F*=-1;  
-		int a = (int)F;  
-		int b = (int)((F-(float)a)*10);  
-		if (b >= 5)   
-            ++a;  
-		if (minus)   
-            a*=-1;  
-		return a;  
-	}   
-
     id_t 
     net_emubridge::
     obtain_id (void *pointer)
@@ -48,6 +32,17 @@ namespace Vast
         
         id_t new_id = _id_count++;
         _id2ptr[new_id] = pointer;
+
+        // create link state, random coordinate is drawn in creation order to be repeatable
+        EmuHost host;
+        host.index      = _host_count++;
+        host.coord.x    = (coord_t)(_random.nextDouble () * EMU_COORD_RANGE);
+        host.coord.y    = (coord_t)(_random.nextDouble () * EMU_COORD_RANGE);
+        host.uplink     = EMU_DEFAULT_UPLINK;
+        host.downlink   = EMU_DEFAULT_DOWNLINK;
+        host.up_free    = 0;
+        host.down_free  = 0;
+        _hosts[new_id] = host;
             
         return new_id;
     }
@@ -70,6 +65,12 @@ namespace Vast
         if (id != temp_id)
 		{
             _id2ptr.erase (temp_id);
+
+            if (_hosts.find (temp_id) != _hosts.end ())
+            {
+                _hosts[id] = _hosts[temp_id];
+                _hosts.erase (temp_id);
+            }
 		}
     }
     
@@ -82,6 +83,18 @@ namespace Vast
 		{         
 			_id2ptr.erase (id);
 		}
+
+        _hosts.erase (id);
+
+        // remove ordering records with the host
+        std::map<std::pair<id_t, id_t>, timestamp_t>::iterator it = _last_arrival.begin ();
+        while (it != _last_arrival.end ())
+        {
+            if (it->first.first == id || it->first.second == id)
+                _last_arrival.erase (it++);
+            else
+                it++;
+        }
     }
            
     // obtain the arrived timestamp of a packet, subject to packet loss or latency
@@ -90,56 +103,155 @@ namespace Vast
     net_emubridge::
     getArrivalTime (id_t sender, id_t receiver, size_t length, bool reliable)
     {                   
-        sender = 0;
-        receiver = 0;
-        length = 0;
-        reliable = true;
-
-        timestamp_t time;
-
-#ifdef ENABLE_LATENCY
-		if (_vivaldi != NULL)
-		{//calculate the receiving time
-			float latency_time = _vivaldi->get_latency (sender, receiver);			
-			//time = getTimestamp () + (timestamp_t)ceil((latency_time/SEC_PER_STEP));
-			float d_time = (latency_time/SEC_PER_STEP);
-			int r = round (d_time);
-
-			time = getTimestamp() + (timestamp_t)r;
-		}
-		else
-		{
-			// delay 1 step by default
-			time = getTimestamp () + 1;
-		}
-#else
-		// delay 1 step by default
-		time = getTimestamp () + 1;
-#endif
-		
-/*
-		
+        timestamp_t now = getTimestamp ();
+
         // TODO: consider fail_rate and block potential sends between sender & receivers
-        if (_loss_rate > 0)
-        {
-            srand (_last_seed);
-            _last_seed = rand ();
+        bool lost = (_loss_rate > 0 && _random.nextDouble () * 100 < _loss_rate);
 
-            int r = rand()%100;                                
-            if (r < _loss_rate)
+        // each message takes one step
+        if (_with_latency == false)
+        {
+            if (lost)
             {
-                //printf ("time: %d [%d] -> [%d] type: %d gets dropped at %d:%d\n", _curr_time, (int)from, (int)_id, msgtype, r, _loss_rate);
                 if (reliable == false)
-                    return (-1);                
+                    return (timestamp_t)(-1);
                 // for reliable delivery, we assume it'll arrive in the next time-stamp
-                // TODO: more realistic delay model?
-                else
-                    time++;                
+                return now + 2;
             }
+
+            return now + 1;
         }
-*/
 
-        return time;
+        double steps_per_ms = (double)_net_step_per_sec / 1000.0;
+        double latency      = getLatency (sender, receiver) * steps_per_ms;
+
+        // time (in steps) the message reaches a certain point
+        double time = (double)now;
+
+        // serialization at sender's uplink, after earlier messages are sent
+        std::map<id_t, EmuHost>::iterator it = _hosts.find (sender);
+        if (it != _hosts.end () && it->second.uplink > 0)
+        {
+            EmuHost &host = it->second;
+            host.up_free = (host.up_free > time ? host.up_free : time) + (double)length * _net_step_per_sec / host.uplink;
+            time = host.up_free;
+        }
+
+        if (lost)
+        {
+            //printf ("time: %d [%d] -> [%d] gets dropped\n", now, (int)sender, (int)receiver);
+            if (reliable == false)
+                return (timestamp_t)(-1);
+
+            // for reliable delivery, we assume it's re-transmitted after one round-trip
+            time += latency * 2;
+        }
+
+        // propagation with jitter
+        time += latency * (1 + EMU_JITTER_FRACTION * _random.nextDouble ());
+
+        // serialization at receiver's downlink
+        it = _hosts.find (receiver);
+        if (it != _hosts.end () && it->second.downlink > 0)
+        {
+            EmuHost &host = it->second;
+            host.down_free = (host.down_free > time ? host.down_free : time) + (double)length * _net_step_per_sec / host.downlink;
+            time = host.down_free;
+        }
+
+        // at least one step is needed for delivery
+        timestamp_t arrival = (timestamp_t)ceil (time);
+        if (arrival <= now)
+            arrival = now + 1;
+
+        // reliable messages between a pair arrive in order
+        if (reliable)
+        {
+            std::pair<id_t, id_t> link (sender, receiver);
+            std::map<std::pair<id_t, id_t>, timestamp_t>::iterator it_last = _last_arrival.find (link);
+
+            if (it_last == _last_arrival.end ())
+                _last_arrival[link] = arrival;
+            else
+            {
+                if (arrival < it_last->second)
+                    arrival = it_last->second;
+                it_last->second = arrival;
+            }
+        }
+
+        return arrival;
+    }
+
+    // load one-way latencies (ms) among hosts, hosts are mapped to rows by order of creation
+    // returns false if the file does not exist or is malformed
+    bool 
+    net_emubridge::
+    loadLatencyMatrix (const char *filename)
+    {
+        FILE *fp;
+        if ((fp = fopen (filename, "rt")) == NULL)
+            return false;
+
+        int n = 0;
+        bool success = (fscanf (fp, "%d", &n) == 1 && n > 0);
+
+        std::vector<std::vector<float> > latency (success ? n : 0, std::vector<float> (success ? n : 0, 0));
+
+        for (int i=0; success && i < n; i++)
+            for (int j=0; success && j < n; j++)
+                success = (fscanf (fp, "%f", &latency[i][j]) == 1);
+
+        fclose (fp);
+
+        if (success == false)
+        {
+            printf ("net_emubridge::loadLatencyMatrix () malformed latency file '%s'\n", filename);
+            return false;
+        }
+
+        _latency = latency;
+        return true;
+    }
+
+    // set the link capacities of a host (bytes / sec), 0 means unlimited
+    bool 
+    net_emubridge::
+    setLinkCapacity (id_t host, size_t uplink, size_t downlink)
+    {
+        std::map<id_t, EmuHost>::iterator it = _hosts.find (host);
+        if (it == _hosts.end ())
+            return false;
+
+        it->second.uplink   = uplink;
+        it->second.downlink = downlink;
+        return true;
+    }
+
+    // obtain the one-way latency between two hosts (ms)
+    float 
+    net_emubridge::
+    getLatency (id_t sender, id_t receiver)
+    {
+        std::map<id_t, EmuHost>::iterator it_src = _hosts.find (sender);
+        std::map<id_t, EmuHost>::iterator it_dst = _hosts.find (receiver);
+
+        bool known = (it_src != _hosts.end () && it_dst != _hosts.end ());
+
+        // loaded matrix has priority, hosts beyond its size wrap around
+        if (known && _latency.size () > 0)
+        {
+            size_t n = _latency.size ();
+            return _latency[it_src->second.index % n][it_dst->second.index % n];
+        }
+
+        if (_vivaldi != NULL)
+            return _vivaldi->get_latency (sender, receiver);
+
+        if (known)
+            return it_src->second.coord.distance (it_dst->second.coord);
+
+        return 0;
     }
 
     void *
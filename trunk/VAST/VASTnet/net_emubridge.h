@@ -22,29 +22,65 @@
 /*
  * net_emubridge.h -- a shared class between various net_emu classes
  *                    to discover pointers to other net_emu endpoints and delay to them
+ *
+ *      with the latency model on ('with_latency'), the arrival time of a message is determined by:
+ *          - one-way latency between sender & receiver (loaded matrix, Vivaldi, or random host coordinates)
+ *          - serialization delay at the sender's uplink & receiver's downlink (queued behind earlier messages)
+ *          - jitter, as a random fraction of the latency
+ *      unreliable messages may be lost, while lost reliable messages are delayed by a retransmission.
+ *      all random decisions are drawn from the bridge's own generator, so results are repeatable for a given seed
  */
 
 #ifndef VAST_NET_EMUBRIDGE_H
 #define VAST_NET_EMUBRIDGE_H
 
 #include "VASTTypes.h"
+#include "VASTUtil.h"       // RandomGenerator
 #include "Vivaldi.h"
 #include <map>
+#include <vector>
 #include <math.h>
+#include <stdio.h>
+
+#define EMU_COORD_RANGE         (150)           // hosts are placed randomly in a square of this size (ms) if no latency source exists
+#define EMU_JITTER_FRACTION     (0.1)           // max jitter as a fraction of one-way latency
+#define EMU_DEFAULT_UPLINK      (131072)        // default uplink capacity of a host (bytes / sec, 1 Mbps)
+#define EMU_DEFAULT_DOWNLINK    (524288)        // default downlink capacity of a host (bytes / sec, 4 Mbps)
+
 namespace Vast {
 
+    // link state of an emulated host
+    struct EmuHost
+    {
+        int         index;      // order of creation (row in latency matrix)
+        Position    coord;      // random coordinate (ms), used without other latency source
+        size_t      uplink;     // uplink capacity (bytes / sec), 0 for unlimited
+        size_t      downlink;   // downlink capacity (bytes / sec), 0 for unlimited
+        double      up_free;    // time (in steps) the uplink becomes idle
+        double      down_free;  // time (in steps) the downlink becomes idle
+    };
+
     class EXPORT net_emubridge 
     {
 
     public:
 
-		net_emubridge (int loss_rate, int fail_rate, int seed, size_t net_spsc, timestamp_t init_time)
-			:_loss_rate (loss_rate), _fail_rate (fail_rate), _time (init_time), _net_step_per_sec(net_spsc)
+        // 'with_latency' emulates latency, bandwidth & jitter (otherwise each message takes one step)
+        // 'latency_file' is an optional matrix of one-way latencies (ms): size N, followed by N x N values
+		net_emubridge (int loss_rate, int fail_rate, int seed, size_t net_spsc, timestamp_t init_time, bool with_latency = false, const char *latency_file = NULL)
+			:_loss_rate (loss_rate), _fail_rate (fail_rate), _time (init_time), _vivaldi (NULL), _net_step_per_sec(net_spsc), _with_latency (with_latency)
 		{
 			//srand (seed);
 			_last_seed = rand ();
 
+            // own random generator, so emulation does not affect (or depend on) other uses of rand ()
+            _random.setSeed ((uint32_t)seed * 2654435761u + 1);
+
             _id_count = 1;
+            _host_count = 0;
+
+            if (latency_file != NULL && loadLatencyMatrix (latency_file) == false)
+                printf ("net_emubridge::net_emubridge () cannot load latency file '%s', random host coordinates are used\n", latency_file);
 		}
 
         virtual ~net_emubridge ()
@@ -64,6 +100,16 @@ namespace Vast {
         // (-1) indicates a failed send
         timestamp_t getArrivalTime (id_t sender, id_t receiver, size_t length, bool reliable);
 
+        // load one-way latencies (ms) among hosts, hosts are mapped to rows by order of creation
+        // returns false if the file does not exist or is malformed
+        bool loadLatencyMatrix (const char *filename);
+
+        // set the link capacities of a host (bytes / sec), 0 means unlimited
+        bool setLinkCapacity (id_t host, size_t uplink, size_t downlink);
+
+        // obtain the one-way latency between two hosts (ms)
+        float getLatency (id_t sender, id_t receiver);
+
         virtual void tick(int tickvalue = 1);
         
         inline timestamp_t getTimestamp ()
@@ -86,6 +132,15 @@ namespace Vast {
 
 		Vivaldi*				_vivaldi;   // for latency		
 		size_t                  _net_step_per_sec;
+
+    private:
+
+        bool                            _with_latency;  // emulate latency, bandwidth & jitter
+        RandomGenerator                 _random;        // random generator of the emulation
+        int                             _host_count;    // # of hosts created so far
+        std::map<id_t, EmuHost>         _hosts;         // link states of hosts
+        std::vector<std::vector<float> > _latency;      // loaded latency matrix (ms)
+        std::map<std::pair<id_t, id_t>, timestamp_t> _last_arrival;    // last reliable arrival between a pair (to keep TCP-like ordering)
 	};
         
 } // end namespace Vast
@@ -74,6 +74,20 @@ namespace Vast
         return _active;
     }
 
+    // by default messages arrive only as the logical clock ticks, so there's nothing to wait for
+    int 
+    net_manager::waitInput (int timeout)
+    {
+        return (-1);
+    }
+
+    // by default a connection is completed right away
+    int 
+    net_manager::connectAsync (id_t target, unsigned int host, unsigned short port)
+    {
+        return (connect (target, host, port) ? 1 : (-1));
+    }
+
     // check if a certain host is connected
     bool 
     net_manager::isConnected (id_t target)
@@ -125,6 +139,26 @@ namespace Vast
             return 0;
     }
 
+    // get # of active connections
+    size_t 
+    net_manager::getConnectionSize ()
+    {
+        return _id2conn.size ();
+    }
+
+    // get IDs of all active connections (both made & accepted)
+    size_t 
+    net_manager::getConnectionIDs (std::vector<id_t> &ids)
+    {
+        ids.clear ();
+
+        std::map<id_t, ConnectInfo>::iterator it = _id2conn.begin ();
+        for (; it != _id2conn.end (); it++)
+            ids.push_back (it->first);
+
+        return ids.size ();
+    }
+
     // 
     // static methods (tools for external classes)
     //
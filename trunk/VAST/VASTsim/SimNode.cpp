@@ -53,6 +53,11 @@
         _simpara.fail_rate    = _para.FAIL_RATE;
         _simpara.loss_rate    = _para.LOSS_RATE;
         _simpara.step_persec  = _para.STEPS_PERSEC;
+        _simpara.with_latency = (_para.LATENCY_MODEL != 0);
+        _simpara.seed         = _para.NET_SEED;
+        _simpara.uplink       = (size_t)_para.UPLINK_CAPACITY;
+        _simpara.downlink     = (size_t)_para.DOWNLINK_CAPACITY;
+        _simpara.latency_file = (_para.LATENCY_MODEL != 0 ? VAST_LATENCYFILE : NULL);
                 
         // if not gateway, store some IPs to home
         if (id != 1)
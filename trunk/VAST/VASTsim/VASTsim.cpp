@@ -42,7 +42,6 @@ vector<bool>        g_as_relay;
 vector<bool>        g_as_matcher;
 MovementGenerator   g_move_model;
 char                g_GWstr[80];          // address to gateway node
-SectionedFile      *g_pos_record = NULL;
 
 //map<int, VAST *>    g_peermap;          // map from node index to the peer's relay id
 //map<int, Vast::id_t> g_peerid;           // map from node index to peer id
@@ -255,6 +254,10 @@ bool ReadPara (SimPara &para)
         &para.PEER_LIMIT,
         &para.RELAY_LIMIT,
         &para.OVERLOAD_LIMIT,
+        &para.LATENCY_MODEL,
+        &para.UPLINK_CAPACITY,
+        &para.DOWNLINK_CAPACITY,
+        &para.NET_SEED,
         0
     };
 
@@ -293,27 +296,18 @@ int InitSim (SimPara &para, VASTPara_Net &netpara)
     g_vastnetpara.recv_quota   = para.DOWNLOAD_LIMIT;
     g_vastnetpara.send_quota   = para.UPLOAD_LIMIT;
 
-    // create / open position log file
+    // map the movement trace, or create one if it does not exist
     char filename[80];
-    sprintf (filename, VAST_POSFILE_FORMAT, para.NODE_SIZE, para.WORLD_WIDTH, para.WORLD_HEIGHT, para.TIME_STEPS);
+    sprintf (filename, VAST_TRACEFILE_FORMAT, para.NODE_SIZE, para.WORLD_WIDTH, para.WORLD_HEIGHT, para.TIME_STEPS);
 
-    FileClassFactory fcf;
-    g_pos_record = fcf.CreateFileClass (0);
-    bool replay = true;
-    if (g_pos_record->open (filename, SFMode_Read) == false)
+    if (g_move_model.initModelFromTrace (g_para.MOVE_MODEL, filename,
+                                         Position (0,0), Position ((coord_t)g_para.WORLD_WIDTH, (coord_t)g_para.WORLD_HEIGHT),
+                                         g_para.NODE_SIZE, g_para.TIME_STEPS, (double)g_para.VELOCITY) == false)
     {
-        replay = false;
-        g_pos_record->open (filename, SFMode_Write);
+        printf ("InitSim (): cannot load movement trace '%s'\n", filename);
+        return (-1);
     }
 
-    // create behavior model
-    g_move_model.initModel (g_para.MOVE_MODEL, g_pos_record, replay, 
-                            Position (0,0), Position ((coord_t)g_para.WORLD_WIDTH, (coord_t)g_para.WORLD_HEIGHT),
-                            g_para.NODE_SIZE, g_para.TIME_STEPS, (double)g_para.VELOCITY);    
-
-    // close position log file
-    fcf.DestroyFileClass (g_pos_record);
-
     // initialize random number generator
     //srand ((unsigned int)time (NULL));
     srand (37);
@@ -32,6 +32,7 @@
 #include <map>
 #include <algorithm>
 #include "vast.h"
+#include "AOIGroundTruth.h"
 #include "VASTsim.h"
 #include "SimNode.h"
 
@@ -50,12 +51,16 @@ public:
         _AN_actual_accumulated = _AN_visible_accumulated = 0;
         _AN_actual_first_interval = _AN_visible_first_interval =0;
         _fp = NULL;
+        _truth = NULL;
     }
 
     ~statistics ()
     {
         if (_fp != NULL)
             fclose (_fp);        
+
+        if (_truth != NULL)
+            delete _truth;
     }
 
     void init_variables ()
@@ -110,6 +115,9 @@ public:
             count++;
         }
         
+        // grid cells about the size of an AOI (negative radius means random radius up to the value)
+        _truth = new AOIGroundTruth ((coord_t)abs (_para.AOI_RADIUS));
+
         print_header ();
         init_variables ();        
     }
@@ -178,49 +186,48 @@ public:
 		return false;
 	}
 
-    void calc_consistency (size_t i, size_t &AN_actual, size_t &AN_visible, size_t &total_drift, size_t &max_drift, size_t &drift_nodes)
-    {		
-		
-        size_t n = _simnodes.size ();
+    // pass positions of all nodes to the ground truth, only neighbors of moved nodes are recomputed
+    void update_ground_truth ()
+    {
+        for (size_t i=0; i < _simnodes.size (); ++i)
+            _truth->update (i, is_failed (i) == false, _simnodes[i]->get_pos (), _simnodes[i]->get_aoi ());
+    }
 
+    void calc_consistency (size_t i, size_t &AN_actual, size_t &AN_visible, size_t &total_drift, size_t &max_drift, size_t &drift_nodes)
+    {
         Node *neighbor;
         AN_actual = AN_visible = total_drift = max_drift = drift_nodes = 0;
 
-        // loop through all nodes
-        for (size_t j=0; j<n; ++j)
-        {                
-            // skip self-check
-            if (i == j || is_failed(j))
-                continue;
+        // actual AOI neighbors (failed nodes excluded)
+        const vector<size_t> &actual = _truth->getNeighbors (i);
+
+        // loop through all nodes within AOI
+        for (size_t k=0; k < actual.size (); ++k)
+        {
+            size_t j = actual[k];
+
+            AN_actual++;
 
-            // visible neighbors
-            if (_simnodes[i]->in_view (_simnodes[j]))
+            if ((neighbor = _simnodes[i]->knows (_simnodes[j])) != NULL)
             {
-                AN_actual++;
-                
-                if ((neighbor = _simnodes[i]->knows (_simnodes[j])) != NULL)
-                {
-                    AN_visible++;           
-                   
-                    // calculate drift distance (except self)
-                    // NOTE: drift distance is calculated for all known AOI neighbors
-                    drift_nodes++;
+                AN_visible++;
 
-                    size_t drift = (size_t)neighbor->aoi.center.distance (_simnodes[j]->get_pos ());
-                    total_drift += drift;
-                    
-                    if (max_drift < drift)
-                    {
-                        max_drift = drift;
+                // calculate drift distance (except self)
+                // NOTE: drift distance is calculated for all known AOI neighbors
+                drift_nodes++;
+
+                size_t drift = (size_t)neighbor->aoi.center.distance (_simnodes[j]->get_pos ());
+                total_drift += drift;
+
+                if (max_drift < drift)
+                {
+                    max_drift = drift;
 #ifdef DEBUG_DETAIL
-                        printf ("%4d - max drift updated: [%d] info on [%d] drift: %d\n", _steps+1, (int)_simnodes[i]->get_id (), (int)neighbor->id, (int)drift);
+                    printf ("%4d - max drift updated: [%d] info on [%d] drift: %d\n", _steps+1, (int)_simnodes[i]->get_id (), (int)neighbor->id, (int)drift);
 #endif
-                    }                        
                 }
             }
-        } // end looping through all other nodes
-
-
+        } // end looping through AOI neighbors
     }
 
     // NOTE: some variable abbreviation
@@ -248,6 +255,8 @@ public:
 
         size_t recovery_steps;
 
+        update_ground_truth ();
+
         // loop through all nodes to calculate statistics
         for (i=0; i<n; ++i)
         {           
@@ -662,6 +671,9 @@ private:
     size_t          _max_RS, _recovery_steps, _recovery_count, _inconsistent_count;
 
     vector<pair<size_t, Vast::id_t> *> _inconsistent_nodes;    // node ids
+
+    // actual AOI neighbors of all nodes
+    AOIGroundTruth *_truth;
 };
 
 
@@ -0,0 +1,146 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "AOIGroundTruth.h"
+#include <math.h>       // sqrt
+
+namespace Vast {
+
+AOIGroundTruth::AOIGroundTruth (coord_t cell_size)
+    : _grid (cell_size), _max_radius (0), _recomputed (0)
+{
+}
+
+AOIGroundTruth::~AOIGroundTruth ()
+{
+}
+
+// set the current state of a node, inactive nodes are no one's neighbors
+void
+AOIGroundTruth::update (size_t index, bool active, const Position &center, length_t radius)
+{
+    if (index >= _active.size ())
+    {
+        _center.resize (index + 1);
+        _radius.resize (index + 1, 0);
+        _active.resize (index + 1, false);
+        _dirty.resize (index + 1, true);
+        _neighbors.resize (index + 1);
+    }
+
+    bool was_active = _active[index];
+
+    if (active == was_active && (active == false ||
+        (_center[index].x == center.x && _center[index].y == center.y && _radius[index] == radius)))
+        return;
+
+    // a node's own view changes with its position or radius
+    _dirty[index] = true;
+
+    if (active && radius > _max_radius)
+        _max_radius = radius;
+
+    // nodes that saw the old position, or may see the new one
+    if (was_active)
+        markViewers (_center[index]);
+
+    if (active)
+    {
+        _grid.update ((id_t)index, center);
+        markViewers (center);
+    }
+    else if (was_active)
+        _grid.remove ((id_t)index);
+
+    _active[index] = active;
+    _center[index] = center;
+    _radius[index] = radius;
+}
+
+// nodes strictly within the AOI of a node (excluding itself)
+const vector<size_t> &
+AOIGroundTruth::getNeighbors (size_t index)
+{
+    static vector<size_t> empty;
+
+    if (index >= _active.size ())
+        return empty;
+
+    vector<size_t> &list = _neighbors[index];
+
+    if (_dirty[index])
+    {
+        list.clear ();
+
+        if (_active[index])
+        {
+            _grid.getWithin (_center[index], _radius[index], _found);
+
+            // same test as the nodes' in_view ()
+            for (size_t i=0; i < _found.size (); i++)
+            {
+                size_t j = (size_t)_found[i];
+                if (j != index && _center[index].distance (_center[j]) < (double)_radius[index])
+                    list.push_back (j);
+            }
+        }
+
+        _dirty[index] = false;
+        _recomputed++;
+    }
+
+    return list;
+}
+
+// mark all nodes that could see a position as needing recomputation
+void
+AOIGroundTruth::markViewers (const Position &pos)
+{
+    _grid.getWithin (pos, _max_radius, _found);
+
+    for (size_t i=0; i < _found.size (); i++)
+    {
+        size_t j = (size_t)_found[i];
+        if (_dirty[j] == false && _center[j].distance (pos) < (double)_radius[j])
+            _dirty[j] = true;
+    }
+}
+
+// half-width of the confidence interval of the ratio (ratio estimator, with finite population correction)
+double
+RatioSample::getInterval (size_t population, double z)
+{
+    if (_n < 2 || _sum_y <= 0 || _n >= population)
+        return 0;
+
+    double ratio  = getRatio ();
+    double mean_y = _sum_y / _n;
+
+    // sample variance of the residuals (x - ratio * y)
+    double s2 = (_sum_xx - 2 * ratio * _sum_xy + ratio * ratio * _sum_yy) / (_n - 1);
+    if (s2 < 0)
+        s2 = 0;
+
+    double variance = (1.0 - (double)_n / population) * s2 / (_n * mean_y * mean_y);
+
+    return z * sqrt (variance);
+}
+
+} // end namespace Vast
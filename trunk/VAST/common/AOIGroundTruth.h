@@ -0,0 +1,124 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  AOIGroundTruth.h -- actual AOI neighbors of simulated nodes (the global view)
+ *
+ *      nodes are kept in a SpatialGrid, and only nodes that moved, or that may see
+ *      a node that moved, have their neighbor lists recomputed (when next asked for).
+ *      used by the simulators' statistics to measure topology consistency
+ *      without checking every pair of nodes.
+ */
+
+#ifndef VAST_AOI_GROUND_TRUTH_H
+#define VAST_AOI_GROUND_TRUTH_H
+
+#include "VASTTypes.h"
+#include "SpatialGrid.h"
+#include <vector>
+
+using namespace std;
+
+namespace Vast {
+
+class EXPORT AOIGroundTruth
+{
+public:
+    // cell size of the grid is best about the AOI radius
+    AOIGroundTruth (coord_t cell_size);
+    ~AOIGroundTruth ();
+
+    // set the current state of a node (indexed from 0), inactive nodes are no one's neighbors
+    void update (size_t index, bool active, const Position &center, length_t radius);
+
+    // nodes strictly within the AOI of a node (excluding itself), as of the last updates
+    const vector<size_t> &getNeighbors (size_t index);
+
+    // # of neighbor lists recomputed since created (to check how incremental the updates are)
+    size_t getRecomputeCount ()
+    {
+        return _recomputed;
+    }
+
+private:
+
+    // mark all nodes that could see a position as needing recomputation
+    void markViewers (const Position &pos);
+
+    SpatialGrid             _grid;          // positions of active nodes
+    vector<Position>        _center;
+    vector<length_t>        _radius;
+    vector<bool>            _active;
+    vector<bool>            _dirty;         // whether neighbor list needs recomputation
+    vector<vector<size_t> > _neighbors;
+    length_t                _max_radius;    // largest AOI ever seen
+    size_t                  _recomputed;
+    vector<id_t>            _found;         // buffer for grid queries
+};
+
+// estimates a ratio (such as visible / actual AOI neighbors) from a random
+// sample of units drawn from a larger population, with a confidence interval
+class EXPORT RatioSample
+{
+public:
+    RatioSample ()
+    {
+        reset ();
+    }
+
+    void reset ()
+    {
+        _n = 0;
+        _sum_x = _sum_y = _sum_xx = _sum_yy = _sum_xy = 0;
+    }
+
+    // add one sampled unit (numerator & denominator)
+    void add (double x, double y)
+    {
+        _n++;
+        _sum_x  += x;
+        _sum_y  += y;
+        _sum_xx += x * x;
+        _sum_yy += y * y;
+        _sum_xy += x * y;
+    }
+
+    size_t size ()
+    {
+        return _n;
+    }
+
+    double getRatio ()
+    {
+        return (_sum_y > 0 ? _sum_x / _sum_y : 0);
+    }
+
+    // half-width of the confidence interval of the ratio, given the population size
+    // (z = 1.96 for 95% confidence), 0 if the whole population is sampled
+    double getInterval (size_t population, double z = 1.96);
+
+private:
+    size_t  _n;
+    double  _sum_x, _sum_y, _sum_xx, _sum_yy, _sum_xy;
+};
+
+} // end namespace Vast
+
+#endif // VAST_AOI_GROUND_TRUTH_H
@@ -0,0 +1,430 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "BinaryLog.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef WIN32
+#define snprintf _snprintf
+#endif
+
+namespace Vast {
+
+// argument types as stored in a record
+enum
+{
+    LOG_ARG_INT,        // all integers & characters, stored as 64-bit
+    LOG_ARG_DOUBLE,     // floating points, stored as double
+    LOG_ARG_STRING,     // length (uint8) followed by characters
+    LOG_ARG_POINTER     // pointers, stored as 64-bit
+};
+
+// a single conversion specification in a format string
+struct LogSpec
+{
+    const char *begin;      // points to '%'
+    const char *end;        // points past the conversion character
+    int         width;      // 1 if width is '*'
+    int         precision;  // 1 if precision is '*'
+    int         type;       // LOG_ARG_XXX, or -1 for "%%"
+    bool        is_signed;  // whether integer is signed
+    int         length;     // 0: int, 1: char (hh), 2: short (h), 3: long (l), 4: long long (ll, j, q, I64), 5: size_t (z, t, I)
+    bool        is_long_double;
+};
+
+// parse the specification starting at 'p' (which points to '%')
+static void parseSpec (const char *p, LogSpec &spec)
+{
+    spec.begin      = p++;
+    spec.width      = 0;
+    spec.precision  = 0;
+    spec.type       = LOG_ARG_INT;
+    spec.is_signed  = false;
+    spec.length     = 0;
+    spec.is_long_double = false;
+
+    if (*p == '%')
+    {
+        spec.type = -1;
+        spec.end  = p + 1;
+        return;
+    }
+
+    // flags
+    while (*p && strchr ("-+ #0'", *p))
+        p++;
+
+    // width
+    if (*p == '*')
+    {
+        spec.width = 1;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9')
+        p++;
+
+    // precision
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            spec.precision = 1;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+
+    // length modifiers
+    if (p[0] == 'h' && p[1] == 'h')     { spec.length = 1; p += 2; }
+    else if (p[0] == 'h')               { spec.length = 2; p++; }
+    else if (p[0] == 'l' && p[1] == 'l'){ spec.length = 4; p += 2; }
+    else if (p[0] == 'l')               { spec.length = 3; p++; }
+    else if (p[0] == 'j' || p[0] == 'q'){ spec.length = 4; p++; }
+    else if (p[0] == 'z' || p[0] == 't'){ spec.length = 5; p++; }
+    else if (p[0] == 'L')               { spec.is_long_double = true; p++; }
+    else if (p[0] == 'I' && p[1] == '6' && p[2] == '4') { spec.length = 4; p += 3; }
+    else if (p[0] == 'I' && p[1] == '3' && p[2] == '2') { spec.length = 0; p += 3; }
+    else if (p[0] == 'I')               { spec.length = 5; p++; }
+
+    switch (*p)
+    {
+    case 'd': case 'i':
+        spec.is_signed = true;
+        break;
+    case 'u': case 'o': case 'x': case 'X': case 'c':
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec.type = LOG_ARG_DOUBLE;
+        break;
+    case 's':
+        spec.type = LOG_ARG_STRING;
+        break;
+    case 'p': case 'n':
+        spec.type = LOG_ARG_POINTER;
+        break;
+    default:
+        // unknown conversion, print as is
+        spec.type = -1;
+        break;
+    }
+
+    spec.end = (*p ? p + 1 : p);
+}
+
+// extract an integer argument according to its length modifier
+static int64_t extractInt (va_list &args, const LogSpec &spec)
+{
+    switch (spec.length)
+    {
+    case 3:
+        return spec.is_signed ? (int64_t)va_arg (args, long) : (int64_t)va_arg (args, unsigned long);
+    case 4:
+        return spec.is_signed ? (int64_t)va_arg (args, long long) : (int64_t)va_arg (args, unsigned long long);
+    case 5:
+        return (int64_t)va_arg (args, size_t);
+    default:
+        {
+            // char & short are promoted to int
+            int64_t value = spec.is_signed ? (int64_t)va_arg (args, int) : (int64_t)va_arg (args, unsigned int);
+            if (spec.length == 1)
+                value = spec.is_signed ? (int64_t)(signed char)value : (int64_t)(unsigned char)value;
+            else if (spec.length == 2)
+                value = spec.is_signed ? (int64_t)(short)value : (int64_t)(unsigned short)value;
+            return value;
+        }
+    }
+}
+
+// encode the arguments of a format string into a buffer (without header)
+// returns the # of bytes used
+size_t
+BinaryLog::encode (char *buf, size_t size, const char *format, va_list args)
+{
+    size_t n = 0;
+
+    // NOTE: va_list has to be passed by reference on some platforms, so we work on a copy
+    va_list ap;
+#ifdef va_copy
+    va_copy (ap, args);
+#else
+    ap = args;
+#endif
+
+    for (const char *p = format; *p; )
+    {
+        if (*p != '%')
+        {
+            p++;
+            continue;
+        }
+
+        LogSpec spec;
+        parseSpec (p, spec);
+        p = spec.end;
+
+        if (spec.type == -1)
+            continue;
+
+        // '*' width & precision are integer arguments
+        for (int i=0; i < spec.width + spec.precision; i++)
+        {
+            int64_t value = va_arg (ap, int);
+            if (n + sizeof (int64_t) <= size)
+                memcpy (buf + n, &value, sizeof (int64_t));
+            n += sizeof (int64_t);
+        }
+
+        switch (spec.type)
+        {
+        case LOG_ARG_INT:
+            {
+                int64_t value = extractInt (ap, spec);
+                if (n + sizeof (int64_t) <= size)
+                    memcpy (buf + n, &value, sizeof (int64_t));
+                n += sizeof (int64_t);
+            }
+            break;
+
+        case LOG_ARG_DOUBLE:
+            {
+                double value = spec.is_long_double ? (double)va_arg (ap, long double) : va_arg (ap, double);
+                if (n + sizeof (double) <= size)
+                    memcpy (buf + n, &value, sizeof (double));
+                n += sizeof (double);
+            }
+            break;
+
+        case LOG_ARG_STRING:
+            {
+                const char *str = va_arg (ap, const char *);
+                if (str == NULL)
+                    str = "(null)";
+
+                size_t len = strlen (str);
+                if (len > LOG_STRING_MAX)
+                    len = LOG_STRING_MAX;
+
+                if (n + 1 + len <= size)
+                {
+                    buf[n] = (char)(unsigned char)len;
+                    memcpy (buf + n + 1, str, len);
+                }
+                n += 1 + len;
+            }
+            break;
+
+        case LOG_ARG_POINTER:
+            {
+                uint64_t value = (uint64_t)(size_t)va_arg (ap, void *);
+                if (n + sizeof (uint64_t) <= size)
+                    memcpy (buf + n, &value, sizeof (uint64_t));
+                n += sizeof (uint64_t);
+            }
+            break;
+        }
+    }
+
+    va_end (ap);
+
+    // arguments are truncated if exceeding buffer
+    return (n > size ? size : n);
+}
+
+// print encoded arguments according to a format string
+// returns the length of the text
+size_t
+BinaryLog::decode (char *text, size_t size, const char *format, const char *args, size_t length)
+{
+    if (size == 0)
+        return 0;
+
+    size_t n = 0;           // length of text
+    size_t pos = 0;         // position in args
+    char spec_format[64];   // format of a single specification, rewritten for stored types
+
+    text[0] = 0;
+
+    for (const char *p = format; *p && n + 1 < size; )
+    {
+        if (*p != '%')
+        {
+            text[n++] = *p++;
+            continue;
+        }
+
+        LogSpec spec;
+        parseSpec (p, spec);
+        p = spec.end;
+
+        if (spec.type == -1)
+        {
+            // copy "%%" or unknown conversion as is
+            for (const char *q = (spec.begin[1] == '%' ? spec.begin + 1 : spec.begin); q < spec.end && n + 1 < size; q++)
+                text[n++] = *q;
+            continue;
+        }
+
+        // rebuild the specification: flags, width & precision (with '*' replaced by values), then stored type
+        size_t f = 0;
+        const char *q = spec.begin;
+        spec_format[f++] = *q++;
+        while (q < spec.end - 1 && f < sizeof (spec_format) - 24)
+        {
+            char c = *q;
+            if (c == '*')
+            {
+                int64_t value = 0;
+                if (pos + sizeof (int64_t) <= length)
+                    memcpy (&value, args + pos, sizeof (int64_t));
+                pos += sizeof (int64_t);
+                f += sprintf (spec_format + f, "%d", (int)value);
+                q++;
+            }
+            else if (strchr ("hlLjztqI", c))
+            {
+                // skip length modifiers (including digits of I64 / I32)
+                q++;
+                if (c == 'I')
+                    while (q < spec.end - 1 && *q >= '0' && *q <= '9')
+                        q++;
+            }
+            else
+                spec_format[f++] = *q++;
+        }
+
+        char conv = *(spec.end - 1);
+        int  written = 0;
+
+        switch (spec.type)
+        {
+        case LOG_ARG_INT:
+            {
+                int64_t value = 0;
+                if (pos + sizeof (int64_t) <= length)
+                    memcpy (&value, args + pos, sizeof (int64_t));
+                pos += sizeof (int64_t);
+
+                if (conv == 'c')
+                {
+                    spec_format[f++] = 'c';
+                    spec_format[f] = 0;
+                    written = snprintf (text + n, size - n, spec_format, (int)value);
+                }
+                else
+                {
+                    spec_format[f++] = 'l';
+                    spec_format[f++] = 'l';
+                    spec_format[f++] = conv;
+                    spec_format[f] = 0;
+                    if (spec.is_signed)
+                        written = snprintf (text + n, size - n, spec_format, (long long)value);
+                    else
+                        written = snprintf (text + n, size - n, spec_format, (unsigned long long)value);
+                }
+            }
+            break;
+
+        case LOG_ARG_DOUBLE:
+            {
+                double value = 0;
+                if (pos + sizeof (double) <= length)
+                    memcpy (&value, args + pos, sizeof (double));
+                pos += sizeof (double);
+
+                spec_format[f++] = conv;
+                spec_format[f] = 0;
+                written = snprintf (text + n, size - n, spec_format, value);
+            }
+            break;
+
+        case LOG_ARG_STRING:
+            {
+                char str[LOG_STRING_MAX + 1];
+                size_t len = 0;
+                if (pos < length)
+                {
+                    len = (unsigned char)args[pos];
+                    if (pos + 1 + len > length)
+                        len = length - pos - 1;
+                    memcpy (str, args + pos + 1, len);
+                }
+                str[len] = 0;
+                pos += 1 + len;
+
+                spec_format[f++] = 's';
+                spec_format[f] = 0;
+                written = snprintf (text + n, size - n, spec_format, str);
+            }
+            break;
+
+        case LOG_ARG_POINTER:
+            {
+                uint64_t value = 0;
+                if (pos + sizeof (uint64_t) <= length)
+                    memcpy (&value, args + pos, sizeof (uint64_t));
+                pos += sizeof (uint64_t);
+
+                // %n is not supported, pointers are printed in a platform-independent way
+                if (conv == 'p')
+                    written = snprintf (text + n, size - n, "0x%llx", (unsigned long long)value);
+            }
+            break;
+        }
+
+        if (written > 0)
+            n += ((size_t)written < size - n ? (size_t)written : size - n - 1);
+    }
+
+    text[n] = 0;
+    return n;
+}
+
+// format the time of a record as "GMT yyyy/mm/dd hh:mm:ss"
+void
+BinaryLog::formatTime (char *text, size_t size, uint64_t time)
+{
+    time_t rawtime = (time_t)(time / 1000000);
+    tm *timeinfo = gmtime (&rawtime);
+
+    if (timeinfo == NULL)
+        snprintf (text, size, "GMT %llu", (unsigned long long)time);
+    else
+        snprintf (text, size, "GMT %04d/%02d/%02d %02d:%02d:%02d", timeinfo->tm_year+1900, timeinfo->tm_mon+1, timeinfo->tm_mday, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+}
+
+// read the next record from a log file, format strings are returned as arguments
+// returns false at end of file or if the record is corrupt
+bool
+BinaryLog::readRecord (FILE *fp, LogRecordHeader &header, char *args)
+{
+    if (fread (&header, sizeof (LogRecordHeader), 1, fp) != 1)
+        return false;
+
+    if (header.size < sizeof (LogRecordHeader) || header.size > LOG_RECORD_MAX_SIZE)
+        return false;
+
+    size_t length = header.size - sizeof (LogRecordHeader);
+    return (length == 0 || fread (args, length, 1, fp) == 1);
+}
+
+} // end namespace Vast
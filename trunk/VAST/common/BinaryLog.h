@@ -0,0 +1,89 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  BinaryLog.h -- compact binary log records (format ID + raw arguments)
+ *
+ *      a log record stores the ID of its printf-style format string and the arguments
+ *      as raw values, so formatting is deferred to a background thread or to an offline decoder.
+ *      a log file starts with LOG_FILE_MAGIC and defines each format once (as a LOG_LEVEL_FORMAT record)
+ *      before the first record using it.
+ *
+ *      NOTE: this file should not depend on ACE, so that decoders can be built without it
+ */
+
+#ifndef VAST_BINARY_LOG_H
+#define VAST_BINARY_LOG_H
+
+#include "VASTTypes.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+
+#define LOG_FILE_MAGIC          "VASTLOG1"  // first bytes of a binary log file
+#define LOG_RECORD_MAX_SIZE     (1024)      // max size of a single record (header + arguments)
+#define LOG_STRING_MAX          (255)       // max length of a string argument kept in a record
+#define LOG_TEXT_MAX            (4096)      // max length of a decoded record
+
+// log levels, records below the current level are discarded at the caller
+#define LOG_LEVEL_DEBUG         (0)
+#define LOG_LEVEL_INFO          (1)
+#define LOG_LEVEL_WARNING       (2)
+#define LOG_LEVEL_ERROR         (3)
+#define LOG_LEVEL_NONE          (4)         // disables all logging
+#define LOG_LEVEL_FORMAT        (255)       // record defines a format string (stored as arguments)
+
+using namespace std;
+
+namespace Vast {
+
+// header of each record, followed by the encoded arguments
+struct LogRecordHeader
+{
+    uint16_t    size;           // size of the whole record
+    uint8_t     level;          // log level (or LOG_LEVEL_FORMAT)
+    uint8_t     reserved;
+    uint32_t    format_id;      // ID of the format string
+    uint64_t    time;           // time of logging (microseconds since epoch)
+};
+
+class EXPORT BinaryLog
+{
+public:
+
+    // encode the arguments of a format string into a buffer (without header)
+    // returns the # of bytes used
+    static size_t encode (char *buf, size_t size, const char *format, va_list args);
+
+    // print encoded arguments according to a format string
+    // returns the length of the text
+    static size_t decode (char *text, size_t size, const char *format, const char *args, size_t length);
+
+    // format the time of a record as "GMT yyyy/mm/dd hh:mm:ss"
+    static void formatTime (char *text, size_t size, uint64_t time);
+
+    // read the next record from a log file, format strings are returned as arguments
+    // returns false at end of file or if the record is corrupt
+    static bool readRecord (FILE *fp, LogRecordHeader &header, char *args);
+};
+
+} // end namespace Vast
+
+#endif // VAST_BINARY_LOG_H
@@ -100,8 +100,8 @@ public:
                 int nearest;
 
                 // 10% chance to go to another attractor
-                if (rand () % 100 < PROB_RANDOM_ATTRACTOR)
-                    nearest = rand () % _num_attractors;
+                if (nextRandom () % 100 < PROB_RANDOM_ATTRACTOR)
+                    nearest = nextRandom () % _num_attractors;
                 else
                     nearest = find_nearest (_pos[i]);
 
@@ -115,7 +115,7 @@ public:
 
 #ifdef TELEPORT_CHANCE
             // a slight chance to simply teleport to a new location
-            if (rand () % 10000 < TELEPORT_CHANCE)
+            if (nextRandom () % 10000 < TELEPORT_CHANCE)
             {
                 rand_pos (_pos[i], _topleft, _bottomright);
                 rand_pos (_dest[i], _topleft, _bottomright);
@@ -63,6 +63,29 @@
 // whether VAST should send timestamps to calculate & record transmission latencies
 #define VAST_RECORD_LATENCY_
 
+// whether mutually visible clients on public IPs also send position updates to each other directly
+// (as authorized by their matchers, which still decide who the neighbors are)
+// NOTE: neighbor positions arrive in one hop instead of via relays & matcher, at the cost of more connections
+#define VAST_DIRECT_NEIGHBORS_
+
+// whether the gateway promotes the candidate matcher with the least weighted physical distance (RTT)
+// to the subscribers it will serve, instead of the first available one
+// NOTE: subscriptions then carry the subscriber's physical coordinate, so all hosts must be built with the same setting
+#define MATCHER_PLACEMENT_LOCALITY_
+
+// whether VASTnet should append a send timestamp to each message to record per-type latencies
+// NOTE: changes the wire format, so all hosts must be built with the same setting
+//       latency is recorded only for senders sharing our clock (same machine, or the emulated network)
+#define VASTNET_RECORD_LATENCY_
+
+// whether VASTnet should record how long each sent message waits until flush () (per-type queueing delay)
+#define VASTNET_RECORD_QUEUE_DELAY_
+
+// whether VASTThread processes incoming messages as soon as they arrive (ACE network only),
+// instead of only once per tick (the callback's per-tick tasks still run once per tick)
+// NOTE: handlers' per-tick processing (postHandling) then runs on each burst of input as well
+#define VASTTHREAD_EVENT_DRIVEN_
+
 //
 // for topology-aware simulations
 //
@@ -88,6 +111,8 @@
 #define DEBUG_DETAIL_
 
 #define VAST_POSFILE_FORMAT "N%04dW%dx%dS%d.pos"                            
+#define VAST_TRACEFILE_FORMAT "N%04dW%dx%dS%d.trace"       // memory-mapped trace (MovementTrace)
+#define VAST_LATENCYFILE "latency.txt"                      // one-way latencies among emulated hosts (net_emubridge::loadLatencyMatrix)
 
 // Send all messages by bandwidth limitation
 // /* don't define anything */
@@ -0,0 +1,142 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "Histogram.h"
+
+namespace Vast {
+
+#define HISTOGRAM_SUB_SIZE  (1 << HISTOGRAM_SUB_BITS)
+
+// record one value
+void
+Histogram::record (uint64_t value)
+{
+    size_t index = getIndex (value);
+    if (index >= _counts.size ())
+        _counts.resize (index + 1, 0);
+
+    _counts[index]++;
+    _count++;
+    _total += value;
+
+    if (value < _min)
+        _min = value;
+    if (value > _max)
+        _max = value;
+}
+
+// add all records of another histogram
+void
+Histogram::merge (const Histogram &other)
+{
+    if (other._counts.size () > _counts.size ())
+        _counts.resize (other._counts.size (), 0);
+
+    for (size_t i=0; i < other._counts.size (); i++)
+        _counts[i] += other._counts[i];
+
+    _count += other._count;
+    _total += other._total;
+
+    if (other._count > 0)
+    {
+        if (other._min < _min)
+            _min = other._min;
+        if (other._max > _max)
+            _max = other._max;
+    }
+}
+
+// remove all records
+void
+Histogram::reset ()
+{
+    _counts.clear ();
+    _count = 0;
+    _total = 0;
+    _min   = (uint64_t)(-1);
+    _max   = 0;
+}
+
+// value at or below which a percentage (0 - 100) of records lie
+uint64_t
+Histogram::getPercentile (double percent) const
+{
+    if (_count == 0)
+        return 0;
+
+    if (percent <= 0)
+        return _min;
+
+    // rank of the record to find (1 to _count)
+    uint64_t rank = (uint64_t)(percent / 100.0 * _count + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t sum = 0;
+    for (size_t i=0; i < _counts.size (); i++)
+    {
+        sum += _counts[i];
+        if (sum >= rank)
+        {
+            uint64_t value = getValue (i);
+            return (value < _max ? value : _max);
+        }
+    }
+
+    return _max;
+}
+
+// bucket a value falls in
+size_t
+Histogram::getIndex (uint64_t value)
+{
+    // values in the first two sub-ranges are counted exactly
+    if (value < 2 * HISTOGRAM_SUB_SIZE)
+        return (size_t)value;
+
+    // position of the highest bit set
+    int msb = 0;
+    while ((value >> msb) > 1)
+        msb++;
+
+    // keep the top (HISTOGRAM_SUB_BITS + 1) bits
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    return (size_t)(shift * HISTOGRAM_SUB_SIZE + (value >> shift));
+}
+
+// largest value counted by a bucket
+uint64_t
+Histogram::getValue (size_t index)
+{
+    if (index < 2 * HISTOGRAM_SUB_SIZE)
+        return (uint64_t)index;
+
+    int shift = (int)(index / HISTOGRAM_SUB_SIZE) - 1;
+    uint64_t sub = index - shift * HISTOGRAM_SUB_SIZE;
+
+    // top bucket would overflow
+    if (shift + HISTOGRAM_SUB_BITS + 1 >= 64 && sub == 2 * HISTOGRAM_SUB_SIZE - 1)
+        return (uint64_t)(-1);
+
+    return ((sub + 1) << shift) - 1;
+}
+
+} // end namespace Vast
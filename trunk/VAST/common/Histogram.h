@@ -0,0 +1,104 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  Histogram.h -- log-linear histogram for percentiles of sizes & latencies
+ *
+ *      values below 2^(HISTOGRAM_SUB_BITS+1) are counted exactly, larger values are
+ *      counted in 2^HISTOGRAM_SUB_BITS buckets per power of two, so a percentile is
+ *      reported within 1/2^HISTOGRAM_SUB_BITS of the actual value (as in HdrHistogram).
+ *      buckets are allocated only up to the largest value recorded.
+ */
+
+#ifndef VAST_HISTOGRAM_H
+#define VAST_HISTOGRAM_H
+
+#include "VASTTypes.h"
+#include <vector>
+
+#define HISTOGRAM_SUB_BITS      (4)     // 16 buckets per power of two (~6% precision)
+
+using namespace std;
+
+namespace Vast {
+
+class EXPORT Histogram
+{
+public:
+    Histogram ()
+    {
+        reset ();
+    }
+
+    // record one value
+    void record (uint64_t value);
+
+    // add all records of another histogram
+    void merge (const Histogram &other);
+
+    // remove all records
+    void reset ();
+
+    uint64_t getCount () const
+    {
+        return _count;
+    }
+
+    uint64_t getTotal () const
+    {
+        return _total;
+    }
+
+    uint64_t getMinimum () const
+    {
+        return (_count == 0 ? 0 : _min);
+    }
+
+    uint64_t getMaximum () const
+    {
+        return _max;
+    }
+
+    double getAverage () const
+    {
+        return (_count == 0 ? 0 : (double)_total / _count);
+    }
+
+    // value at or below which a percentage (0 - 100) of records lie
+    uint64_t getPercentile (double percent) const;
+
+private:
+
+    // bucket a value falls in
+    static size_t getIndex (uint64_t value);
+
+    // largest value counted by a bucket
+    static uint64_t getValue (size_t index);
+
+    vector<uint32_t>    _counts;
+    uint64_t            _count;
+    uint64_t            _total;
+    uint64_t            _min;
+    uint64_t            _max;
+};
+
+} // end namespace Vast
+
+#endif // VAST_HISTOGRAM_H
@@ -35,6 +35,7 @@
 
 #include "VASTnet.h"
 #include "MessageHandler.h"
+#include "Profiler.h"
 #include <map>
 
 
@@ -48,7 +49,8 @@ namespace Vast
     public:
         MessageQueue (VASTnet *net)
             :_net (net), 
-             _default_host (NET_ID_UNASSIGNED)
+             _default_host (NET_ID_UNASSIGNED),
+             _profiler (NULL)
         {       
             // automatically start off the network
             _net->start ();
@@ -88,6 +90,9 @@ namespace Vast
         // store default route for unaddressable targets
         void setDefaultHost (id_t default_host);
 
+        // set profiler to record time spent in each part of tick () (NULL to disable)
+        void setProfiler (Profiler *profiler);
+
     private:
 
         // process all currently received messages (invoking previously registered handlers)
@@ -106,6 +111,9 @@ namespace Vast
 
         // default route if target cannot be resolved
         id_t                    _default_host;
+
+        // records time spent in network & handlers (may be NULL)
+        Profiler               *_profiler;
     };
 
 } // end namespace Vast
@@ -151,17 +151,32 @@ public:
         return _pos[node];
     }
 
+    // use a generator of our own for random choices (NULL to use rand ())
+    void setRandom (RandomGenerator *random)
+    {
+        _random = random;
+    }
+
 protected:
     // create a random position
     void rand_pos (Position &pos, Position &topleft, Position &bottomright);
 
+    // get a random non-negative integer
+    int nextRandom ()
+    {
+        return (_random != NULL ? (int)(_random->next () & 0x7FFFFFFF) : rand ());
+    }
+
     Position  _topleft, _bottomright;              // boundary for the movement space
     Position  _dim;                                // dimension of the world
     int       _num_nodes;                          // total number of nodes
     double    _speed;                              // speed of node movmenet
     Position *_pos;                                // coordinates of all nodes
+    RandomGenerator *_random;                      // generator for random choices, rand () if NULL
 };
 
+class MovementTrace;
+
 //
 //  MovementGenerator:  factory class to create actual movements,
 //                      also able to store/retrieve movement records
@@ -184,14 +199,22 @@ public:
     // read or create new movement model from file
     bool initModelFromFile (SimPara &simpara, const char *filename = NULL);
 
+    // map a step-major trace file (see MovementTrace.h), or stream a new one to disk first
+    // positions are then read from the file on demand instead of being kept in memory
+    bool initModelFromTrace (int model, const char *filename, Position top_left, Position bottom_right, int num_nodes, int num_steps, double speed);
+
     // get the positin for a given node at a given step
     // NOTE that both node number and step begin from 0
     Position *getPos (int node, int step);
 
 private:
+    // create a movement model of a given type, NULL if unknown
+    static MovementModel *createModel (int model, Position &top_left, Position &bottom_right, int num_nodes, double speed);
+
     // NOTE: we have to use pointer to avoid warning from VC
     // about an exported object uses the 'map' data structure
     map<int, vector<MoveCoord> > *__pos_list;          // complete positions for all nodes
+    MovementTrace *_trace;                              // mapped trace file, if used instead of __pos_list
     int _num_nodes, _num_steps;
 };
 
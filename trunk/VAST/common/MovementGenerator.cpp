@@ -30,6 +30,7 @@
 #include "RandomMovement.h"
 #include "ClusterMovement.h"
 #include "GroupMovement.h"
+#include "MovementTrace.h"
 
 using namespace std;
 
@@ -39,7 +40,7 @@ namespace Vast
 #define MOVEMENT_SECTION 2
 
 MovementModel::MovementModel (Position &world_p1, Position &world_p2, int num_nodes, double speed)
-    :_topleft (world_p1), _bottomright (world_p2), _num_nodes (num_nodes), _speed (speed)
+    :_topleft (world_p1), _bottomright (world_p2), _num_nodes (num_nodes), _speed (speed), _random (NULL)
 
 {
     _dim.x = _bottomright.x - _topleft.x;
@@ -55,12 +56,12 @@ MovementModel::~MovementModel ()
 // create a random position
 void MovementModel::rand_pos (Position &pos, Position &topleft, Position &bottomright)
 {
-    pos.x = topleft.x + rand () % (int)(bottomright.x - topleft.x);
-    pos.y = topleft.y + rand () % (int)(bottomright.y - topleft.y);
+    pos.x = topleft.x + nextRandom () % (int)(bottomright.x - topleft.x);
+    pos.y = topleft.y + nextRandom () % (int)(bottomright.y - topleft.y);
 }
 
 MovementGenerator::MovementGenerator ()  
-        :_num_nodes (0), _num_steps (0)
+        :_trace (NULL), _num_nodes (0), _num_steps (0)
 {
     __pos_list = new map<int, vector<MoveCoord> >;
 }
@@ -75,6 +76,9 @@ MovementGenerator::~MovementGenerator ()
     __pos_list->clear ();
     
     delete __pos_list;    
+
+    if (_trace != NULL)
+        delete _trace;
 }
 
 MovementGenerator *g_MovementGeneratorInstance;
@@ -109,6 +113,10 @@ MovementGenerator::initModel (int model, SectionedFile *record, bool replay,
     
     map<int, vector<MoveCoord> > &_pos_list = *__pos_list;
 
+    // positions are kept in memory from now on
+    if (_trace != NULL)
+        _trace->close ();
+
     MoveCoord pos;
     if (replay == true)
     {
@@ -127,24 +135,9 @@ MovementGenerator::initModel (int model, SectionedFile *record, bool replay,
     else
     {
         // create the proper movement model
-        MovementModel *move_model;
-        switch (model)
-        {
-        case VAST_MOVEMENT_RANDOM:
-            move_model = new RandomMovement (top_left, bottom_right, num_nodes, speed);
-            break;
-
-        case VAST_MOVEMENT_CLUSTER:
-            move_model = new ClusterMovement (top_left, bottom_right, num_nodes, speed);
-            break;
-
-        case VAST_MOVEMENT_GROUP:
-            move_model = new GroupMovement (top_left, bottom_right, num_nodes, speed);
-            break;
-
-        default:
+        MovementModel *move_model = createModel (model, top_left, bottom_right, num_nodes, speed);
+        if (move_model == NULL)
             return false;
-        }
 
         move_model->init ();
 
@@ -221,6 +214,94 @@ MovementGenerator::initModelFromFile (SimPara &simpara, const char *fname)
 }
 
 
+// map a step-major trace file, or stream a new one to disk first
+bool
+MovementGenerator::initModelFromTrace (int model, const char *filename,
+                                       Position top_left, Position bottom_right,
+                                       int num_nodes, int num_steps, double speed)
+{
+    errout eo;
+
+    if (_trace == NULL)
+        _trace = new MovementTrace;
+
+    // replay an existing trace if it covers what's asked
+    if (_trace->open (filename))
+    {
+        if (_trace->getNodeSize () >= num_nodes && _trace->getStepSize () >= num_steps)
+        {
+            _num_nodes = num_nodes;
+            _num_steps = num_steps;
+            return true;
+        }
+
+        eo.output ("MovementGenerator: trace file is too small, re-creating.\n");
+        _trace->close ();
+    }
+
+    MovementModel *move_model = createModel (model, top_left, bottom_right, num_nodes, speed);
+    if (move_model == NULL)
+        return false;
+
+    // fixed seed so the same parameters always produce the same trace
+    // NOTE: a generator of our own is used, so the shared rand () stream is left untouched
+    RandomGenerator random (37);
+    move_model->setRandom (&random);
+    move_model->init ();
+
+    // write one step at a time, only positions of the current step are kept in memory
+    bool success = _trace->create (filename, num_nodes, num_steps,
+                                   (int)(bottom_right.x - top_left.x), (int)(bottom_right.y - top_left.y));
+
+    vector<MoveCoord> coords (num_nodes);
+    for (int s = 0; success && s <= num_steps; s++)
+    {
+        for (int p = 0; p < num_nodes; p++)
+        {
+            Position &pos = move_model->getpos (p);
+            coords[p].x = (movecoord_t)pos.x;
+            coords[p].y = (movecoord_t)pos.y;
+        }
+
+        success = _trace->writeStep (&coords[0]);
+        move_model->move ();
+    }
+
+    delete move_model;
+
+    if (success == false || _trace->finish () == false || _trace->open (filename) == false)
+    {
+        eo.output ("MovementGenerator: writing trace file failed.\n");
+        _trace->close ();
+        return false;
+    }
+
+    _num_nodes = num_nodes;
+    _num_steps = num_steps;
+
+    return true;
+}
+
+// create a movement model of a given type, NULL if unknown
+MovementModel *
+MovementGenerator::createModel (int model, Position &top_left, Position &bottom_right, int num_nodes, double speed)
+{
+    switch (model)
+    {
+    case VAST_MOVEMENT_RANDOM:
+        return new RandomMovement (top_left, bottom_right, num_nodes, speed);
+
+    case VAST_MOVEMENT_CLUSTER:
+        return new ClusterMovement (top_left, bottom_right, num_nodes, speed);
+
+    case VAST_MOVEMENT_GROUP:
+        return new GroupMovement (top_left, bottom_right, num_nodes, speed);
+
+    default:
+        return NULL;
+    }
+}
+
 Position *MovementGenerator::getPos (int node, int step)
 {
     static Position pos;
@@ -228,6 +309,19 @@ Position *MovementGenerator::getPos (int node, int step)
     // return failure if the model wasn't initialized
     if (_num_nodes == 0 || node >= _num_nodes || step > _num_steps)
         return NULL;
+
+    // read directly from the mapped trace
+    if (_trace != NULL && _trace->getNodeSize () > 0)
+    {
+        const MoveCoord *coord = _trace->getCoord (node, step);
+        if (coord == NULL)
+            return NULL;
+
+        pos.x = (coord_t)coord->x;
+        pos.y = (coord_t)coord->y;
+        pos.z = 0;
+        return &pos;
+    }
     else        
     {
         pos.x = (coord_t)((*__pos_list)[node][step]).x;
@@ -0,0 +1,228 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "MovementTrace.h"
+
+#include "ace/Mem_Map.h"
+
+namespace Vast
+{
+
+MovementTrace::MovementTrace ()
+    :_map (NULL), _base (NULL), _index (NULL), _fp (NULL), _written (0)
+{
+    memset (&_header, 0, sizeof (MovementTraceHeader));
+    _offsets  = new vector<uint64_t>;
+    _filename = new string;
+}
+
+MovementTrace::~MovementTrace ()
+{
+    close ();
+    delete _offsets;
+    delete _filename;
+}
+
+// start writing a new trace file
+bool
+MovementTrace::create (const char *filename, int num_nodes, int num_steps, int width, int height)
+{
+    errout eo;
+
+    close ();
+
+    if (num_nodes <= 0 || num_steps < 0)
+        return false;
+
+    *_filename = filename;
+    string temp = *_filename + MOVEMENT_TRACE_TEMP;
+
+    if ((_fp = fopen (temp.c_str (), "wb")) == NULL)
+    {
+        eo.output ("MovementTrace: cannot create trace file.\n");
+        return false;
+    }
+
+    memset (&_header, 0, sizeof (MovementTraceHeader));
+    _header.version   = MOVEMENT_TRACE_VERSION;
+    _header.num_nodes = (uint32_t)num_nodes;
+    _header.num_steps = (uint32_t)num_steps;
+    _header.width     = (uint32_t)width;
+    _header.height    = (uint32_t)height;
+
+    // header without magic, filled in by finish ()
+    if (fwrite (&_header, sizeof (MovementTraceHeader), 1, _fp) != 1)
+    {
+        eo.output ("MovementTrace: writing header failed.\n");
+        close ();
+        return false;
+    }
+
+    _written = sizeof (MovementTraceHeader);
+    _offsets->clear ();
+    _offsets->reserve (num_steps + 1);
+
+    return true;
+}
+
+// append positions of all nodes for the next step
+bool
+MovementTrace::writeStep (const MoveCoord *coords)
+{
+    if (_fp == NULL || _offsets->size () > _header.num_steps)
+        return false;
+
+    if (fwrite (coords, sizeof (MoveCoord), _header.num_nodes, _fp) != _header.num_nodes)
+    {
+        errout eo;
+        eo.output ("MovementTrace: writing positions failed.\n");
+        return false;
+    }
+
+    _offsets->push_back (_written);
+    _written += sizeof (MoveCoord) * _header.num_nodes;
+
+    return true;
+}
+
+// write the index & header, the trace is usable only after this
+bool
+MovementTrace::finish ()
+{
+    errout eo;
+
+    if (_fp == NULL)
+        return false;
+
+    if (_offsets->size () != _header.num_steps + 1)
+    {
+        eo.output ("MovementTrace: finish (): not all steps are written.\n");
+        close ();
+        return false;
+    }
+
+    // align the index so it can be read in place
+    char padding[sizeof (uint64_t)] = {0};
+    size_t pad = (size_t)((sizeof (uint64_t) - _written % sizeof (uint64_t)) % sizeof (uint64_t));
+
+    _header.index_offset = _written + pad;
+    memcpy (_header.magic, MOVEMENT_TRACE_MAGIC, 4);
+
+    bool success = (fwrite (padding, 1, pad, _fp) == pad &&
+                    fwrite (&(*_offsets)[0], sizeof (uint64_t), _offsets->size (), _fp) == _offsets->size () &&
+                    fseek (_fp, 0, SEEK_SET) == 0 &&
+                    fwrite (&_header, sizeof (MovementTraceHeader), 1, _fp) == 1);
+
+    if (fclose (_fp) != 0)
+        success = false;
+    _fp = NULL;
+    _offsets->clear ();
+
+    // replace any previous trace of the same name
+    string temp = *_filename + MOVEMENT_TRACE_TEMP;
+    if (success)
+    {
+        remove (_filename->c_str ());
+        success = (rename (temp.c_str (), _filename->c_str ()) == 0);
+    }
+    else
+        remove (temp.c_str ());
+
+    if (success == false)
+        eo.output ("MovementTrace: finish (): writing index failed.\n");
+
+    return success;
+}
+
+// map an existing trace file for reading
+bool
+MovementTrace::open (const char *filename)
+{
+    close ();
+
+    ACE_Mem_Map *map = new ACE_Mem_Map;
+    if (map->map (ACE_TEXT_CHAR_TO_TCHAR (filename), -1, O_RDONLY, ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_PRIVATE) != 0 ||
+        map->size () < sizeof (MovementTraceHeader))
+    {
+        delete map;
+        return false;
+    }
+
+    const char *base = (const char *)map->addr ();
+    memcpy (&_header, base, sizeof (MovementTraceHeader));
+
+    // check the header & that the index & all steps lie within the file
+    uint64_t size       = (uint64_t)map->size ();
+    uint64_t steps      = (uint64_t)_header.num_steps + 1;
+    uint64_t step_size  = (uint64_t)_header.num_nodes * sizeof (MoveCoord);
+
+    bool valid = (memcmp (_header.magic, MOVEMENT_TRACE_MAGIC, 4) == 0 &&
+                  _header.version == MOVEMENT_TRACE_VERSION &&
+                  _header.index_offset % sizeof (uint64_t) == 0 &&
+                  _header.index_offset + steps * sizeof (uint64_t) <= size);
+
+    const uint64_t *index = (const uint64_t *)(base + _header.index_offset);
+    for (uint64_t s = 0; valid && s < steps; s++)
+    {
+        if (index[s] < sizeof (MovementTraceHeader) || index[s] + step_size > _header.index_offset)
+            valid = false;
+    }
+
+    if (valid == false)
+    {
+        errout eo;
+        eo.output ("MovementTrace: open (): invalid or incomplete trace file.\n");
+        memset (&_header, 0, sizeof (MovementTraceHeader));
+        delete map;
+        return false;
+    }
+
+    _map   = map;
+    _base  = base;
+    _index = index;
+
+    return true;
+}
+
+// unmap or abandon the current file
+void
+MovementTrace::close ()
+{
+    if (_map != NULL)
+    {
+        delete (ACE_Mem_Map *)_map;
+        _map   = NULL;
+        _base  = NULL;
+        _index = NULL;
+    }
+
+    // abandon an unfinished trace
+    if (_fp != NULL)
+    {
+        fclose (_fp);
+        _fp = NULL;
+        remove ((*_filename + MOVEMENT_TRACE_TEMP).c_str ());
+    }
+
+    _offsets->clear ();
+    memset (&_header, 0, sizeof (MovementTraceHeader));
+}
+
+} // end namespace Vast
@@ -0,0 +1,118 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  MovementTrace.h -- memory-mapped, step-major movement trace file
+ *
+ *      layout: header | positions of all nodes for step 0 | step 1 | ... | index
+ *      the index holds the file offset of each step, so a position is found
+ *      without reading the file. traces are written one step at a time, so
+ *      neither writing nor reading needs memory in proportion to the trace size.
+ */
+
+#ifndef _VAST_MOVEMENT_TRACE_H
+#define _VAST_MOVEMENT_TRACE_H
+
+#include "Movement.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define MOVEMENT_TRACE_MAGIC        "VMTR"
+#define MOVEMENT_TRACE_VERSION      (1)
+#define MOVEMENT_TRACE_TEMP         ".tmp"      // suffix of a trace being written
+
+using namespace std;
+
+namespace Vast
+{
+
+// file header, the magic is written last so incomplete traces are rejected
+typedef struct
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    num_nodes;
+    uint32_t    num_steps;          // # of steps after the initial positions (num_steps + 1 are stored)
+    uint32_t    width;              // world dimension
+    uint32_t    height;
+    uint64_t    index_offset;       // offset of the step index (num_steps + 1 uint64_t)
+} MovementTraceHeader;
+
+class EXPORT MovementTrace
+{
+public:
+    MovementTrace ();
+    ~MovementTrace ();
+
+    // start writing a new trace file, written to a temporary file until finish ()
+    // so traces already mapped from the same file remain valid
+    bool create (const char *filename, int num_nodes, int num_steps, int width, int height);
+
+    // append positions of all nodes for the next step
+    bool writeStep (const MoveCoord *coords);
+
+    // write the index & header, the trace is usable only after this
+    bool finish ();
+
+    // map an existing trace file for reading
+    bool open (const char *filename);
+
+    // unmap or abandon the current file
+    void close ();
+
+    // position of a node at a step (both begin from 0), NULL if out of range
+    inline const MoveCoord *getCoord (int node, int step) const
+    {
+        if (_base == NULL || node < 0 || step < 0 || (uint32_t)node >= _header.num_nodes || (uint32_t)step > _header.num_steps)
+            return NULL;
+
+        return (const MoveCoord *)(_base + _index[step]) + node;
+    }
+
+    int getNodeSize () const
+    {
+        return (int)_header.num_nodes;
+    }
+
+    int getStepSize () const
+    {
+        return (int)_header.num_steps;
+    }
+
+private:
+
+    MovementTraceHeader _header;
+
+    // reading
+    void *              _map;           // ACE_Mem_Map of the file
+    const char *        _base;          // start of the mapped file
+    const uint64_t *    _index;         // offset of each step
+
+    // writing
+    FILE *              _fp;
+    string *            _filename;      // final name of the file being written
+    vector<uint64_t> *  _offsets;       // offset of each step written
+    uint64_t            _written;       // current size of the file
+};
+
+} // end namespace Vast
+
+#endif /* _VAST_MOVEMENT_TRACE_H */
@@ -0,0 +1,239 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "Profiler.h"
+#include "VASTUtil.h"           // TimeMonitor
+
+#include "ace/Thread_Mutex.h"
+#include "ace/Guard_T.h"
+
+namespace Vast {
+
+static const char *g_section_names[PROFILE_SECTION_SIZE] =
+{
+    "tick",
+    "net_process",
+    "messages",
+    "post_handling",
+    "net_flush",
+    "callback"
+};
+
+Profiler::Profiler ()
+    : _enabled (false)
+{
+    _mutex = new ACE_Thread_Mutex;
+}
+
+Profiler::~Profiler ()
+{
+    delete (ACE_Thread_Mutex *)_mutex;
+}
+
+// turn recording on / off, existing records are kept
+void
+Profiler::setEnabled (bool enabled)
+{
+    _enabled = enabled;
+}
+
+// get current time (in microseconds)
+uint64_t
+Profiler::getTime ()
+{
+    return TimeMonitor::instance ()->getTime ();
+}
+
+void
+Profiler::recordSection (ProfileSection section, uint64_t elapsed)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    _sections[section].record (elapsed);
+}
+
+void
+Profiler::recordMessage (id_t group, msgtype_t msgtype, uint64_t elapsed)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    _handlers[group].first.record (elapsed);
+    _msgtypes[pair<id_t, msgtype_t> (group, msgtype)].record (elapsed);
+}
+
+void
+Profiler::recordPostHandling (id_t group, uint64_t elapsed)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    _handlers[group].second.record (elapsed);
+}
+
+void
+Profiler::recordQueueDepth (size_t depth)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    _queue.record (depth);
+}
+
+// clear all records
+void
+Profiler::reset ()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+
+    for (int i=0; i < PROFILE_SECTION_SIZE; i++)
+        _sections[i].reset ();
+    _queue.reset ();
+    _handlers.clear ();
+    _msgtypes.clear ();
+}
+
+bool
+Profiler::getSectionStat (int section, ProfileStat &stat)
+{
+    if (section < 0 || section >= PROFILE_SECTION_SIZE)
+        return false;
+
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    stat = _sections[section];
+    return true;
+}
+
+bool
+Profiler::getQueueStat (ProfileStat &stat)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    stat = _queue;
+    return true;
+}
+
+int
+Profiler::getHandlerSize ()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    return (int)_handlers.size ();
+}
+
+bool
+Profiler::getHandlerStat (int index, id_t &group, ProfileStat &handle, ProfileStat &post)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+
+    if (index < 0 || index >= (int)_handlers.size ())
+        return false;
+
+    map<id_t, pair<ProfileStat, ProfileStat> >::iterator it = _handlers.begin ();
+    for (int i=0; i < index; i++)
+        it++;
+
+    group  = it->first;
+    handle = it->second.first;
+    post   = it->second.second;
+    return true;
+}
+
+int
+Profiler::getMessageTypeSize ()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+    return (int)_msgtypes.size ();
+}
+
+bool
+Profiler::getMessageTypeStat (int index, id_t &group, msgtype_t &msgtype, ProfileStat &stat)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+
+    if (index < 0 || index >= (int)_msgtypes.size ())
+        return false;
+
+    map<pair<id_t, msgtype_t>, ProfileStat>::iterator it = _msgtypes.begin ();
+    for (int i=0; i < index; i++)
+        it++;
+
+    group   = it->first.first;
+    msgtype = it->first.second;
+    stat    = it->second;
+    return true;
+}
+
+const char *
+Profiler::getSectionName (int section)
+{
+    if (section < 0 || section >= PROFILE_SECTION_SIZE)
+        return NULL;
+
+    return g_section_names[section];
+}
+
+// write all stats as JSON
+bool
+Profiler::dump (FILE *fp)
+{
+    if (fp == NULL)
+        return false;
+
+    ACE_Guard<ACE_Thread_Mutex> guard (*(ACE_Thread_Mutex *)_mutex);
+
+    fprintf (fp, "{\"sections\": {");
+    for (int i=0; i < PROFILE_SECTION_SIZE; i++)
+    {
+        fprintf (fp, "%s\"%s\": ", (i == 0 ? "" : ", "), g_section_names[i]);
+        dumpStat (fp, _sections[i]);
+    }
+
+    fprintf (fp, "}, \"queue_depth\": ");
+    dumpStat (fp, _queue);
+
+    fprintf (fp, ", \"handlers\": [");
+    map<id_t, pair<ProfileStat, ProfileStat> >::iterator it = _handlers.begin ();
+    for (; it != _handlers.end (); it++)
+    {
+        fprintf (fp, "%s{\"group\": %llu, \"handle\": ", (it == _handlers.begin () ? "" : ", "), (unsigned long long)it->first);
+        dumpStat (fp, it->second.first);
+        fprintf (fp, ", \"post\": ");
+        dumpStat (fp, it->second.second);
+        fprintf (fp, "}");
+    }
+
+    fprintf (fp, "], \"messages\": [");
+    map<pair<id_t, msgtype_t>, ProfileStat>::iterator it2 = _msgtypes.begin ();
+    for (; it2 != _msgtypes.end (); it2++)
+    {
+        fprintf (fp, "%s{\"group\": %llu, \"type\": %u, \"stat\": ", (it2 == _msgtypes.begin () ? "" : ", "), (unsigned long long)it2->first.first, (unsigned)it2->first.second);
+        dumpStat (fp, it2->second);
+        fprintf (fp, "}");
+    }
+
+    fprintf (fp, "]}\n");
+    fflush (fp);
+
+    return true;
+}
+
+void
+Profiler::dumpStat (FILE *fp, ProfileStat &stat)
+{
+    fprintf (fp, "{\"count\": %llu, \"total\": %llu, \"min\": %llu, \"max\": %llu, \"avg\": %.2f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu}",
+             (unsigned long long)stat.getCount (), (unsigned long long)stat.getTotal (),
+             (unsigned long long)stat.getMinimum (), (unsigned long long)stat.getMaximum (), stat.getAverage (),
+             (unsigned long long)stat.getPercentile (50), (unsigned long long)stat.getPercentile (90),
+             (unsigned long long)stat.getPercentile (99), (unsigned long long)stat.getPercentile (99.9));
+}
+
+} // end namespace Vast
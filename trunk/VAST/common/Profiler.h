@@ -0,0 +1,151 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  Profiler.h -- timing of the parts of a tick (network, handlers, callbacks)
+ *
+ *      each VASTVerse keeps a Profiler that records the time spent in sections of a tick,
+ *      in handleMessage () & postHandling () of each handler, and for each message type,
+ *      together with the depth of the incoming message queue.
+ *
+ *      profiling is off until setEnabled (true), a disabled profiler costs one check per timed scope.
+ *      undefine VAST_PROFILE to remove profiling completely
+ */
+
+#ifndef VAST_PROFILER_H
+#define VAST_PROFILER_H
+
+#include "VASTTypes.h"
+#include "Histogram.h"
+#include <stdio.h>
+#include <map>
+
+#define VAST_PROFILE                        // compile in profiling support (still needs to be enabled at runtime)
+
+using namespace std;
+
+namespace Vast {
+
+// sections of a tick being timed
+typedef enum
+{
+    PROFILE_TICK = 0,           // all of VASTVerse::tick ()
+    PROFILE_NET_PROCESS,        // VASTnet::process () (incoming messages)
+    PROFILE_MESSAGES,           // MessageQueue::processMessages () (all handleMessage () calls)
+    PROFILE_POST_HANDLING,      // postHandling () of all handlers
+    PROFILE_NET_FLUSH,          // VASTnet::flush () (outgoing messages)
+    PROFILE_CALLBACK,           // VASTCallback calls (per-tick, per-second, incoming messages)
+    PROFILE_SECTION_SIZE
+} ProfileSection;
+
+// distribution of a recorded value (time in microseconds, or queue depth)
+typedef Histogram ProfileStat;
+
+class EXPORT Profiler
+{
+public:
+    Profiler ();
+    ~Profiler ();
+
+    // turn recording on / off, existing records are kept
+    void setEnabled (bool enabled);
+
+    bool isEnabled ()
+    {
+#ifdef VAST_PROFILE
+        return _enabled;
+#else
+        return false;
+#endif
+    }
+
+    // get current time (in microseconds)
+    uint64_t getTime ();
+
+    //
+    // recording (called only if enabled)
+    //
+
+    void recordSection (ProfileSection section, uint64_t elapsed);
+    void recordMessage (id_t group, msgtype_t msgtype, uint64_t elapsed);
+    void recordPostHandling (id_t group, uint64_t elapsed);
+    void recordQueueDepth (size_t depth);
+
+    // clear all records
+    void reset ();
+
+    //
+    // queries (stats are copied, so may be called from a thread other than the one ticking)
+    //
+
+    bool getSectionStat (int section, ProfileStat &stat);
+    bool getQueueStat (ProfileStat &stat);
+
+    // handlers are identified by their message group
+    int  getHandlerSize ();
+    bool getHandlerStat (int index, id_t &group, ProfileStat &handle, ProfileStat &post);
+
+    int  getMessageTypeSize ();
+    bool getMessageTypeStat (int index, id_t &group, msgtype_t &msgtype, ProfileStat &stat);
+
+    static const char *getSectionName (int section);
+
+    // write all stats as JSON
+    bool dump (FILE *fp);
+
+private:
+
+    void dumpStat (FILE *fp, ProfileStat &stat);
+
+    bool                                            _enabled;
+    void                                           *_mutex;     // protects stats between recording & query threads
+
+    ProfileStat                                     _sections[PROFILE_SECTION_SIZE];
+    ProfileStat                                     _queue;     // depth of incoming queue at each tick
+    map<id_t, pair<ProfileStat, ProfileStat> >      _handlers;  // handleMessage () & postHandling () time of each handler
+    map<pair<id_t, msgtype_t>, ProfileStat>         _msgtypes;  // handleMessage () time of each message type
+};
+
+// record the time spent in a scope as a section
+class ProfileScope
+{
+public:
+    ProfileScope (Profiler *profiler, ProfileSection section)
+        : _profiler (profiler != NULL && profiler->isEnabled () ? profiler : NULL),
+          _section (section),
+          _start (_profiler != NULL ? _profiler->getTime () : 0)
+    {
+    }
+
+    ~ProfileScope ()
+    {
+        if (_profiler != NULL)
+            _profiler->recordSection (_section, _profiler->getTime () - _start);
+    }
+
+private:
+    Profiler       *_profiler;
+    ProfileSection  _section;
+    uint64_t        _start;
+};
+
+} // end namespace Vast
+
+#endif // VAST_PROFILER_H
@@ -0,0 +1,219 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "RelayForwardQueue.h"
+
+namespace Vast {
+
+    RelayForwardQueue::RelayForwardQueue (size_t limit_per_sub, size_t limit_bytes)
+        :_limit_per_sub (limit_per_sub),
+         _limit_bytes (limit_bytes),
+         _oldest (-1),
+         _newest (-1),
+         _count (0),
+         _bytes (0)
+    {
+    }
+
+    RelayForwardQueue::~RelayForwardQueue ()
+    {
+        clear ();
+    }
+
+    // hold a copy of a message for some subscribers until 'expire'
+    // NOTE: 'expire' is assumed not to decrease between calls (i.e., a fixed time-to-live)
+    int
+    RelayForwardQueue::push (const Message &msg, const vector<id_t> &subs, timestamp_t expire)
+    {
+        if (subs.size () == 0)
+            return 0;
+
+        size_t bytes = sizeof (Message) + msg.size;
+
+        // make room by dropping the oldest entries
+        while (_count > 0 && _bytes + bytes > _limit_bytes)
+            removeHead (_entries[_oldest].sub_id);
+
+        PendingForward *fwd = new PendingForward (new Message (msg), bytes);
+        _bytes += bytes;
+
+        // hold the message while queuing, as it may be dropped again from a full queue
+        fwd->refcount++;
+
+        for (size_t i=0; i < subs.size (); i++)
+        {
+            // a subscriber's queue is full, drop its oldest message
+            map<id_t, SubQueue>::iterator it = _queues.find (subs[i]);
+            if (it != _queues.end () && it->second.count >= _limit_per_sub)
+                removeHead (subs[i]);
+
+            int index;
+            if (_free.size () > 0)
+            {
+                index = _free.back ();
+                _free.pop_back ();
+            }
+            else
+            {
+                index = (int)_entries.size ();
+                _entries.push_back (Entry ());
+            }
+
+            Entry &entry    = _entries[index];
+            entry.fwd       = fwd;
+            entry.sub_id    = subs[i];
+            entry.expire    = expire;
+            entry.sub_next  = -1;
+            entry.all_prev  = _newest;
+            entry.all_next  = -1;
+
+            SubQueue &queue = _queues[subs[i]];
+            if (queue.head == -1)
+                queue.head = index;
+            else
+                _entries[queue.tail].sub_next = index;
+            queue.tail = index;
+            queue.count++;
+
+            if (_newest == -1)
+                _oldest = index;
+            else
+                _entries[_newest].all_next = index;
+            _newest = index;
+
+            fwd->refcount++;
+            _count++;
+        }
+
+        release (fwd);
+
+        return (int)subs.size ();
+    }
+
+    // take out all messages held for a subscriber, in the order they're pushed
+    size_t
+    RelayForwardQueue::pop (id_t sub_id, vector<PendingForward *> &list)
+    {
+        map<id_t, SubQueue>::iterator it = _queues.find (sub_id);
+        if (it == _queues.end ())
+            return 0;
+
+        size_t n = 0;
+        int index = it->second.head;
+        while (index != -1)
+        {
+            int next = _entries[index].sub_next;
+
+            // the entry's reference to the message is passed to the caller
+            list.push_back (_entries[index].fwd);
+            freeEntry (index);
+            n++;
+
+            index = next;
+        }
+
+        _queues.erase (it);
+
+        return n;
+    }
+
+    // give back a message taken out by pop ()
+    void
+    RelayForwardQueue::release (PendingForward *fwd)
+    {
+        if (--fwd->refcount > 0)
+            return;
+
+        _bytes -= fwd->bytes;
+        delete fwd->msg;
+        delete fwd;
+    }
+
+    // remove messages expired at 'now'
+    size_t
+    RelayForwardQueue::expire (timestamp_t now)
+    {
+        size_t n = 0;
+
+        // entries expire in arrival order, so the oldest entry is the head of its subscriber's queue
+        while (_oldest != -1 && now > _entries[_oldest].expire)
+        {
+            removeHead (_entries[_oldest].sub_id);
+            n++;
+        }
+
+        return n;
+    }
+
+    // remove all messages
+    void
+    RelayForwardQueue::clear ()
+    {
+        while (_oldest != -1)
+            removeHead (_entries[_oldest].sub_id);
+
+        _entries.clear ();
+        _free.clear ();
+    }
+
+    // remove the first entry of a subscriber's queue
+    void
+    RelayForwardQueue::removeHead (id_t sub_id)
+    {
+        map<id_t, SubQueue>::iterator it = _queues.find (sub_id);
+        if (it == _queues.end ())
+            return;
+
+        SubQueue &queue = it->second;
+        int index = queue.head;
+
+        PendingForward *fwd = _entries[index].fwd;
+        queue.head = _entries[index].sub_next;
+        queue.count--;
+
+        freeEntry (index);
+        release (fwd);
+
+        if (queue.head == -1)
+            _queues.erase (it);
+    }
+
+    // unlink an entry from the list of all entries & recycle it
+    void
+    RelayForwardQueue::freeEntry (int index)
+    {
+        Entry &entry = _entries[index];
+
+        if (entry.all_prev == -1)
+            _oldest = entry.all_next;
+        else
+            _entries[entry.all_prev].all_next = entry.all_next;
+
+        if (entry.all_next == -1)
+            _newest = entry.all_prev;
+        else
+            _entries[entry.all_next].all_prev = entry.all_prev;
+
+        entry.fwd = NULL;
+        _free.push_back (index);
+        _count--;
+    }
+
+} // end namespace Vast
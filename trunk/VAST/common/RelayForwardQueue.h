@@ -0,0 +1,143 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  RelayForwardQueue.h -- messages a relay holds for subscribers whose client host is not yet known
+ *
+ *      a message addressed to several unknown subscribers is stored once & shared.
+ *      each subscriber has its own queue, and all queued entries are also linked in
+ *      arrival order, as every entry lives for the same time-to-live the oldest entry
+ *      is always the first to expire. memory is bounded per subscriber & in total,
+ *      the oldest entries are dropped when a bound is exceeded.
+ */
+
+#ifndef VAST_RELAY_FORWARD_QUEUE_H
+#define VAST_RELAY_FORWARD_QUEUE_H
+
+#include "VASTTypes.h"
+#include <vector>
+#include <map>
+
+#define RELAY_FORWARD_LIMIT_PER_SUB     (64)                // max # of messages held for one subscriber
+#define RELAY_FORWARD_LIMIT_BYTES       (4 * 1024 * 1024)   // max # of bytes of messages held in total
+
+using namespace std;
+
+namespace Vast {
+
+// a message held for one or more subscribers
+class PendingForward
+{
+public:
+    PendingForward (Message *m, size_t b)
+        :msg (m), bytes (b), refcount (0)
+    {
+    }
+
+    Message    *msg;
+    size_t      bytes;      // memory accounted for the message
+    int         refcount;   // # of subscriber queues holding the message
+};
+
+class EXPORT RelayForwardQueue
+{
+
+public:
+    RelayForwardQueue (size_t limit_per_sub = RELAY_FORWARD_LIMIT_PER_SUB, size_t limit_bytes = RELAY_FORWARD_LIMIT_BYTES);
+    ~RelayForwardQueue ();
+
+    // hold a copy of a message for some subscribers until 'expire'
+    // returns the # of subscribers the message is held for
+    int push (const Message &msg, const vector<id_t> &subs, timestamp_t expire);
+
+    // take out all messages held for a subscriber, in the order they're pushed
+    // NOTE: each message taken out must be given back via release ()
+    size_t pop (id_t sub_id, vector<PendingForward *> &list);
+
+    // give back a message taken out by pop (), it's deleted when no longer held by any subscriber
+    void release (PendingForward *fwd);
+
+    // remove messages expired at 'now', returns the # of entries removed
+    size_t expire (timestamp_t now);
+
+    // remove all messages
+    void clear ();
+
+    // # of (subscriber, message) entries held
+    size_t size ()
+    {
+        return _count;
+    }
+
+    // # of bytes of messages held
+    size_t getBytes ()
+    {
+        return _bytes;
+    }
+
+private:
+
+    // an entry of a message in a subscriber's queue, linked both in the subscriber's queue
+    // & in the list of all entries in arrival order (which is also the order of expiry)
+    class Entry
+    {
+    public:
+        PendingForward *fwd;
+        id_t            sub_id;
+        timestamp_t     expire;
+        int             sub_next;
+        int             all_prev;
+        int             all_next;
+    };
+
+    class SubQueue
+    {
+    public:
+        SubQueue ()
+            :head (-1), tail (-1), count (0)
+        {
+        }
+
+        int     head;
+        int     tail;
+        size_t  count;
+    };
+
+    // remove the first entry of a subscriber's queue
+    void removeHead (id_t sub_id);
+
+    // unlink an entry from the list of all entries & recycle it
+    void freeEntry (int index);
+
+    size_t                  _limit_per_sub;
+    size_t                  _limit_bytes;
+
+    vector<Entry>           _entries;       // entry pool
+    vector<int>             _free;          // unused entries in the pool
+    map<id_t, SubQueue>     _queues;        // queue of each subscriber with entries
+    int                     _oldest;        // first entry in arrival order
+    int                     _newest;        // last entry in arrival order
+    size_t                  _count;
+    size_t                  _bytes;
+};
+
+} // end namespace Vast
+
+#endif // VAST_RELAY_FORWARD_QUEUE_H
@@ -0,0 +1,212 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "SpatialGrid.h"
+#include <algorithm>    // sort, nth_element
+#include <math.h>       // floor
+#include <stdlib.h>     // abs
+
+namespace Vast {
+
+SpatialGrid::SpatialGrid (coord_t cell_size)
+    : _cell_size (cell_size > 0 ? cell_size : SPATIAL_GRID_CELL_SIZE)
+{
+}
+
+SpatialGrid::~SpatialGrid ()
+{
+}
+
+// insert a point, or move it if it already exists
+void
+SpatialGrid::update (id_t id, const Position &pos)
+{
+    map<id_t, Position>::iterator it = _points.find (id);
+
+    if (it != _points.end ())
+    {
+        // no need to re-hash if the point stays in the same cell
+        if (getCell (it->second) == getCell (pos))
+        {
+            it->second = pos;
+            return;
+        }
+        remove (id);
+    }
+
+    _points[id] = pos;
+    _cells[getCell (pos)].push_back (id);
+}
+
+// remove a point, returns false if the point does not exist
+bool
+SpatialGrid::remove (id_t id)
+{
+    map<id_t, Position>::iterator it = _points.find (id);
+    if (it == _points.end ())
+        return false;
+
+    map<cell_t, vector<id_t> >::iterator it_cell = _cells.find (getCell (it->second));
+    if (it_cell != _cells.end ())
+    {
+        vector<id_t> &list = it_cell->second;
+        vector<id_t>::iterator it_id = std::find (list.begin (), list.end (), id);
+        if (it_id != list.end ())
+        {
+            *it_id = list.back ();
+            list.pop_back ();
+        }
+
+        if (list.size () == 0)
+            _cells.erase (it_cell);
+    }
+
+    _points.erase (it);
+    return true;
+}
+
+// remove all points
+void
+SpatialGrid::clear ()
+{
+    _points.clear ();
+    _cells.clear ();
+}
+
+// find up to k points closest to a position, sorted by distance (then by ID)
+// returns the # of points found
+int
+SpatialGrid::getNearest (const Position &pos, int k, vector<id_t> &list)
+{
+    list.clear ();
+
+    if (k <= 0 || _points.size () == 0)
+        return 0;
+
+    if ((size_t)k > _points.size ())
+        k = (int)_points.size ();
+
+    vector<pair<coord_t, id_t> > candidates;
+    cell_t center = getCell (pos);
+
+    // visit rings of cells around the query point, until the k-th closest found
+    // is no further than any point in the unvisited cells could be
+    for (int r = 0; ; r++)
+    {
+        // if the ring has more cells than are occupied, scanning the remaining cells is cheaper
+        if ((size_t)(8 * r) > _cells.size ())
+        {
+            for (map<cell_t, vector<id_t> >::iterator it = _cells.begin (); it != _cells.end (); it++)
+            {
+                int dx = abs (it->first.first - center.first);
+                int dy = abs (it->first.second - center.second);
+                if ((dx > dy ? dx : dy) >= r)
+                    collect (it->first, pos, candidates);
+            }
+            break;
+        }
+
+        for (int dx = -r; dx <= r; dx++)
+        {
+            // only the cells on the ring's border (all cells of the top & bottom rows)
+            int step = (dx == -r || dx == r) ? 1 : 2 * r;
+            for (int dy = -r; dy <= r; dy += step)
+                collect (cell_t (center.first + dx, center.second + dy), pos, candidates);
+        }
+
+        if (candidates.size () == _points.size ())
+            break;
+
+        // any point outside the visited cells is at least r cells away
+        if (candidates.size () >= (size_t)k)
+        {
+            nth_element (candidates.begin (), candidates.begin () + (k - 1), candidates.end ());
+            if (candidates[k - 1].first <= r * _cell_size)
+                break;
+        }
+    }
+
+    sort (candidates.begin (), candidates.end ());
+
+    for (int i = 0; i < k; i++)
+        list.push_back (candidates[i].second);
+
+    return k;
+}
+
+// find all points within a radius of a position, sorted by distance (then by ID)
+// returns the # of points found
+int
+SpatialGrid::getWithin (const Position &pos, length_t radius, vector<id_t> &list)
+{
+    list.clear ();
+
+    if (_points.size () == 0 || radius < 0)
+        return 0;
+
+    vector<pair<coord_t, id_t> > candidates;
+
+    cell_t min_cell = getCell (Position (pos.x - radius, pos.y - radius));
+    cell_t max_cell = getCell (Position (pos.x + radius, pos.y + radius));
+
+    double num_cells = ((double)max_cell.first - min_cell.first + 1) * ((double)max_cell.second - min_cell.second + 1);
+
+    // for large radius, go through occupied cells instead
+    if (num_cells > (double)_cells.size ())
+    {
+        for (map<cell_t, vector<id_t> >::iterator it = _cells.begin (); it != _cells.end (); it++)
+            collect (it->first, pos, candidates);
+    }
+    else
+    {
+        for (int x = min_cell.first; x <= max_cell.first; x++)
+            for (int y = min_cell.second; y <= max_cell.second; y++)
+                collect (cell_t (x, y), pos, candidates);
+    }
+
+    sort (candidates.begin (), candidates.end ());
+
+    for (size_t i = 0; i < candidates.size () && candidates[i].first <= radius; i++)
+        list.push_back (candidates[i].second);
+
+    return (int)list.size ();
+}
+
+// get the cell a position falls in
+SpatialGrid::cell_t
+SpatialGrid::getCell (const Position &pos)
+{
+    return cell_t ((int)floor (pos.x / _cell_size), (int)floor (pos.y / _cell_size));
+}
+
+// collect distances of all points in a cell into candidate list
+void
+SpatialGrid::collect (const cell_t &cell, const Position &pos, vector<pair<coord_t, id_t> > &candidates)
+{
+    map<cell_t, vector<id_t> >::iterator it = _cells.find (cell);
+    if (it == _cells.end ())
+        return;
+
+    vector<id_t> &ids = it->second;
+    for (size_t i = 0; i < ids.size (); i++)
+        candidates.push_back (pair<coord_t, id_t> (_points[ids[i]].distance (pos), ids[i]));
+}
+
+} // end namespace Vast
@@ -0,0 +1,89 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  SpatialGrid.h -- uniform grid index over 2D points
+ *
+ *      points are hashed into square cells, so nearest-k and radius queries only
+ *      visit the cells around the query point instead of all points.
+ *      used by VASTRelay to index relays by their physical (Vivaldi) coordinates
+ */
+
+#ifndef VAST_SPATIAL_GRID_H
+#define VAST_SPATIAL_GRID_H
+
+#include "VASTTypes.h"
+#include <vector>
+#include <map>
+
+#define SPATIAL_GRID_CELL_SIZE      (50)    // default width of a cell (in Vivaldi space, about 50 ms)
+
+using namespace std;
+
+namespace Vast {
+
+class EXPORT SpatialGrid
+{
+
+public:
+    SpatialGrid (coord_t cell_size = SPATIAL_GRID_CELL_SIZE);
+    ~SpatialGrid ();
+
+    // insert a point, or move it if it already exists
+    void update (id_t id, const Position &pos);
+
+    // remove a point, returns false if the point does not exist
+    bool remove (id_t id);
+
+    // remove all points
+    void clear ();
+
+    // get the number of points currently indexed
+    size_t size ()
+    {
+        return _points.size ();
+    }
+
+    // find up to k points closest to a position, sorted by distance (then by ID)
+    // returns the # of points found
+    int getNearest (const Position &pos, int k, vector<id_t> &list);
+
+    // find all points within a radius of a position, sorted by distance (then by ID)
+    // returns the # of points found
+    int getWithin (const Position &pos, length_t radius, vector<id_t> &list);
+
+private:
+
+    typedef pair<int, int> cell_t;
+
+    // get the cell a position falls in
+    cell_t getCell (const Position &pos);
+
+    // collect distances of all points in a cell into candidate list
+    void collect (const cell_t &cell, const Position &pos, vector<pair<coord_t, id_t> > &candidates);
+
+    coord_t                         _cell_size;     // width of a cell
+    map<id_t, Position>             _points;        // position of each point
+    map<cell_t, vector<id_t> >      _cells;         // points within each non-empty cell
+};
+
+} // end namespace Vast
+
+#endif // VAST_SPATIAL_GRID_H
@@ -35,6 +35,7 @@
 #include "VASTTypes.h"
 #include "Voronoi.h"
 #include "MessageHandler.h"
+#include "Histogram.h"
 
 using namespace std;
 
@@ -78,6 +79,13 @@ namespace Vast
         RELAY_QUERY_R,          // response to closest relay query
         RELAY_JOIN,             // attach to the physically closest relay
         RELAY_JOIN_R,           // response to JOIN request
+        RELAY_FANOUT,           // message for subscribers at many relays, to be sent along a tree of relays
+        RELAY_FANOUT_TREE,      // message passed down a tree of relays, with the receiving relay's subtree
+        RELAY_FANOUT_FAILED,    // subscribers of a fan-out tree whose relay cannot be reached (to the sending matcher)
+
+        // Client-specific messages (appended to keep existing message types unchanged)
+        NEIGHBOR_DIRECT,        // matcher authorizing / revoking direct updates between neighbors
+        NEIGHBOR_MOVE,          // position update sent directly to an authorized neighbor
 
     } VAST_Message;
 
@@ -195,6 +203,9 @@ namespace Vast
         // get message latencies, currently support PUBLISH & MOVE
         // msgtype == 0 indicates clear up existing latency records
         virtual StatType *getMessageLatency (msgtype_t msgtype) = 0;
+
+        // get distribution of message latencies (for percentiles), NULL if not yet recorded
+        virtual Histogram *getLatencyHistogram (msgtype_t msgtype) = 0;
     };
 
 } // end namespace Vast
@@ -38,6 +38,8 @@
 #include "VASTTypes.h"
 #include "MessageHandler.h"
 #include "VAST.h"               // for VASTMessage
+#include "SpatialGrid.h"        // for indexing relays by physical coordinate
+#include "RelayForwardQueue.h"  // for messages to subscribers not yet mapped to clients
 //#include "Vivaldi.h"
 
 // number of seconds before a new round of queries is sent for neighbors' coordinates
@@ -60,6 +62,13 @@ const int MAX_CONCURRENT_PING = 5;
 // maximum number of queries sent to obtain new physical coordinate
 const int MAX_RELAY_QUERIES     = 5;
 
+// number of relays each relay forwards to in a fan-out tree
+const int RELAY_FANOUT_DEGREE   = 4;
+
+// number of recent RTT samples kept for each peer, the smallest one is used for coordinate update
+// (so samples inflated by queueing delay are filtered out)
+const int RELAY_RTT_WINDOW      = 4;
+
 // NOTE the below parameters need to be fine-tuned & tested
 //      currently local tests reveal that it'll take about 3-7 ping-pong to converge a physical coordinate upon join (~ 2 seconds)
 #define RELAY_CONSTANT_ERROR      (0.7f)     // affects how heavy the local error will count in updating the local error (moving average) 
@@ -89,6 +98,53 @@ namespace Vast
     } RELAY_Message;
     */
 
+    // recent round-trip times to a peer
+    class RTTFilter
+    {
+    public:
+        RTTFilter ()
+            :count (0), next (0), last_sample (0)
+        {
+        }
+
+        // add a sample, returns the filtered RTT
+        float add (float rtt, timestamp_t now)
+        {
+            samples[next] = rtt;
+            next = (next + 1) % RELAY_RTT_WINDOW;
+            if (count < RELAY_RTT_WINDOW)
+                count++;
+            last_sample = now;
+
+            float filtered = samples[0];
+            for (int i=1; i < count; i++)
+                if (samples[i] < filtered)
+                    filtered = samples[i];
+
+            return filtered;
+        }
+
+        float       samples[RELAY_RTT_WINDOW];
+        int         count;          // # of valid samples
+        int         next;           // position for the next sample
+        timestamp_t last_sample;    // time of the last sample
+    };
+
+    // a relay & the subscribers it delivers to in a fan-out tree, 
+    // a tree is listed in pre-order & 'subtree' is the # of relays in the subtree rooted at this relay
+    class RelayFanoutNode
+    {
+    public:
+        RelayFanoutNode ()
+            :subtree (1)
+        {
+        }
+
+        Addr            relay;
+        uint32_t        subtree;
+        vector<id_t>    targets;
+    };
+
     // this is an export class so physical coordinates can be obtained externally
     class EXPORT VASTRelay : public MessageHandler
     {
@@ -116,6 +172,16 @@ namespace Vast
         // get size of clients connected
         int getClientSize ();
 
+        // obtain the error estimate of my physical coordinate (relative error, 0 is perfect)
+        float getCoordinateError ();
+
+        // append relays of a fan-out tree (nodes [first, first + count)) to the end of a message,
+        // 'origin' is the host of the sending matcher, to be notified of unreachable relays
+        static bool storeFanout (Message &msg, Addr &origin, vector<RelayFanoutNode> &nodes, size_t first, size_t count);
+
+        // remove relays of a fan-out tree from the end of a message
+        static bool extractFanout (Message &msg, Addr &origin, vector<RelayFanoutNode> &nodes);
+
     private:
 
         // perform initialization tasks for this handler (optional)
@@ -175,10 +241,30 @@ namespace Vast
         // remove a client no longer connected
         void removeClient (id_t id);
 
-        // forward a message meant for client 'sub_id', to an actual client host
-        // if host_id is not provided then the message is simply removed
-        // returns the number of processed messages (forward or delete)
-        int forwardMessage (id_t sub_id, id_t host_id = NET_ID_UNASSIGNED);
+        // forward messages held for client 'sub_id', to an actual client host
+        // returns the number of forwarded messages
+        int forwardMessage (id_t sub_id, id_t host_id);
+
+        // deliver a message to the clients of its targets (subscription IDs)
+        bool deliverMessage (Message &msg, msgtype_t app_msgtype);
+
+        //
+        //  fan-out tree
+        //
+
+        // turn a list of relays (each with its subscribers) into a tree rooted at myself
+        void buildFanoutTree (vector<RelayFanoutNode> &nodes);
+
+        // add 'members' (indices of 'nodes') as the subtrees of a relay at 'center'
+        void addFanoutChildren (vector<RelayFanoutNode> &nodes, vector<size_t> &members, const Position &center, vector<RelayFanoutNode> &tree);
+
+        // physical coordinate of a known relay, returns false if unknown
+        bool getRelayCoordinate (id_t id, Position &coord);
+
+        // send a message down to the subtree rooted at nodes[i], 
+        // the children are sent to directly if the relay cannot be reached
+        void sendFanout (Message &msg, msgtype_t app_msgtype, Addr &origin, vector<RelayFanoutNode> &nodes, size_t i);
+
 
         //
         //  physical coordinate discovery
@@ -187,6 +273,12 @@ namespace Vast
         // send a message to a remote host in order to obtain round-trip time
         bool ping (bool curr_relay_only = false);
 
+        // # of relays to PING in a round, a single one once joined
+        int getSampleSize ();
+
+        // time between rounds of PING once joined, longer as my coordinate error gets smaller
+        timestamp_t getSamplePeriod ();
+
         // response to a PING message
         bool pong (id_t target, timestamp_t querytime, bool first = false);
 
@@ -218,12 +310,15 @@ namespace Vast
         timestamp_t _timeout_ping;      // countdown counter to send query
         timestamp_t _timeout_query;     // timeout for querying the initial relay
         timestamp_t _timeout_join;      // timeout for joining a relay
+        timestamp_t _timeout_sample;    // time for the next round of PING to refine my coordinate (once joined)
         int         _ping_all_count;    // whether to ping all relays
 
         int         _request_times;     // # of times we've sent out PING requests
 
         map<id_t, Node> _relays;        // list of contact neighbors
         multimap<double, Node *> _dist2relay;    // pointers to known relays (neighbors or otherwise), listed / queried by distance        
+        map<id_t, multimap<double, Node *>::iterator> _relay2dist;  // position of each relay in _dist2relay
+        SpatialGrid     _relay_grid;    // known relays indexed by physical coordinate, for closest relay queries
         
         map<id_t, Node> _clients;       // list of accepted clients to this relay
         map<id_t, id_t> _sub2client;    // mapping from subscription ID to client's hostID
@@ -232,9 +327,12 @@ namespace Vast
         size_t          _client_limit;  // number of clients I can accomodate, could vary depending on load
 
         map<id_t, timestamp_t> _pending; // list of pending PING requests sent & sent time
+        map<id_t, RTTFilter> _rtt;      // recent RTT samples to each peer (from my PING or theirs)
         
-        multimap<id_t, Message *> _queue;    // forward messages that can yet be sent (mapping not yet received)
-        map<id_t, timestamp_t> _queue_time;  // time a particular message is queued
+        RelayForwardQueue _queue;       // forward messages that can't yet be sent (mapping not yet received)
+        vector<PendingForward *> _forwards;  // buffer for messages taken out of _queue
+        vector<RelayFanoutNode>  _fanout;    // buffer for a received fan-out tree
+        Addr                     _fanout_origin; // sending matcher of a received fan-out tree
 	};
 
 } // namespace Vast
@@ -127,6 +127,10 @@ typedef struct {
     int     PEER_LIMIT;         // max # of peers hosted at each relay
     int     RELAY_LIMIT;        // max # of relays each node keeps
     int     OVERLOAD_LIMIT;     // limit to consider as overloaded
+    int     LATENCY_MODEL;      // emulate latency, bandwidth & jitter (otherwise each message takes one step)
+    int     UPLINK_CAPACITY;    // uplink capacity of each host in the latency model (bytes / sec, 0 for default)
+    int     DOWNLINK_CAPACITY;  // downlink capacity of each host in the latency model (bytes / sec, 0 for default)
+    int     NET_SEED;           // random seed of the emulated network
 } SimPara;
 
 // status on known nodes in the neighbor list, can be either just inserted / deleted / updated
@@ -992,6 +996,8 @@ public:
         in_region = false; 
         time = 0;
         aoi.clear ();
+        phys_coord = Position ();
+        direct_addr = Addr ();
     }
 
     bool addNeighbor (Subscription *neighbor)
@@ -1083,7 +1089,14 @@ public:
     // size of this class
     size_t sizeOf () const
     {
-        return sizeof (id_t) * 2 + sizeof (layer_t) + aoi.sizeOf () + relay.sizeOf ();
+        return sizeof (id_t) * 2 + sizeof (layer_t) + aoi.sizeOf () + relay.sizeOf ()
+#ifdef VAST_DIRECT_NEIGHBORS
+               + direct_addr.sizeOf ()
+#endif
+#ifdef MATCHER_PLACEMENT_LOCALITY
+               + phys_coord.sizeOf ()
+#endif
+               ;
     }
 
     // NOTE that 'active' 'time' flag is not serialized and will be restored as 'false' by default
@@ -1095,7 +1108,13 @@ public:
             memcpy (p, &id, sizeof (id_t));             p += sizeof (id_t);            
             memcpy (p, &layer, sizeof (layer_t));       p += sizeof (layer_t);
             p += aoi.serialize (p);
-            relay.serialize (p);
+            p += relay.serialize (p);
+#ifdef VAST_DIRECT_NEIGHBORS
+            p += direct_addr.serialize (p);
+#endif
+#ifdef MATCHER_PLACEMENT_LOCALITY
+            p += phys_coord.serialize (p);
+#endif
         }
         return sizeOf ();
     }
@@ -1109,7 +1128,13 @@ public:
             memcpy (&id, p, sizeof (id_t));             p += sizeof (id_t);
             memcpy (&layer, p, sizeof (layer_t));       p += sizeof (layer_t);
             p += aoi.deserialize (p, aoi.sizeOf ());
-            relay.deserialize (p, relay.sizeOf ());
+            p += relay.deserialize (p, relay.sizeOf ());
+#ifdef VAST_DIRECT_NEIGHBORS
+            p += direct_addr.deserialize (p, direct_addr.sizeOf ());
+#endif
+#ifdef MATCHER_PLACEMENT_LOCALITY
+            p += phys_coord.deserialize (p, phys_coord.sizeOf ());
+#endif
 
             this->active    = false;
             this->dirty     = false;
@@ -1128,6 +1153,8 @@ public:
     layer_t     layer;          // layer number for the subscription    
     Area        aoi;            // aoi of the subscription (including a center position)
     Addr        relay;          // the address of the relay of the subscriber (to receive messages)
+    Position    phys_coord;     // physical coordinate of the subscriber (empty if unknown)
+    Addr        direct_addr;    // public address of the subscriber's host if neighbors may contact it directly (host_id is 0 otherwise)
 
     // non-serialized components
     bool        active;         // whether the subscription is successful
@@ -1617,6 +1644,12 @@ public:
         return _curr;
     }
 
+    // # of bytes not yet extracted
+    inline size_t remaining () const
+    {
+        return (size_t)(size - (_curr - data));
+    }
+
     // size of this class
     //      currently a fixed overhead of 15 bytes for one target
     size_t sizeOf () const
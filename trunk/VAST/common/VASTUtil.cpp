@@ -28,26 +28,403 @@
 #include "ace/ACE.h"        // ACE_OS::gettimeofday () for TimeMonitor
 //#include "ace/OS.h"
 #include "ace/Task.h"               // for ACE_Thread_Mutex
+#include "ace/TSS_T.h"              // for per-thread log buffers & time budgets
+#include "ace/Atomic_Op.h"
+#include "ace/OS_NS_unistd.h"       // ACE_OS::sleep
 
 #include "stdarg.h"         // taking variable arguments in writeLogFile
+#include <algorithm>        // find
 
 namespace Vast
 {  
 
+//
+// LogRing: buffer of pending log records written by one thread (single producer / single consumer)
+//
+class LogRing
+{
+public:
+    LogRing ()
+        : head (0), tail (0), dropped (0), closed (false)
+    {
+    }
+
+    // store a record, returns false if the buffer is full
+    // NOTE: called only by the owning thread
+    bool push (const char *record, size_t size)
+    {
+        long h = head.value ();
+        if (LOG_RING_SIZE - (unsigned long)(h - tail.value ()) < size)
+            return false;
+
+        copyIn (buffer, (unsigned long)h, record, size);
+
+        // make the record visible to the consumer
+        head = h + (long)size;
+        return true;
+    }
+
+    // extract the next record, returns its size or 0 if no record exists
+    // NOTE: called only by the drain thread
+    size_t pop (char *record)
+    {
+        long t = tail.value ();
+        if (head.value () == t)
+            return 0;
+
+        LogRecordHeader header;
+        copyOut (buffer, (unsigned long)t, (char *)&header, sizeof (LogRecordHeader));
+        copyOut (buffer, (unsigned long)t, record, header.size);
+
+        tail = t + (long)header.size;
+        return header.size;
+    }
+
+    char                                    buffer[LOG_RING_SIZE];
+    ACE_Atomic_Op<ACE_Thread_Mutex, long>   head;       // total bytes written
+    ACE_Atomic_Op<ACE_Thread_Mutex, long>   tail;       // total bytes read
+    ACE_Atomic_Op<ACE_Thread_Mutex, long>   dropped;    // # of records dropped as buffer is full
+    volatile bool                           closed;     // whether the owning thread has ended
+
+private:
+
+    // copy into the buffer at a certain position, wrapping around the end
+    static void copyIn (char *ring, unsigned long pos, const char *data, size_t size)
+    {
+        size_t start = pos & (LOG_RING_SIZE - 1);
+        size_t first = (size < LOG_RING_SIZE - start ? size : LOG_RING_SIZE - start);
+
+        memcpy (ring + start, data, first);
+        memcpy (ring, data + first, size - first);
+    }
+
+    // copy out of the buffer at a certain position, wrapping around the end
+    static void copyOut (const char *ring, unsigned long pos, char *data, size_t size)
+    {
+        size_t start = pos & (LOG_RING_SIZE - 1);
+        size_t first = (size < LOG_RING_SIZE - start ? size : LOG_RING_SIZE - start);
+
+        memcpy (data, ring + start, first);
+        memcpy (data + first, ring, size - first);
+    }
+};
+
+// states kept for each logging thread
+struct LogThreadState
+{
+    LogThreadState ()
+        : ring (NULL)
+    {
+    }
+
+    // ring is released by the drain thread after it's emptied
+    ~LogThreadState ()
+    {
+        if (ring != NULL)
+            ring->closed = true;
+    }
+
+    LogRing                                     *ring;          // pending records of this thread
+    map<const char *, pair<uint32_t, string> >   format_ids;    // cache of format string IDs
+};
+
+//
+// LogBackend: per-thread buffers & the thread writing out records
+//
+class LogBackend : public ACE_Task_Base
+{
+public:
+    LogBackend ()
+        : _active (false), _dropped (0), _file (NULL), _formats_written (0)
+    {
+        ACE::init ();
+    }
+
+    ~LogBackend ()
+    {
+        stop ();
+
+        // NOTE: rings of threads still alive are not released, as their thread states still refer to them
+        for (size_t i=0; i < _rings.size (); i++)
+            if (_rings[i]->closed)
+                delete _rings[i];
+        _rings.clear ();
+
+        ACE::fini ();
+    }
+
+    void start ()
+    {
+#ifdef LOG_ASYNC_DRAIN
+        _active = true;
+        this->activate ();
+#endif
+    }
+
+    void stop ()
+    {
+        if (_active == false)
+            return;
+
+        _active = false;
+        this->wait ();
+    }
+
+    // drain pending records periodically
+    int svc ()
+    {
+        while (_active)
+        {
+            drain ();
+
+            ACE_Time_Value duration (0, LOG_DRAIN_INTERVAL * 1000);
+            ACE_OS::sleep (duration);
+        }
+
+        drain ();
+        return 0;
+    }
+
+    // copy a record into the calling thread's buffer
+    bool write (int level, const char *format, va_list args)
+    {
+        LogThreadState *state = _state;
+
+        if (state->ring == NULL)
+        {
+            state->ring = new LogRing;
+
+            ACE_Guard<ACE_Thread_Mutex> guard (_mutex);
+            _rings.push_back (state->ring);
+        }
+
+        // find format ID, the string is compared in case the same buffer is reused for other formats
+        uint32_t id;
+        map<const char *, pair<uint32_t, string> >::iterator it = state->format_ids.find (format);
+
+        if (it != state->format_ids.end () && it->second.second == format)
+            id = it->second.first;
+        else
+        {
+            id = registerFormat (format);
+            state->format_ids[format] = pair<uint32_t, string> (id, format);
+        }
+
+        char record[LOG_RECORD_MAX_SIZE];
+        LogRecordHeader header;
+        size_t size = sizeof (LogRecordHeader) + BinaryLog::encode (record + sizeof (LogRecordHeader), LOG_RECORD_MAX_SIZE - sizeof (LogRecordHeader), format, args);
+
+        ACE_Time_Value now = ACE_OS::gettimeofday ();
+
+        header.size      = (uint16_t)size;
+        header.level     = (uint8_t)level;
+        header.reserved  = 0;
+        header.format_id = id;
+        header.time      = (uint64_t)now.sec () * MICROSECOND_PERSEC + now.usec ();
+        memcpy (record, &header, sizeof (LogRecordHeader));
+
+        // if the buffer is full, wait until it's written out
+        bool stored = state->ring->push (record, size);
+        if (stored == false)
+        {
+            drain ();
+            if ((stored = state->ring->push (record, size)) == false)
+            {
+                state->ring->dropped++;
+                _dropped++;
+            }
+        }
+
+#ifndef LOG_ASYNC_DRAIN
+        drain ();
+#endif
+
+        return stored;
+    }
+
+    // # of records dropped so far
+    long getDropped ()
+    {
+        return _dropped.value ();
+    }
+
+    // write out all pending records
+    void drain ()
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard (_drain_mutex);
+
+        vector<LogRing *> rings;
+        _mutex.acquire ();
+        rings = _rings;
+        _mutex.release ();
+
+        char record[LOG_RECORD_MAX_SIZE];
+
+        for (size_t i=0; i < rings.size (); i++)
+        {
+            LogRing *ring = rings[i];
+
+            // check before emptying, so no record is added after the check
+            bool closed = ring->closed;
+
+            while (ring->pop (record) > 0)
+                output (record);
+
+            long dropped = ring->dropped.value ();
+            if (dropped > 0)
+            {
+                ring->dropped -= dropped;
+                printf ("LogManager: %ld log records dropped, log buffer full\n", dropped);
+            }
+
+            if (closed)
+            {
+                _mutex.acquire ();
+                _rings.erase (std::find (_rings.begin (), _rings.end (), ring));
+                _mutex.release ();
+                delete ring;
+            }
+        }
+
+        if (_file)
+            fflush (_file);
+        fflush (stdout);
+    }
+
+    // change the file to write records (pending records are written to the previous file)
+    void setFile (FILE *fp)
+    {
+        drain ();
+
+        ACE_Guard<ACE_Thread_Mutex> guard (_drain_mutex);
+        _file = fp;
+        _formats_written = 0;
+
+#ifdef LOG_BINARY_FILE
+        if (_file)
+            fwrite (LOG_FILE_MAGIC, strlen (LOG_FILE_MAGIC), 1, _file);
+#endif
+    }
+
+private:
+
+    // obtain the ID of a format string
+    uint32_t registerFormat (const char *format)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard (_mutex);
+
+        for (size_t i=0; i < _formats.size (); i++)
+            if (_formats[i] == format)
+                return (uint32_t)i;
+
+        _formats.push_back (format);
+        return (uint32_t)(_formats.size () - 1);
+    }
+
+    // write a record to file & stdout
+    void output (char *record)
+    {
+        LogRecordHeader header;
+        memcpy (&header, record, sizeof (LogRecordHeader));
+
+        // obtain newly registered formats
+        if (header.format_id >= _known_formats.size ())
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard (_mutex);
+            for (size_t i = _known_formats.size (); i < _formats.size (); i++)
+                _known_formats.push_back (_formats[i]);
+        }
+
+        if (header.format_id >= _known_formats.size ())
+            return;
+
+        char *args = record + sizeof (LogRecordHeader);
+        size_t length = header.size - sizeof (LogRecordHeader);
+
+        char text[LOG_TEXT_MAX];
+        BinaryLog::decode (text, LOG_TEXT_MAX, _known_formats[header.format_id].c_str (), args, length);
+
+        if (_file)
+        {
+#ifdef LOG_BINARY_FILE
+            // define formats before first use
+            while (_formats_written <= header.format_id)
+            {
+                const string &format = _known_formats[_formats_written];
+
+                LogRecordHeader def;
+                size_t size = format.size ();
+                if (size > LOG_RECORD_MAX_SIZE - sizeof (LogRecordHeader))
+                    size = LOG_RECORD_MAX_SIZE - sizeof (LogRecordHeader);
+
+                def.size      = (uint16_t)(sizeof (LogRecordHeader) + size);
+                def.level     = LOG_LEVEL_FORMAT;
+                def.reserved  = 0;
+                def.format_id = (uint32_t)_formats_written;
+                def.time      = 0;
+
+                fwrite (&def, sizeof (LogRecordHeader), 1, _file);
+                fwrite (format.c_str (), size, 1, _file);
+                _formats_written++;
+            }
+
+            fwrite (record, header.size, 1, _file);
+#else
+            char time[64];
+            BinaryLog::formatTime (time, 64, header.time);
+            fprintf (_file, "[%s] %s\n", time, text);
+#endif
+        }
+
+        // print to stdout
+        printf ("%s\n", text);
+    }
+
+    volatile bool               _active;            // whether the drain thread should continue
+    ACE_Atomic_Op<ACE_Thread_Mutex, long> _dropped;   // # of records dropped in total
+
+    ACE_TSS<LogThreadState>     _state;             // states of each logging thread
+    ACE_Thread_Mutex            _mutex;             // protects ring list & format strings
+    vector<LogRing *>           _rings;             // buffers of all logging threads
+    vector<string>              _formats;           // registered format strings, index is ID
+
+    // used by drain only
+    ACE_Thread_Mutex            _drain_mutex;       // only one drain at a time
+    FILE                       *_file;              // file to write records
+    size_t                      _formats_written;   // # of format strings defined in file
+    vector<string>              _known_formats;     // copy of format strings
+};
+
 // Global static pointer used to ensure a single instance of the class.
 LogManager* LogManager::_instance = NULL; 
 
-// mutex for log file (to avoid contention)
+// mutex for creating the instance
 ACE_Thread_Mutex g_log_mutex;
 
 LogManager* LogManager::instance()
 {
    if (!_instance)   // Only allow one instance of class to be generated.
-      _instance = new LogManager;
+   {
+      g_log_mutex.acquire ();
+      if (!_instance)
+      {
+          _instance = new LogManager;
+          atexit (LogManager::flushAtExit);
+      }
+      g_log_mutex.release ();
+   }
  
    return _instance;
 }
 
+// write out pending records when the process exits without calling terminateInstance ()
+void 
+LogManager::flushAtExit ()
+{
+    if (_instance)
+        _instance->flush ();
+}
+
 void 
 LogManager::terminateInstance ()
 {
@@ -55,6 +432,21 @@ LogManager::terminateInstance ()
         delete _instance;
     _instance = NULL;
 }
+
+LogManager::LogManager ()
+{
+    _logfile = NULL;
+    _level   = LOG_LEVEL_INFO;
+
+    _backend = new LogBackend;
+    _backend->start ();
+}
+
+LogManager::~LogManager ()
+{
+    // remaining records are written out when the drain thread stops
+    delete _backend;
+}
  
 bool LogManager::setLogFile (FILE *fp)
 {
@@ -62,62 +454,68 @@ bool LogManager::setLogFile (FILE *fp)
         return false;
 
     _logfile = fp;
+    _backend->setFile (fp);
     return true;
 }
 
 
-// TODO: make it thread-safe
 // example from:
 // http://www.ozzu.com/cpp-tutorials/tutorial-writing-custom-printf-wrapper-function-t89166.html
 bool LogManager::writeLogFile (const char *format, ...)
 {
-    g_log_mutex.acquire ();
+    if (LOG_LEVEL_INFO < _level)
+        return true;
 
-    // print time
-	time_t rawtime;
-	time (&rawtime);
-	tm *timeinfo = gmtime (&rawtime);
+    va_list args;
+    va_start (args, format);
+    bool result = _backend->write (LOG_LEVEL_INFO, format, args);
+    va_end (args);
 
-    if (_logfile)
-    {
-        // print formatted date/time in string
-        //fprintf (_logfile, "%s: ", asctime (timeinfo)); 
-        // time only
-        fprintf (_logfile, "[GMT %04d/%02d/%02d %02d:%02d:%02d] ", timeinfo->tm_year+1900, timeinfo->tm_mon+1, timeinfo->tm_mday, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
-    }
+    return result;
+}
 
-    if (_logfile)
-    {
-        va_list args;
-        va_start (args, format);
-        vfprintf (_logfile, format, args);
-        va_end (args);
-    }
+// log with a specific level
+bool LogManager::writeLog (int level, const char *format, ...)
+{
+    if (level < _level)
+        return true;
 
-    // print to stdout    
     va_list args;
     va_start (args, format);
-    vfprintf (stdout, format, args);
+    bool result = _backend->write (level, format, args);
     va_end (args);
 
-    if (_logfile)
-    {
-        fprintf (_logfile, "\n");
-        fflush (_logfile);
-    }
-    fprintf (stdout, "\n");
+    return result;
+}
 
-    g_log_mutex.release ();
+void LogManager::setLogLevel (int level)
+{
+    _level = level;
+}
 
-    return true;
+int LogManager::getLogLevel ()
+{
+    return _level;
 }
 
+// write out all pending records
+void LogManager::flush ()
+{
+    _backend->drain ();
+}
+
+// # of records dropped so far (as they could not be buffered)
+long LogManager::getDropped ()
+{
+    return _backend->getDropped ();
+}
 
 bool LogManager::unsetLogFile ()
 {
     if (_logfile == NULL)
         return false;
 
+    _backend->setFile (NULL);
     _logfile = NULL;
     return true;
 }
@@ -125,13 +523,34 @@ bool LogManager::unsetLogFile ()
 
 TimeMonitor* TimeMonitor::_instance = NULL;
 
+// mutex for creating the instance
+ACE_Thread_Mutex g_time_mutex;
+
+// time budget of one thread
+class TimeBudget
+{
+public:
+    TimeBudget ()
+    {
+        budget = 0;
+        start  = 0;
+        first  = false;
+    }
+
+    long long           budget;     // time left in current budget
+    unsigned long long  start;      // start time of setting the budget
+    bool                first;      // budget has just been set
+};
+
 TimeMonitor::TimeMonitor ()
 {
     ACE::init ();
-    _budget = 0;
+    _budgets = new ACE_TSS<TimeBudget>;
+}
 
-    ACE_Time_Value time = ACE_OS::gettimeofday ();
-    _start = (unsigned long long)time.sec () * MICROSECOND_PERSEC + time.usec ();
+TimeMonitor::~TimeMonitor ()
+{
+    delete (ACE_TSS<TimeBudget> *)_budgets;
 }
 
 
@@ -144,45 +563,49 @@ TimeMonitor::setBudget (int time_budget)
         printf ("TimeMonitor::setBudget () budget exceeds 1000 ms, may want to check if this is correct\n");
     }
 
-    _budget = time_budget;
+    TimeBudget *b = *(ACE_TSS<TimeBudget> *)_budgets;
+
+    b->budget = time_budget;
 
     ACE_Time_Value time = ACE_OS::gettimeofday ();
-    _start = (unsigned long long)time.sec () * MICROSECOND_PERSEC + time.usec ();
-    _first = true;
+    b->start = (unsigned long long)time.sec () * MICROSECOND_PERSEC + time.usec ();
+    b->first = true;
 }
 
 // still time available?
 int
 TimeMonitor::available ()
 {
+    TimeBudget *b = *(ACE_TSS<TimeBudget> *)_budgets;
+
     // unlimited budget returns (-1)
-    if (_budget == 0)
+    if (b->budget == 0)
         return (-1);
     // budget already used up, return immediately
-    else if (_budget < 0)
+    else if (b->budget < 0)
         return 0;
 
     // check how much time has elapsed since setBudget was called
     ACE_Time_Value time = ACE_OS::gettimeofday();
 
     unsigned long long current = (unsigned long long)time.sec () * MICROSECOND_PERSEC + time.usec ();
-    long long elapsed = (long long)(current - _start);
+    long long elapsed = (long long)(current - b->start);
 
     //if (elapsed > 0)
-    //    printf ("available (): elapsed %ld budget: %ld\n", (long)elapsed, (long)_budget);
+    //    printf ("available (): elapsed %ld budget: %ld\n", (long)elapsed, (long)b->budget);
 
-    int time_left = (int)(_budget - elapsed);
+    int time_left = (int)(b->budget - elapsed);
 
     if (time_left < 0)
     {
-        printf ("available (): time_left: %d elapsed %ld budget: %ld\n", time_left, (long)elapsed, (long)_budget);
+        printf ("available (): time_left: %d elapsed %ld budget: %ld\n", time_left, (long)elapsed, (long)b->budget);
         time_left = 0;
     }
 
     // we make sure that a positive response is returned at least once per cycle
-    if (_first == true)
+    if (b->first == true)
     {
-        _first = false;
+        b->first = false;
      
         if (time_left == 0)
             time_left = 1;
@@ -191,12 +614,25 @@ TimeMonitor::available ()
     return time_left;
 }
 
+// get current time (in microseconds)
+unsigned long long
+TimeMonitor::getTime ()
+{
+    ACE_Time_Value time = ACE_OS::gettimeofday ();
+    return (unsigned long long)time.sec () * MICROSECOND_PERSEC + time.usec ();
+}
+
 // return a global instance of TimeMonitor
 TimeMonitor *
 TimeMonitor::instance ()
 {
    if (!_instance)   // Only allow one instance of class to be generated.
-      _instance = new TimeMonitor;
+   {
+      g_time_mutex.acquire ();
+      if (!_instance)
+          _instance = new TimeMonitor;
+      g_time_mutex.release ();
+   }
  
    return _instance;
 }
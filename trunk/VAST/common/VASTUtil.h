@@ -31,6 +31,7 @@
 
 #include "Config.h"
 #include "VASTTypes.h"
+#include "BinaryLog.h"          // log levels
 
 #include <string>
 #include <map>
@@ -43,6 +44,11 @@ using namespace std;
 //const long MICROSECOND_PERSEC = 1000000;
 #define MICROSECOND_PERSEC (1000000)
 
+#define LOG_BINARY_FILE_                // log file keeps binary records, read with log_decoder (remove '_' to enable), otherwise decoded text
+#define LOG_ASYNC_DRAIN_                // write out log records in a background thread (remove '_' to enable), otherwise by the logging thread right away
+#define LOG_RING_SIZE       (65536)     // size of each thread's buffer of pending log records (bytes, power of 2)
+#define LOG_DRAIN_INTERVAL  (10)        // # of milliseconds between writing out pending log records
+
 // forward declaration
 
 //class EXPORT errout;
@@ -149,20 +155,39 @@ public:
     size_t compress (uint8_t *source, uint8_t *dest, size_t size);
 };
 
-// refer to: http://www.yolinux.com/TUTORIALS/C++Singleton.html
-class EXPORT LogManager
-{
-
-public:
-
-    // get & end global instance of LogManager
+class LogBackend;
+
+// refer to: http://www.yolinux.com/TUTORIALS/C++Singleton.html
+//
+// NOTE: records are copied into a per-thread buffer by the caller, with LOG_ASYNC_DRAIN
+//       formatting & output to file/stdout is done by a background thread (so log output
+//       may appear out of order with plain printf), pending records are written out at exit
+class EXPORT LogManager
+{
+
+public:
+
+    // get & end global instance of LogManager
 	static LogManager* instance ();
     static void terminateInstance ();
 
 	bool setLogFile (FILE *fp);
 	//bool writeLogFile (const char *str);
     bool writeLogFile (const char *format, ...);
-	bool unsetLogFile ();
+	bool unsetLogFile ();
+
+    // log with a specific level (writeLogFile logs at LOG_LEVEL_INFO)
+    bool writeLog (int level, const char *format, ...);
+
+    // set the minimal level to be logged (LOG_LEVEL_NONE disables logging)
+    void setLogLevel (int level);
+    int  getLogLevel ();
+
+    // write out all pending records
+    void flush ();
+
+    // # of records dropped so far (as they could not be buffered)
+    long getDropped ();
 
 
     // open a file, appending a numerical postfix 
@@ -184,7 +209,11 @@ public:
 
             if ((fp = fopen (filename, "rt")) == NULL)
             {
-                if ((fp = fopen (filename, "w+t")) == NULL)                    
+#ifdef LOG_BINARY_FILE
+                if ((fp = fopen (filename, "w+b")) == NULL)
+#else
+                if ((fp = fopen (filename, "w+t")) == NULL)
+#endif                    
                     printf ("cannot open log file '%s', may not have write access to current directory\n", filename);
             }
             else
@@ -213,14 +242,17 @@ public:
 
 private:
     // Private so that it can  not be called
-	LogManager ()
-    {
-        _logfile = NULL;
-    };    
+	LogManager ();
+    ~LogManager ();
+
+    // write out pending records when the process exits without calling terminateInstance ()
+    static void flushAtExit ();
 
 	//LogManager (LogManager const&){};             // copy constructor is private
 	//LogManager& operator=(LogManager const&){};  // assignment operator is private
     FILE *_logfile;          // pointer to logfile
+    int   _level;            // minimal level to log
+    LogBackend *_backend;    // buffers & background thread for writing records
 
     // global instance for supporting singleton
 	static LogManager* _instance;
@@ -235,6 +267,8 @@ private:
 // it uses the Singleton Design Pattern as described in:
 // http://en.wikipedia.org/wiki/Singleton_pattern#C.2B.2B
 //
+// NOTE: the budget is kept per thread, so several threads may tick VAST nodes at once
+//
 class EXPORT TimeMonitor 
 {
 public:
@@ -247,6 +281,9 @@ public:
     //     (-1) for unlimited time
     int available ();
 
+    // get current time (in microseconds, 10^-6), useful for measuring elapsed time
+    unsigned long long getTime ();
+
     // return a global instance of TimeMonitor
     static TimeMonitor *instance ();
 
@@ -257,13 +294,51 @@ private:
 
     // private so it cannot be called outside
     TimeMonitor ();
-    //~TimeMonitor () {}
+    ~TimeMonitor ();
 
     static TimeMonitor *_instance;   // static instance of the class
 
-    long long _budget;              // time left in current budget
-    unsigned long long _start;      // start time of setting the budget
-    bool               _first;      // budget has just been set
+    void *_budgets;                 // budget of each thread (ACE_TSS<TimeBudget>)
+};
+
+//
+// A small random number generator (xorshift32) keeping its own state, 
+// for repeatable sequences that neither affect nor depend on the shared rand () stream
+//
+class RandomGenerator
+{
+public:
+
+    RandomGenerator (uint32_t seed = 37)
+    {
+        setSeed (seed);
+    }
+
+    // restart the sequence from a seed
+    void setSeed (uint32_t seed)
+    {
+        // the state can never be 0
+        _state = (seed != 0 ? seed : 37);
+    }
+
+    // get the next random integer
+    uint32_t next ()
+    {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    // get the next random number in [0, 1)
+    double nextDouble ()
+    {
+        return (double)next () / 4294967296.0;
+    }
+
+private:
+
+    uint32_t _state;
 };
 
 
@@ -43,8 +43,10 @@
 #include "VASTRelay.h"      // provides physical coordinate, IP address, and public IP
 #include "VASTCallback.h"   // callback for handling incoming message at a VAST node
 #include "VASTnet.h"
+#include "Profiler.h"      // per-tick profiling of network & handlers
 
 #define VASTVERSE_RETRY_PERIOD  (10)     // # of seconds if we're stuck in a state, revert to the previous
+#define VASTHOST_WHEEL_SLOTS    (10)     // # of slots a tick period is divided into, hosted VASTVerse are spread over the slots
 
 namespace Vast
 {
@@ -79,19 +81,15 @@ namespace Vast
         Position        matcher_coord;  // default matcher join coordinate (optional)        
         int             client_limit;   // max number of clients connectable to this relay
         int             relay_limit;    // max number of relays each node maintains
-        int             overload_limit; // max number of subscriptions at each matcher
+        int             overload_limit; // max number of subscriptions at each matcher (0 turns off load balancing)
         int             conn_limit;     // connection limit
-        size_t          send_quota;     // upload quota (bandwidth limit)
-        size_t          recv_quota;     // download quota (bandwidth limit)        
+        size_t          send_quota;     // upload quota (bandwidth limit, also used to determine matcher loading)
+        size_t          recv_quota;     // download quota (bandwidth limit, also used to determine matcher loading)        
     };
 
-    struct VASTPara_Sim
-    {
-        int     step_persec;    // step/ sec (simulated network layer)
-        int     loss_rate;      // packet loss rate
-        int     fail_rate;      // node fail rate
-        bool    with_latency;   // latency among nodes' connection
-    };
+    class VASTHost;
+
+    // NOTE: VASTPara_Sim is defined in VASTnet.h
 
     // the main factory to create VAST nodes and join the overlay
     //
@@ -117,7 +115,9 @@ namespace Vast
 
         // specify a number of entry points (hostname / IP) to the overlay, 
         // also the network & simulation parameters
-        VASTVerse (bool is_gateway, const string &GWstr, VASTPara_Net *netpara, VASTPara_Sim *simpara, VASTCallback *callback = NULL, int tick_persec = 0);
+        // if 'host' is given, this VASTVerse shares the host's network thread & is ticked by the host
+        // (ACE network model only), in which case 'tick_persec' is not used
+        VASTVerse (bool is_gateway, const string &GWstr, VASTPara_Net *netpara, VASTPara_Sim *simpara, VASTCallback *callback = NULL, int tick_persec = 0, VASTHost *host = NULL);
         ~VASTVerse ();
         
         // NOTE: to run a gateway-like entry point only, there's no need to call
@@ -204,17 +204,32 @@ namespace Vast
 
         // obtain the number of active connections at this node
         int getConnectionSize ();
+
+        // obtain the relative error of this node's physical coordinate, -1 if not available
+        float getCoordinateError ();
 
         // obtain the tranmission size by message type, default is to return all types
         StatType &getSendStat (bool interval_only = false);
         StatType &getReceiveStat (bool interval_only = false);
 
+        // obtain size, queueing delay & latency histograms of a message type, NULL if not yet recorded
+        MessageTypeStat *getMessageTypeStat (msgtype_t msgtype);
+
+        // obtain up to 'limit' remote hosts with the most bytes sent (or received), in descending order
+        int     getTopTalkers (int limit, vector<pair<id_t, size_t> > &list, bool send = true);
+
         // reset stat collection for a particular interval, however, accumulated stat will not be cleared
         void    clearStat ();
 
         // record nodeID on the same host
         void    recordLocalTarget (id_t target);
 
+        // turn on / off profiling of tick () (off by default)
+        void    enableProfiling (bool enable);
+
+        // obtain the profiler for querying or dumping the recorded stats
+        Profiler *getProfiler ();
+
         //
         // misc tools
         //
@@ -231,6 +246,23 @@ namespace Vast
         VAST *   createClient (const IPaddr &gateway, world_t world_id);
         bool     destroyClient (VAST *node);
 
+        //
+        // for event-driven ticking by VASTThread
+        //
+
+        // process network input only (without the callback's per-tick & per-second tasks)
+        void     processInput (int time_budget);
+
+        // pass incoming socket & VAST messages to the callback
+        void     deliverMessages ();
+
+        // wait until network input arrives or 'timeout' (in microseconds) passes
+        // returns 1 for input available, 0 for timeout, (-1) if waiting is not supported
+        int      waitInput (int timeout);
+
+        // send out messages queued since the last flush
+        void     flushOutput ();
+
         // obtain & destory a Voronoi object
         //Voronoi *createVoronoi ();
         //bool     destroyVoronoi (Voronoi *v);
@@ -261,6 +293,43 @@ namespace Vast
         size_t              _lastrecv;      // last accumulated recv bytes
     };
 
+    // runs many VASTVerse in one process (e.g. bot farms or relays serving many clients)
+    //
+    // instead of each VASTVerse having a network thread and a ticking thread of its own,
+    // all VASTVerse created with the host have their sockets handled by one shared reactor thread,
+    // and are ticked by a small pool of threads driven by one timer wheel: each VASTVerse is placed in 
+    // a slot of the tick period (so wakeups are spread out) and always ticked by the same thread.
+    // each VASTVerse still has its own ID, message handlers and connections.
+    //
+    // NOTE: callbacks of hosted VASTVerse are called from the host's threads,
+    //       a VASTVerse should not be deleted from within its own callbacks,
+    //       and all hosted VASTVerse should be deleted before the host
+    class EXPORT VASTHost
+    {
+    friend class VASTVerse;
+
+    public:
+
+        // 'tick_persec' is how often each hosted VASTVerse is ticked, 
+        // 'num_threads' is the number of threads ticking them
+        VASTHost (int tick_persec, int num_threads = 1);
+        ~VASTHost ();
+
+        // number of VASTVerse currently hosted
+        size_t getSize ();
+
+    private:
+
+        // add / remove a VASTVerse to be ticked, called by VASTVerse
+        void attach (VASTVerse *world);
+        void detach (VASTVerse *world);
+
+        // obtain the shared reactor for the network layer (created when first needed)
+        net_ace_reactor *getReactor ();
+
+        void               *_pointers;      // internal states (VASTHostPointer)
+    };
+
 } // end namespace Vast
 
 #endif // VASTVerse_h
@@ -33,8 +33,10 @@
 
 #include "VASTTypes.h"
 #include "net_manager.h"     // for keeping sockets
+#include "Histogram.h"       // for per message type stats
 #include <map>
 #include <vector>
+#include <set>
 
 #define GATEWAY_DEFAULT_PORT    (1037)          // default port for gateway
 
@@ -51,8 +53,22 @@
 // # of seconds before an ID request is sent
 #define TIMEOUT_ID_REQUEST          (5)
 
+// # of seconds without sending anything to a kept-alive host before a heartbeat is sent
+#define LIVENESS_HEARTBEAT_INTERVAL (2)
+
+// # of seconds a host is kept alive after the last keepAlive () call
+#define LIVENESS_KEEP_PERIOD        (10)
+
+// # of seconds to wait for an outgoing connection to be established
+#define TIMEOUT_CONNECT             (3)
+
+// # of seconds before connecting again to a host whose last connection attempt failed
+#define TIMEOUT_CONNECT_RETRY       (2)
+
 namespace Vast {
 
+    class net_ace_reactor;
+
     // currently supported VASTnet implementions 
     typedef enum 
     {
@@ -144,6 +160,45 @@ namespace Vast {
         Message     *_msg;
     };
 
+    // sizes & times recorded for a message type
+    class MessageTypeStat
+    {
+    public:
+        Histogram   send_size;      // size of sent messages (bytes, including VASTHeader)
+        Histogram   recv_size;      // size of received messages (bytes, including VASTHeader)
+        Histogram   queue_delay;    // time a sent message waits until flush () (microseconds, needs VASTNET_RECORD_QUEUE_DELAY)
+        Histogram   latency;        // time from sending at remote host until received (timestamps, needs VASTNET_RECORD_LATENCY)
+    };
+
+    // traffic exchanged with a remote host
+    class PeerStat
+    {
+    public:
+        PeerStat ()
+            : send_size (0), recv_size (0), send_count (0), recv_count (0)
+        {
+        }
+
+        size_t  send_size;
+        size_t  recv_size;
+        size_t  send_count;
+        size_t  recv_count;
+    };
+
+    // liveness of a remote host, shared by all layers using the same VASTnet
+    class PeerLiveness
+    {
+    public:
+        PeerLiveness ()
+            : last_send (0), last_recv (0), keep_until (0)
+        {
+        }
+
+        timestamp_t last_send;      // last time anything is sent to the host
+        timestamp_t last_recv;      // last time anything is received from the host
+        timestamp_t keep_until;     // time until which heartbeats are sent when idle
+    };
+
     // common message types
     typedef enum
     {
@@ -154,12 +209,37 @@ namespace Vast {
 
     } VASTHeaderType;
 
+    // NOTE: header types are stored in the 2-bit VASTHeader::type, a new type must not exceed 3
+    typedef char VASTHeaderType_fits_header [(REGULAR <= 3) ? 1 : -1];
+
+    // content of a REGULAR message telling the remote host an idle connection is being closed
+    // (to stay within the connection limit), so no DISCONNECT is reported for it at either end
+    // NOTE: a REGULAR message without content is a heartbeat, & any actual Message is larger than the marker
+    const uint32_t VASTNET_CLOSE_MARKER = 0x434C4F53;   // "CLOS"
+
+    // simulation parameters (emulated network only)
+    // NOTE: the emulated network of a process is shared, so only the first VASTnet created sets
+    //       loss rate, seed, latency model & file, while link capacities are set for each host
+    struct VASTPara_Sim
+    {
+        int     step_persec;    // step/ sec (simulated network layer)
+        int     loss_rate;      // packet loss rate
+        int     fail_rate;      // node fail rate
+        bool    with_latency;   // latency among nodes' connection (also bandwidth & jitter), otherwise each message takes one step
+        int     seed;           // random seed of the emulated network (same seed gives same results)
+        size_t  uplink;         // uplink capacity of this host (bytes / sec), 0 for default
+        size_t  downlink;       // downlink capacity of this host (bytes / sec), 0 for default
+        const char *latency_file;   // matrix of one-way latencies (ms) among hosts, NULL for random host coordinates (kept until the network is created)
+    };
+
     // definition of main VAST network functions
     class EXPORT VASTnet
     {
     public:
 
-        VASTnet (VAST_NetModel model, unsigned short port, int steps_persec);
+        // 'reactor' is a socket reactor shared with other VASTnet in the same process (ACE model only), optional
+        // 'simpara' configures the emulated network (emulated model only), optional
+        VASTnet (VAST_NetModel model, unsigned short port, int steps_persec, net_ace_reactor *reactor = NULL, VASTPara_Sim *simpara = NULL);
         ~VASTnet ();
 
         // 
@@ -231,6 +311,9 @@ namespace Vast {
         // return whether this host has public IP or not
         bool isPublic ();
 
+        // get the network model in use
+        VAST_NetModel getModel ();
+
         // if I'm an entry point on the overlay
         bool isEntryPoint (id_t id);
 
@@ -247,6 +330,7 @@ namespace Vast {
 
         // check if a target is connected as a VAST message channel, 
         // and attempt to connect if not (send handshake afterwards)
+        // messages to a host still being connected are queued until the connection completes
         bool validateConnection (id_t id);
 
         // perform ticking at logical clock (only useful in simulated network)
@@ -262,6 +346,10 @@ namespace Vast {
         // set bandwidth limitation to this network interface (limit is in Kilo bytes / second)
         void setBandwidthLimit (bandwidth_t type, size_t limit);
 
+        // set max # of connections kept open (0 for no limit), 
+        // the least recently used connections are closed to make room for new ones
+        void setConnectionLimit (size_t limit);
+
         // get how many timestamps (as returned by getTimestamp) is in a second 
         timestamp_t getTimestampPerSecond ();
 
@@ -298,6 +386,37 @@ namespace Vast {
         // zero out send / recv size records
         void resetTransmissionSize ();
 
+        // obtain size, queueing delay & latency histograms of a message type, NULL if not yet recorded
+        MessageTypeStat *getMessageTypeStat (msgtype_t msgtype);
+
+        // obtain the message types recorded so far
+        void getMessageTypes (std::vector<msgtype_t> &list);
+
+        // obtain up to 'limit' remote hosts with the most bytes sent (or received), in descending order
+        // returns the # of hosts found
+        int getTopTalkers (int limit, std::vector<std::pair<id_t, size_t> > &list, bool send = true);
+
+        // obtain the # of complete incoming messages not yet processed
+        size_t getQueueSize ();
+
+        // wait until incoming messages are available or 'timeout' (in microseconds) passes
+        // returns 1 if messages are available, 0 for timeout, (-1) if waiting is not supported
+        int waitInput (int timeout);
+
+        //
+        // liveness of remote hosts (any message received counts)
+        //
+
+        // let a remote host know that we're alive for the next LIVENESS_KEEP_PERIOD seconds,
+        // a heartbeat is sent only when nothing else has been sent to it for LIVENESS_HEARTBEAT_INTERVAL
+        void keepAlive (id_t host);
+
+        // last time anything is received from a remote host, 0 if never
+        timestamp_t getLastReceived (id_t host);
+
+        // whether anything is received from a remote host within the last 'period' seconds
+        bool isAlive (id_t host, double period);
+
         // record which other IDs belong to the same host
         // TODO: added due to the two networks / host design in VASTATE
         //       a cleaner way?
@@ -354,10 +473,26 @@ namespace Vast {
         // periodic cleanup of inactive connections
         void cleanConnections ();
 
+        // check outgoing connections being established, remove those failed or timed out
+        void checkConnecting (timestamp_t now);
+
+        // close the least recently used idle connection to make room for a new one
+        // returns false if no connection can be closed
+        bool evictConnection (timestamp_t now);
+
+        // # of connections counted towards the limit (including those being made, excluding those being closed)
+        size_t countConnections ();
+
         // update send/recv size statistics
         // type: 1 = send, type: 2 = receive
         void updateTransmissionStat (id_t target, msgtype_t msgtype, size_t total_size, int type);
 
+        // whether a remote host's timestamps can be compared with ours (emulated, or on the same machine)
+        bool isSameClock (id_t host);
+
+        // queue heartbeats (a header without message) to kept-alive hosts that are idle
+        void sendHeartbeats (timestamp_t now);
+
         // 
         // member variables
         //
@@ -395,6 +530,7 @@ namespace Vast {
         std::vector<NetSocketMsg *>         _socket_queue;      // queue for incoming socket messages
         Message *                           _recvmsg;           // received VAST message
         NetSocketMsg *                      _recvmsg_socket;    // received socket message
+        std::map<id_t, Addr>                _conn_list;         // active connections returned by getConnections ()
 
         // TODO: combine the TCP & UDP buffers?
         // outgoing queues
@@ -413,7 +549,25 @@ namespace Vast {
         std::map<msgtype_t, size_t>     _type2sendsize,
                                         _type2recvsize;
 
+        // size, queueing delay & latency histograms by type
+        std::map<msgtype_t, MessageTypeStat>    _type2stat;
+
+        // traffic by remote host
+        std::map<id_t, PeerStat>        _peer2stat;
+
+        // type & time of messages sent but not yet flushed (with VASTNET_RECORD_QUEUE_DELAY)
+        std::vector<std::pair<msgtype_t, unsigned long long> > _pending_sends;
+
         std::map<id_t, bool>            _local_targets;     // send/receive targets on the same host
+
+        // liveness of remote hosts
+        std::map<id_t, PeerLiveness>    _liveness;
+
+        // outgoing connections
+        std::map<id_t, timestamp_t>     _connecting;        // hosts being connected & the time connection started
+        std::map<id_t, timestamp_t>     _connect_retry;     // hosts failed to connect & the earliest time to try again
+        size_t                          _conn_limit;        // max # of connections (0 for no limit)
+        std::set<id_t>                  _closing;           // hosts whose connection is closed by evictConnection () (by either end)
     };
 
 } // end namespace Vast
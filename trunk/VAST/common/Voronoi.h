@@ -34,6 +34,21 @@
 
 namespace Vast {
 
+    // a site evaluated as if it were inserted into the diagram, without inserting it (see Voronoi::evaluate ())
+    class EXPORT VoronoiProbe
+    {
+    public:
+        id_t                id;
+        Position            coord;
+        length_t            radius;         // radius of a circle around the site, checked against the owner's region
+
+        // results
+        bool                enclosing;      // whether the site would be an enclosing neighbor of the owner
+        bool                overlaps;       // whether the site's region would overlap the owner's circle
+        bool                overlapped;     // whether the owner's region would overlap the site's circle
+        std::vector<id_t>   en;             // enclosing neighbors the site would have
+    };
+
     class EXPORT Voronoi
     {
     public:
@@ -71,6 +86,38 @@ namespace Vast {
         // remove all sites in the diagram
         virtual void clear () = 0;
 
+        // set the weight of a site (for weighted diagrams, a larger weight means a larger region)
+        // returns false if weights are not supported
+        virtual bool setWeight (id_t id, double weight) 
+        {
+            return false;
+        }
+
+        // evaluate a batch of sites (not in the diagram) as if they were all inserted, without keeping them
+        // 'owner' is an existing site with a circle of 'radius' around it, 
+        // overlap checks are as in overlaps ()
+        virtual void evaluate (id_t owner, length_t radius, std::vector<VoronoiProbe> &probes, bool accurate_mode = false)
+        {
+            // by default the sites are simply inserted & removed again
+            size_t i;
+            for (i=0; i < probes.size (); i++)
+                insert (probes[i].id, probes[i].coord);
+
+            Position center = get (owner);
+
+            for (i=0; i < probes.size (); i++)
+            {
+                VoronoiProbe &probe = probes[i];
+                probe.enclosing  = is_enclosing (probe.id, owner);
+                probe.overlaps   = overlaps (probe.id, center, radius, accurate_mode);
+                probe.overlapped = overlaps (owner, probe.coord, probe.radius, accurate_mode);
+                probe.en         = get_en (probe.id);
+            }
+
+            for (i=0; i < probes.size (); i++)
+                remove (probes[i].id);
+        }
+
         //
         // non Voronoi-specific methods
         //
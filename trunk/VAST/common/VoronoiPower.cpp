@@ -0,0 +1,527 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "VoronoiPower.h"
+
+namespace Vast
+{
+
+// clip a convex region by the half-plane (ax * x + ay * y <= b),
+// new edges along the clipping line are labeled with 'label'
+static void
+clipCell (vector<PowerVertex> &cell, double ax, double ay, double b, int label)
+{
+    vector<PowerVertex> result;
+    size_t n = cell.size ();
+
+    for (size_t k=0; k < n; k++)
+    {
+        PowerVertex &p = cell[k];
+        PowerVertex &q = cell[(k+1) % n];
+
+        double dp = ax * p.x + ay * p.y - b;
+        double dq = ax * q.x + ay * q.y - b;
+
+        if (dp <= 0)
+            result.push_back (p);
+
+        // edge crosses the clipping line
+        if ((dp <= 0) != (dq <= 0))
+        {
+            double t = dp / (dp - dq);
+
+            PowerVertex v;
+            v.x = p.x + t * (q.x - p.x);
+            v.y = p.y + t * (q.y - p.y);
+
+            // leaving the half-plane, the next edge runs along the clipping line
+            v.edge = (dp <= 0 ? label : p.edge);
+            result.push_back (v);
+        }
+    }
+
+    cell = result;
+}
+
+VoronoiPower::
+VoronoiPower (double default_weight)
+    :_invalidated (false),
+     _default_weight (default_weight)
+{
+    _box[0] = _box[1] = _box[2] = _box[3] = 0;
+}
+
+VoronoiPower::
+~VoronoiPower ()
+{
+}
+
+// insert a new site, the first inserted is myself
+void
+VoronoiPower::
+insert (id_t id, const Position &pt)
+{
+    // avoid duplicate insert
+    if (get_idx (id) == -1)
+    {
+        _invalidated = true;
+        _sites.push_back (pair<id_t, Position> (id, pt));
+    }
+}
+
+// remove a site
+void
+VoronoiPower::
+remove (id_t id)
+{
+    int idx = get_idx (id);
+    if (idx != -1)
+    {
+        _invalidated = true;
+        _sites.erase (_sites.begin () + idx);
+    }
+}
+
+// modify the coordinates of a site
+void
+VoronoiPower::
+update (id_t id, const Position &pt)
+{
+    int idx = get_idx (id);
+    if (idx != -1)
+    {
+        _invalidated = true;
+        _sites[idx].second = pt;
+    }
+}
+
+// get the point of a site
+Position
+VoronoiPower::
+get (id_t id)
+{
+    int idx = get_idx (id);
+    if (idx == -1)
+        return Position ();
+
+    return _sites[idx].second;
+}
+
+// check if a point lies inside a particular region
+bool
+VoronoiPower::
+contains (id_t id, const Position &pt)
+{
+    int idx = get_idx (id);
+    if (idx == -1)
+        return false;
+
+    double d = power (idx, pt.x, pt.y);
+
+    for (int i=0; i < (int)_sites.size (); i++)
+    {
+        if (i != idx && power (i, pt.x, pt.y) < d)
+            return false;
+    }
+
+    return true;
+}
+
+// check if the node is a boundary neighbor
+// (i.e., its region is not fully enclosed by the circle)
+bool
+VoronoiPower::
+is_boundary (id_t id, const Position &pt, length_t radius)
+{
+    int idx = get_idx (id);
+    if (idx == -1)
+        return false;
+
+    recompute ();
+
+    vector<PowerVertex> &cell = _cells[idx];
+    point2d center (pt.x, pt.y);
+
+    for (size_t i=0; i < cell.size (); i++)
+    {
+        // regions reaching the bounding box are unbounded
+        if (cell[i].edge == -1 || center.distance (point2d (cell[i].x, cell[i].y)) >= (double)radius)
+            return true;
+    }
+
+    return false;
+}
+
+// check if the node 'id' is an enclosing neighbor of 'center_node_id'
+bool
+VoronoiPower::
+is_enclosing (id_t id, id_t center_node_id)
+{
+    if (_sites.size () == 0)
+        return false;
+
+    recompute ();
+
+    int idx = (center_node_id == ((id_t)(-1)) ? 0 : get_idx (center_node_id));
+    if (idx == -1)
+        return false;
+
+    std::set<int> neighbors;
+    getCellNeighbors (_cells[idx], neighbors);
+
+    for (std::set<int>::iterator it = neighbors.begin (); it != neighbors.end (); ++it)
+    {
+        if (_sites[*it].first == id)
+            return true;
+    }
+
+    return false;
+}
+
+// get a list of enclosing neighbors, for level > 1 the neighbors found
+// are excluded and the enclosing neighbors are found again
+vector<id_t> &
+VoronoiPower::
+get_en (id_t id, int level)
+{
+    _en_list.clear ();
+
+    int idx = get_idx (id);
+    if (idx == -1)
+        return _en_list;
+
+    recompute ();
+
+    vector<bool> excluded (_sites.size (), false);
+    vector<PowerVertex> cell;
+    std::set<int> neighbors;
+
+    for (int l=0; l < level; l++)
+    {
+        // first level can use the cached region
+        if (l == 0)
+            cell = _cells[idx];
+        else
+            computeCell (idx, cell, &excluded);
+
+        getCellNeighbors (cell, neighbors);
+
+        if (neighbors.size () == 0)
+            break;
+
+        for (std::set<int>::iterator it = neighbors.begin (); it != neighbors.end (); ++it)
+        {
+            _en_list.push_back (_sites[*it].first);
+            excluded[*it] = true;
+        }
+    }
+
+    return _en_list;
+}
+
+// check if a circle overlaps with a particular region
+bool
+VoronoiPower::
+overlaps (id_t id, const Position &pt, length_t radius, bool accurate_mode)
+{
+    int idx = get_idx (id);
+    if (idx == -1)
+        return false;
+
+    // check if the center is inside the region, or the region's site is within the circle
+    if (accurate_mode == false)
+        return (contains (id, pt) || _sites[idx].second.distance (pt) <= (double)radius);
+
+    // accurate mode: center inside the region, or any edge touches the circle
+    if (contains (id, pt))
+        return true;
+
+    recompute ();
+
+    vector<PowerVertex> &cell = _cells[idx];
+    point2d center (pt.x, pt.y);
+
+    for (size_t i=0; i < cell.size (); i++)
+    {
+        PowerVertex &p = cell[i];
+        PowerVertex &q = cell[(i+1) % cell.size ()];
+
+        segment seg (p.x, p.y, q.x, q.y);
+
+        if (center.distance (seg.p1) <= (double)radius || seg.intersects (center, (int)radius))
+            return true;
+    }
+
+    return false;
+}
+
+// remove all sites in the diagram
+void
+VoronoiPower::
+clear ()
+{
+    _sites.clear ();
+    _weights.clear ();
+    _invalidated = true;
+}
+
+// set the weight of a site
+bool
+VoronoiPower::
+setWeight (id_t id, double weight)
+{
+    if (_weights.find (id) == _weights.end () || _weights[id] != weight)
+    {
+        _weights[id] = weight;
+        _invalidated = true;
+    }
+
+    return true;
+}
+
+// get the weight of a site
+double
+VoronoiPower::
+getWeight (id_t id)
+{
+    map<id_t, double>::iterator it = _weights.find (id);
+    return (it == _weights.end () ? _default_weight : it->second);
+}
+
+// returns the closest node to a point, by power distance
+// if two or more sites are equally close, the smallest ID is returned (same as VoronoiSF)
+id_t
+VoronoiPower::
+closest_to (const Position &pt)
+{
+    int n = (int)_sites.size ();
+
+    // error checking
+    if (n == 0)
+        return 0;
+
+    id_t closest = _sites[0].first;
+    double min = power (0, pt.x, pt.y);
+    double d;
+
+    for (int i=1; i < n; i++)
+    {
+        id_t id = _sites[i].first;
+        d = power (i, pt.x, pt.y);
+
+        if (d < min || ((d-min < EQUAL_DISTANCE) && id < closest))
+        {
+            min = d;
+            closest = id;
+        }
+    }
+
+    return closest;
+}
+
+vector<line2d> &
+VoronoiPower::getedges ()
+{
+    recompute ();
+    return _edges;
+}
+
+// obtain the bounding box of all sites
+// returns true if the box exists, false if one of the dimensions is empty
+bool
+VoronoiPower::get_bounding_box (point2d& min, point2d& max)
+{
+    if (_sites.size () == 0)
+        return false;
+
+    min.x = max.x = _sites[0].second.x;
+    min.y = max.y = _sites[0].second.y;
+
+    for (size_t i=1; i < _sites.size (); i++)
+    {
+        Position &p = _sites[i].second;
+        if (p.x < min.x) min.x = p.x;
+        if (p.y < min.y) min.y = p.y;
+        if (p.x > max.x) max.x = p.x;
+        if (p.y > max.y) max.y = p.y;
+    }
+
+    return (max.x > min.x && max.y > min.y);
+}
+
+// get edges of sites with ID = id
+std::set<int> &
+VoronoiPower::get_site_edges (int id)
+{
+    static std::set<int> empty_set;
+
+    int idx = get_idx (id);
+    if (idx == -1)
+        return empty_set;
+
+    recompute ();
+    return _site_edges[idx];
+}
+
+// power distance from a point to a site
+double
+VoronoiPower::power (int idx, double x, double y)
+{
+    Position &p = _sites[idx].second;
+    double dx = x - p.x;
+    double dy = y - p.y;
+
+    return dx*dx + dy*dy - getWeight (_sites[idx].first);
+}
+
+// compute the region of a site by clipping the bounding box with power bisectors
+void
+VoronoiPower::computeCell (int idx, vector<PowerVertex> &cell, vector<bool> *excluded)
+{
+    cell.clear ();
+
+    // start with the bounding box (counter-clockwise)
+    PowerVertex v;
+    v.edge = -1;
+    v.x = _box[0]; v.y = _box[1]; cell.push_back (v);
+    v.x = _box[2]; v.y = _box[1]; cell.push_back (v);
+    v.x = _box[2]; v.y = _box[3]; cell.push_back (v);
+    v.x = _box[0]; v.y = _box[3]; cell.push_back (v);
+
+    Position &pi = _sites[idx].second;
+    double wi = getWeight (_sites[idx].first);
+
+    for (int j=0; j < (int)_sites.size () && cell.size () > 0; j++)
+    {
+        if (j == idx || (excluded != NULL && (*excluded)[j]))
+            continue;
+
+        Position &pj = _sites[j].second;
+        double wj = getWeight (_sites[j].first);
+
+        // |x - pi|^2 - wi <= |x - pj|^2 - wj  =>  2 (pj - pi) . x <= |pj|^2 - wj - |pi|^2 + wi
+        double ax = 2 * ((double)pj.x - pi.x);
+        double ay = 2 * ((double)pj.y - pi.y);
+        double b  = ((double)pj.x * pj.x + (double)pj.y * pj.y - wj) - ((double)pi.x * pi.x + (double)pi.y * pi.y - wi);
+
+        // sites at the same position: the one with smaller weight has no region
+        if (ax == 0 && ay == 0)
+        {
+            if (b < 0)
+                cell.clear ();
+            continue;
+        }
+
+        clipCell (cell, ax, ay, b, j);
+    }
+}
+
+// collect the sites forming edges of a region (ignoring degenerated edges)
+void
+VoronoiPower::getCellNeighbors (vector<PowerVertex> &cell, std::set<int> &neighbors)
+{
+    neighbors.clear ();
+
+    size_t n = cell.size ();
+    for (size_t k=0; k < n; k++)
+    {
+        PowerVertex &p = cell[k];
+        PowerVertex &q = cell[(k+1) % n];
+
+        if (p.edge != -1 && (fabs (p.x - q.x) > EQUAL_DISTANCE || fabs (p.y - q.y) > EQUAL_DISTANCE))
+            neighbors.insert (p.edge);
+    }
+}
+
+// re-compute all regions & edges if sites have changed
+void
+VoronoiPower::recompute ()
+{
+    if (_invalidated == false)
+        return;
+
+    _invalidated = false;
+
+    int n = (int)_sites.size ();
+
+    _cells.clear ();
+    _edges.clear ();
+    _site_edges.clear ();
+
+    _cells.resize (n);
+    _site_edges.resize (n);
+
+    if (n == 0)
+        return;
+
+    // determine a bounding box large enough to contain all bounded regions
+    point2d min, max;
+    get_bounding_box (min, max);
+
+    double margin = ((max.x - min.x) + (max.y - min.y)) * 100 + VORONOI_POWER_BOX_MARGIN;
+    _box[0] = min.x - margin;
+    _box[1] = min.y - margin;
+    _box[2] = max.x + margin;
+    _box[3] = max.y + margin;
+
+    int i;
+    for (i=0; i < n; i++)
+        computeCell (i, _cells[i]);
+
+    // record each edge once (from the site with smaller index)
+    for (i=0; i < n; i++)
+    {
+        vector<PowerVertex> &cell = _cells[i];
+        size_t m = cell.size ();
+
+        for (size_t k=0; k < m; k++)
+        {
+            PowerVertex &p = cell[k];
+            PowerVertex &q = cell[(k+1) % m];
+
+            if (p.edge == -1 || p.edge < i)
+                continue;
+
+            line2d line (p.x, p.y, q.x, q.y);
+            line.bisecting[0] = i;
+            line.bisecting[1] = p.edge;
+            line.vertexIndex[0] = line.vertexIndex[1] = -1;
+
+            int edge_idx = (int)_edges.size ();
+            _edges.push_back (line);
+            _site_edges[i].insert (edge_idx);
+            _site_edges[p.edge].insert (edge_idx);
+        }
+    }
+}
+
+int
+VoronoiPower::get_idx (id_t id)
+{
+    int n = (int)_sites.size ();
+    for (int i=0; i < n; i++)
+    {
+        if (_sites[i].first == id)
+            return i;
+    }
+    return -1;
+}
+
+} // namespace Vast
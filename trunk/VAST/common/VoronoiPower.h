@@ -0,0 +1,152 @@
+/*
+ * VAST, a scalable peer-to-peer network for virtual environments
+ * Copyright (C) 2005-2011 Shun-Yun Hu (syhu@ieee.org)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ *  VoronoiPower.h -- power (weighted) Voronoi diagram
+ *
+ *      a point x belongs to the site i with the smallest power distance |x - p_i|^2 - w_i,
+ *      so a site with larger weight covers a larger region without moving its position.
+ *      with all weights equal, the diagram is identical to the ordinary Voronoi diagram.
+ *
+ *      each region is computed by clipping a large bounding box with the power bisectors
+ *      of all other sites, which is O(n) per region and fine for the # of neighbors a VON node keeps
+ */
+
+#ifndef VAST_VORONOI_POWER_H
+#define VAST_VORONOI_POWER_H
+
+#include "VASTTypes.h"
+#include "Voronoi.h"
+#include <vector>
+#include <map>
+
+#define VORONOI_POWER_BOX_MARGIN    (1000000)   // margin of the box bounding all regions (nearly collinear hull sites meet far away)
+
+using namespace std;
+
+namespace Vast {
+
+// a vertex of a region's polygon, 'edge' is the index of the site whose bisector forms
+// the edge starting at this vertex (-1 for edges of the bounding box)
+struct PowerVertex
+{
+    double  x;
+    double  y;
+    int     edge;
+};
+
+class VoronoiPower : public Voronoi
+{
+
+public:
+    // 'default_weight' is the weight of sites whose weight is never set
+    VoronoiPower (double default_weight = 0);
+    ~VoronoiPower ();
+
+    // insert a new site, the first inserted is myself
+    void insert (id_t id, const Position &coord);
+
+    // remove a site
+    void remove (id_t id);
+
+    // modify the coordinates of a site
+    void update (id_t id, const Position &coord);
+
+    // get the point of a site
+    Position get (id_t id);
+
+    // check if a point lies inside a particular region
+    bool contains (id_t id, const Position &coord);
+
+    // check if the node is a boundary neighbor
+    bool is_boundary (id_t id, const Position &center, length_t radius);
+
+    // check if the node is an enclosing neighbor
+    bool is_enclosing (id_t id, id_t center_node_id = ((id_t)-1));
+
+    // get a list of enclosing neighbors
+    vector<id_t> &get_en (id_t id, int level = 1);
+
+    // check if a circle overlaps with a particular region
+    bool overlaps (id_t id, const Position &center, length_t radius, bool accurate_mode = false);
+
+    // remove all sites in the diagram
+    void clear ();
+
+    // set the weight of a site (kept even if the site is removed & inserted again)
+    bool setWeight (id_t id, double weight);
+
+    // get the weight of a site ('default_weight' if not set)
+    double getWeight (id_t id);
+
+    //
+    // non Voronoi-specific methods
+    //
+
+    // returns the closest node to a point (by power distance)
+    id_t closest_to (const Position &pt);
+
+    std::vector<line2d> &getedges();
+
+    // obtain the bounding box for this Voronoi object
+    // returns true if the box exists, false if one of the dimensions is empty
+    bool get_bounding_box (point2d& min, point2d& max);
+
+    // get the number of sites currently maintained
+    int size ()
+    {
+        return (int)_sites.size ();
+    }
+
+    // get edges of sites with ID = id
+    std::set<int> & get_site_edges (int id);
+
+private:
+
+    // power distance from a point to a site
+    double power (int idx, double x, double y);
+
+    // compute the region of a site, optionally excluding some sites (for get_en beyond 1st level)
+    void computeCell (int idx, vector<PowerVertex> &cell, vector<bool> *excluded = NULL);
+
+    // collect the sites forming edges of a region
+    void getCellNeighbors (vector<PowerVertex> &cell, std::set<int> &neighbors);
+
+    // re-compute all regions & edges if sites have changed
+    void recompute ();
+
+    int get_idx (id_t id);
+
+    bool                        _invalidated;   // whether the regions need to be re-computed
+    vector<pair<id_t, Position> > _sites;       // list of sites
+    map<id_t, double>           _weights;       // weights of sites
+    double                      _default_weight;// weight of sites not in _weights
+    double                      _box[4];        // bounding box for all regions (min x, min y, max x, max y)
+
+    vector<vector<PowerVertex> > _cells;        // region of each site
+    vector<line2d>              _edges;         // edges of all regions
+    vector<std::set<int> >      _site_edges;    // edge indices of each site
+
+    vector<id_t>                _en_list;
+};
+
+} // end namespace Vast
+
+#endif // VAST_VORONOI_POWER_H
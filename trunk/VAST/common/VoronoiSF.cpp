@@ -19,6 +19,7 @@
  */
 
 #include "VoronoiSF.h"
+#include <algorithm>    // sort
 
 namespace Vast
 {
@@ -394,6 +395,236 @@ VoronoiSF::get_bounding_box (point2d& min, point2d& max)
     return _Voronoi.getBoundingBox (min, max);
 }
 
+// evaluate a batch of sites as if they were all inserted,
+// regions of the probes & the owner are computed directly by clipping half-planes,
+// so the diagram (and its later rebuilt after the probes are removed) is avoided
+void 
+VoronoiSF::
+evaluate (id_t owner, length_t radius, vector<VoronoiProbe> &probes, bool accurate_mode)
+{
+    size_t i, j;
+
+    // all points, existing sites first
+    _probe_pts.clear ();
+    _probe_ids.clear ();
+    for (i=0; i < _sites.size (); i++)
+    {
+        _probe_pts.push_back (point2d (_sites[i].second.x, _sites[i].second.y));
+        _probe_ids.push_back (_sites[i].first);
+    }
+    
+    vector<int> index (probes.size ());
+    for (i=0; i < probes.size (); i++)
+    {
+        // an existing site is evaluated as it is (same as insert ())
+        if ((index[i] = get_idx (probes[i].id)) == -1)
+        {
+            index[i] = _probe_pts.size ();
+            _probe_pts.push_back (point2d (probes[i].coord.x, probes[i].coord.y));
+            _probe_ids.push_back (probes[i].id);
+        }
+    }
+
+    if (_probe_pts.size () == 0)
+        return;
+
+    // a box large enough to contain all vertices that matter
+    _box_min = _probe_pts[0];
+    _box_max = _probe_pts[0];
+    for (i=1; i < _probe_pts.size (); i++)
+    {
+        point2d &pt = _probe_pts[i];
+        if (pt.x < _box_min.x) _box_min.x = pt.x;
+        if (pt.y < _box_min.y) _box_min.y = pt.y;
+        if (pt.x > _box_max.x) _box_max.x = pt.x;
+        if (pt.y > _box_max.y) _box_max.y = pt.y;
+    }
+    double margin = ((_box_max.x - _box_min.x) + (_box_max.y - _box_min.y)) * 1000 + 1000;
+    _box_min.x -= margin;   _box_min.y -= margin;
+    _box_max.x += margin;   _box_max.y += margin;
+
+    int owner_idx = get_idx (owner);
+    point2d owner_pt;
+    if (owner_idx != -1)
+    {
+        owner_pt = _probe_pts[owner_idx];
+        clip_region (owner_idx, _owner_poly, _owner_edges);
+    }
+
+    vector<int> en;
+    for (i=0; i < probes.size (); i++)
+    {
+        VoronoiProbe &probe = probes[i];
+        point2d &pt = _probe_pts[index[i]];
+
+        clip_region (index[i], _poly, _edges);
+
+        // sites sharing an edge (not just a corner) are the enclosing neighbors
+        en.clear ();
+        for (j=0; j < _poly.size (); j++)
+        {
+            if (_edges[j] >= 0 && _poly[j].distance (_poly[(j+1) % _poly.size ()]) > EQUAL_DISTANCE)
+                en.push_back (_edges[j]);
+        }
+        std::sort (en.begin (), en.end ());
+        en.erase (std::unique (en.begin (), en.end ()), en.end ());
+
+        probe.en.clear ();
+        probe.enclosing = false;
+        for (j=0; j < en.size (); j++)
+        {
+            if (en[j] == owner_idx)
+                probe.enclosing = true;
+
+            probe.en.push_back (_probe_ids[en[j]]);
+        }
+
+        if (owner_idx == -1)
+        {
+            probe.overlaps = probe.overlapped = false;
+        }
+        else if (accurate_mode)
+        {
+            probe.overlaps   = region_collides (_poly, _edges, owner_pt, (int)(radius+5));
+            probe.overlapped = region_collides (_owner_poly, _owner_edges, pt, (int)(probe.radius+5));
+        }
+        else
+        {
+            double d = pt.distance (owner_pt);
+            probe.overlaps   = (d <= (double)radius);
+            probe.overlapped = (d <= (double)probe.radius);
+        }
+    }
+}
+
+// compute the region of a site among '_probe_pts' by clipping the bounding box 
+// with bisectors, nearer sites first, until the remaining ones are too far to matter
+void 
+VoronoiSF::
+clip_region (int index, vector<point2d> &poly, vector<int> &edge_site)
+{
+    point2d &p = _probe_pts[index];
+
+    // counter-clockwise, edge k goes from vertex k to k+1
+    poly.clear ();
+    poly.push_back (_box_min);
+    poly.push_back (point2d (_box_max.x, _box_min.y));
+    poly.push_back (_box_max);
+    poly.push_back (point2d (_box_min.x, _box_max.y));
+    edge_site.assign (4, -1);
+
+    _probe_order.clear ();
+    for (int i=0; i < (int)_probe_pts.size (); i++)
+        if (i != index)
+            _probe_order.push_back (pair<double, int> (p.dist_sqr (_probe_pts[i]), i));
+    std::sort (_probe_order.begin (), _probe_order.end ());
+
+    // largest distance from the site to its region
+    double r2 = 0;
+    size_t k;
+    for (k=0; k < poly.size (); k++)
+        if (p.dist_sqr (poly[k]) > r2)
+            r2 = p.dist_sqr (poly[k]);
+
+    for (size_t i=0; i < _probe_order.size (); i++)
+    {
+        // a site at distance d has its bisector at d/2, which cannot cut the region beyond r
+        if (_probe_order[i].first > 4 * r2)
+            break;
+
+        int s = _probe_order[i].second;
+        point2d &q = _probe_pts[s];
+        point2d m ((p.x + q.x) / 2, (p.y + q.y) / 2);
+        double nx = q.x - p.x;
+        double ny = q.y - p.y;
+
+        // keep the side nearer to p: (x - m) . (q - p) <= 0
+        _clipped.clear ();
+        _clipped_edges.clear ();
+        bool cut = false;
+        for (k=0; k < poly.size (); k++)
+        {
+            point2d &a = poly[k];
+            point2d &b = poly[(k+1) % poly.size ()];
+            double da = (a.x - m.x) * nx + (a.y - m.y) * ny;
+            double db = (b.x - m.x) * nx + (b.y - m.y) * ny;
+
+            if (da <= 0)
+            {
+                _clipped.push_back (a);
+                _clipped_edges.push_back (edge_site[k]);
+            }
+            else
+                cut = true;
+
+            // edge crosses the bisector
+            if ((da <= 0) != (db <= 0))
+            {
+                double t = da / (da - db);
+                _clipped.push_back (point2d (a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t));
+                
+                // leaving: the new edge runs along the bisector, entering: along the old edge
+                _clipped_edges.push_back (da <= 0 ? s : edge_site[k]);
+            }
+        }
+
+        if (cut == false)
+            continue;
+
+        poly.swap (_clipped);
+        edge_site.swap (_clipped_edges);
+
+        if (poly.size () == 0)
+            break;
+
+        r2 = 0;
+        for (k=0; k < poly.size (); k++)
+            if (p.dist_sqr (poly[k]) > r2)
+                r2 = p.dist_sqr (poly[k]);
+    }
+}
+
+// whether a region computed by clip_region () overlaps a circle, same checks as sfVoronoi::collides ()
+bool 
+VoronoiSF::
+region_collides (vector<point2d> &poly, vector<int> &edge_site, const point2d &center, int radius)
+{
+    size_t k;
+
+    // case 1: center lies inside the (convex, counter-clockwise) polygon
+    bool inside = (poly.size () > 0);
+    for (k=0; k < poly.size () && inside; k++)
+    {
+        point2d &a = poly[k];
+        point2d &b = poly[(k+1) % poly.size ()];
+        if ((b.x - a.x) * (center.y - a.y) - (b.y - a.y) * (center.x - a.x) < 0)
+            inside = false;
+    }
+    if (inside)
+        return true;
+
+    for (k=0; k < poly.size (); k++)
+    {
+        point2d &a = poly[k];
+        point2d &b = poly[(k+1) % poly.size ()];
+
+        // edges of the bounding box are not part of the diagram
+        if (edge_site[k] < 0)
+            continue;
+
+        // case 2: a vertex lies inside the circle
+        if (a.distance (center) <= (double)radius || b.distance (center) <= (double)radius)
+            return true;
+
+        // case 3: the edge intersects with the circle
+        segment seg (a.x, a.y, b.x, b.y);
+        if (seg.intersects (center, radius))
+            return true;
+    }
+
+    return false;
+}
+
 // get edges of sites with ID = id
 std::set<int> &
 VoronoiSF::get_site_edges (int id)
@@ -72,6 +72,10 @@ public:
     // remove all sites in the diagram
     void clear ();
 
+    // evaluate a batch of sites as if they were all inserted, only the regions of
+    // the sites & the owner are computed, the diagram is not rebuilt
+    void evaluate (id_t owner, length_t radius, vector<VoronoiProbe> &probes, bool accurate_mode = false);
+
     //
     // non Voronoi-specific methods
     //
@@ -118,7 +122,22 @@ private:
     int get_idx (id_t h);    
     void recompute();
 
+    // compute the region of a site among '_probe_pts' (clipped by a bounding box),
+    // 'edge_site' is the index of the site sharing each edge (-1 for the box)
+    void clip_region (int index, vector<point2d> &poly, vector<int> &edge_site);
+
+    // whether a region computed by clip_region () overlaps a circle
+    bool region_collides (vector<point2d> &poly, vector<int> &edge_site, const point2d &center, int radius);
+
     vector<id_t> _en_list;
+
+    // buffers for evaluate ()
+    vector<point2d>             _probe_pts;     // existing sites followed by the probes
+    vector<id_t>                _probe_ids;
+    vector<pair<double, int> >  _probe_order;   // other sites sorted by distance
+    vector<point2d>             _poly, _owner_poly, _clipped;
+    vector<int>                 _edges, _owner_edges, _clipped_edges;
+    point2d                     _box_min, _box_max;
 };
 
     
@@ -156,6 +156,22 @@ namespace Vast {
         // get last access time of a connection
         timestamp_t getLastTime (id_t id);
 
+        // get # of active connections
+        virtual size_t getConnectionSize ();
+
+        // get IDs of all active connections (both made & accepted), returns the # of IDs
+        virtual size_t getConnectionIDs (std::vector<id_t> &ids);
+
+        // wait until a message is received or 'timeout' (in microseconds) passes
+        // returns 1 if messages are available, 0 for timeout, (-1) if waiting is not supported
+        virtual int waitInput (int timeout);
+
+        // start connecting a remote node without waiting for it to complete, 
+        // call again with the same target to check the progress
+        // returns 1 if connected, 0 if still connecting, (-1) if failed
+        // by default the connection is made by a blocking connect ()
+        virtual int connectAsync (id_t target, unsigned int host, unsigned short port);
+
         //
         // pure virtual, customizable methods (implementation-specific)
         //   